@@ -0,0 +1,389 @@
+//***************************************************************************//
+//* File Name: blockBatch.hpp                                               *//
+//* Author:    Tom Portegys, portegys@ilstu.edu                             *//
+//* Date Made: 10/17/26                                                     *//
+//* File Desc: Class declaration and implementation details                 *//
+//*            representing a batch of identical blocks drawn together.     *//
+//* Rev. Date:                                                              *//
+//* Rev. Desc:                                                              *//
+//*                                                                         *//
+//***************************************************************************//
+
+#ifndef __BLOCK_BATCH_HPP__
+#define __BLOCK_BATCH_HPP__
+
+#ifndef UNIX
+#include <windows.h>
+#endif
+#include <GL/gl.h>
+#include "physics.h"
+
+// Texture coordinate inset of an atlas tile, about half a texel of a
+// 256 texel tile, so that filtering does not reach into the next tile.
+#define BLOCK_ATLAS_INSET 0.002f
+
+// The block model is kept once in block coordinates. Each frame the
+// blocks to draw are added as instances (a rotation and translation),
+// and draw expands the model through every instance transform into one
+// vertex array, so that all the blocks are drawn with a single call.
+class BlockBatch
+{
+    public:
+
+        // Constructor.
+        BlockBatch();
+
+        // Destructor.
+        ~BlockBatch();
+
+        // Build the block model from a body's vertices, tiling each face
+        // with tiles x tiles quads. faceTextures gives the atlas tile of
+        // each face, atlas tiles being numbered by row from the bottom left;
+        // if NULL each face is mapped onto the whole texture.
+        void build(RigidBody *body, int tiles, int *faceTextures = NULL,
+            int atlasColumns = 1, int atlasRows = 1);
+
+        // Remove all instances.
+        void clear() { numInstances = 0; }
+
+        // Add an instance.
+        void add(Vector position, Quaternion orientation,
+            GLfloat red, GLfloat green, GLfloat blue);
+
+        // Get number of instances.
+        int getSize() { return(numInstances); }
+
+        // Draw faces: textured and lit when painting, else in instance colors.
+        void draw(bool paint);
+
+        // Draw outlines.
+        void drawOutlines();
+
+    private:
+
+        // Block model.
+        int numModelVertices;                     // 4 per quad
+        GLfloat (*modelPositions)[3];
+        GLfloat (*modelNormals)[3];
+        GLfloat (*modelTexCoords)[2];
+        GLfloat modelEdges[24][3];                // 12 edges
+
+        // Instances: rotation columns and translation.
+        int numInstances;
+        int maxInstances;
+        GLfloat (*instanceTransforms)[12];
+        GLfloat (*instanceColors)[3];
+
+        // Expanded vertex arrays.
+        GLfloat (*positions)[3];
+        GLfloat (*normals)[3];
+        GLfloat (*texCoords)[2];
+        GLfloat (*colors)[3];
+        GLfloat (*edges)[3];
+
+        void reserve(int);
+        void transform(GLfloat *t, GLfloat *local, GLfloat *world)
+        {
+            world[0] = (t[0] * local[0]) + (t[3] * local[1]) + (t[6] * local[2]) + t[9];
+            world[1] = (t[1] * local[0]) + (t[4] * local[1]) + (t[7] * local[2]) + t[10];
+            world[2] = (t[2] * local[0]) + (t[5] * local[1]) + (t[8] * local[2]) + t[11];
+        }
+        void rotate(GLfloat *t, GLfloat *local, GLfloat *world)
+        {
+            world[0] = (t[0] * local[0]) + (t[3] * local[1]) + (t[6] * local[2]);
+            world[1] = (t[1] * local[0]) + (t[4] * local[1]) + (t[7] * local[2]);
+            world[2] = (t[2] * local[0]) + (t[5] * local[1]) + (t[8] * local[2]);
+        }
+};
+
+// Block faces: vertex list corners of the starting corner, the corner
+// along the rows and the corner along the columns, and outward normal.
+static int BlockFaceCorners[6][3] =
+{
+    { 0, 1, 3 }, { 2, 6, 3 }, { 5, 4, 6 }, { 0, 4, 1 }, { 1, 5, 2 }, { 4, 0, 7 }
+};
+static GLfloat BlockFaceNormals[6][3] =
+{
+    { 1.0, 0.0, 0.0 }, { 0.0, -1.0, 0.0 }, { -1.0, 0.0, 0.0 },
+    { 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0 }, { 0.0, 0.0, -1.0 }
+};
+
+// Block edges.
+static int BlockEdges[12][2] =
+{
+    { 0, 1 }, { 1, 2 }, { 2, 3 }, { 3, 0 }, { 2, 6 }, { 6, 7 },
+    { 7, 3 }, { 6, 5 }, { 5, 4 }, { 4, 7 }, { 0, 4 }, { 5, 1 }
+};
+
+// Constructor.
+BlockBatch::BlockBatch()
+{
+    numModelVertices = 0;
+    modelPositions = modelNormals = NULL;
+    modelTexCoords = NULL;
+    numInstances = maxInstances = 0;
+    instanceTransforms = NULL;
+    instanceColors = NULL;
+    positions = normals = colors = edges = NULL;
+    texCoords = NULL;
+}
+
+
+// Destructor.
+BlockBatch::~BlockBatch()
+{
+    if (modelPositions != NULL) delete [] modelPositions;
+    if (modelNormals != NULL) delete [] modelNormals;
+    if (modelTexCoords != NULL) delete [] modelTexCoords;
+    reserve(0);
+}
+
+
+// Build the block model.
+void BlockBatch::build(RigidBody *body, int tiles, int *faceTextures,
+int atlasColumns, int atlasRows)
+{
+    int i,j,k,n,v;
+    GLfloat a[3],b[3],c[3],s,t,d,u0,v0,du,dv;
+    Vector *corner;
+
+    if (modelPositions != NULL) delete [] modelPositions;
+    if (modelNormals != NULL) delete [] modelNormals;
+    if (modelTexCoords != NULL) delete [] modelTexCoords;
+    reserve(0);
+
+    if (tiles < 1) tiles = 1;
+    numModelVertices = 6 * tiles * tiles * 4;
+    modelPositions = new GLfloat[numModelVertices][3];
+    modelNormals = new GLfloat[numModelVertices][3];
+    modelTexCoords = new GLfloat[numModelVertices][2];
+
+    // Tile each face. Texture coordinates run from 1 to 0 along the rows
+    // and columns from the starting corner.
+    d = 1.0 / (GLfloat)tiles;
+    for (i = v = 0; i < 6; i++)
+    {
+        corner = body->vVertexList;
+        n = BlockFaceCorners[i][0];
+        a[0] = corner[n].x; a[1] = corner[n].y; a[2] = corner[n].z;
+        n = BlockFaceCorners[i][1];
+        b[0] = corner[n].x - a[0]; b[1] = corner[n].y - a[1]; b[2] = corner[n].z - a[2];
+        n = BlockFaceCorners[i][2];
+        c[0] = corner[n].x - a[0]; c[1] = corner[n].y - a[1]; c[2] = corner[n].z - a[2];
+        if (faceTextures != NULL)
+        {
+            n = faceTextures[i];
+            du = (1.0 - (2.0 * BLOCK_ATLAS_INSET)) / (GLfloat)atlasColumns;
+            dv = (1.0 - (2.0 * BLOCK_ATLAS_INSET)) / (GLfloat)atlasRows;
+            u0 = ((GLfloat)(n % atlasColumns) + BLOCK_ATLAS_INSET) / (GLfloat)atlasColumns;
+            v0 = ((GLfloat)(n / atlasColumns) + BLOCK_ATLAS_INSET) / (GLfloat)atlasRows;
+        }
+        else
+        {
+            u0 = v0 = 0.0;
+            du = dv = 1.0;
+        }
+        for (j = 0; j < tiles; j++)
+        {
+            for (k = 0; k < tiles; k++, v += 4)
+            {
+                s = (GLfloat)k * d;
+                t = (GLfloat)j * d;
+                for (n = 0; n < 3; n++)
+                {
+                    modelPositions[v][n] = a[n] + (s * b[n]) + (t * c[n]);
+                    modelPositions[v + 1][n] = a[n] + ((s + d) * b[n]) + (t * c[n]);
+                    modelPositions[v + 2][n] = a[n] + ((s + d) * b[n]) + ((t + d) * c[n]);
+                    modelPositions[v + 3][n] = a[n] + (s * b[n]) + ((t + d) * c[n]);
+                    modelNormals[v][n] = modelNormals[v + 1][n] = BlockFaceNormals[i][n];
+                    modelNormals[v + 2][n] = modelNormals[v + 3][n] = BlockFaceNormals[i][n];
+                }
+                modelTexCoords[v][0] = u0 + ((1.0 - s) * du);
+                modelTexCoords[v][1] = v0 + ((1.0 - t) * dv);
+                modelTexCoords[v + 1][0] = u0 + ((1.0 - s - d) * du);
+                modelTexCoords[v + 1][1] = v0 + ((1.0 - t) * dv);
+                modelTexCoords[v + 2][0] = u0 + ((1.0 - s - d) * du);
+                modelTexCoords[v + 2][1] = v0 + ((1.0 - t - d) * dv);
+                modelTexCoords[v + 3][0] = u0 + ((1.0 - s) * du);
+                modelTexCoords[v + 3][1] = v0 + ((1.0 - t - d) * dv);
+            }
+        }
+    }
+
+    // Edges.
+    for (i = 0; i < 12; i++)
+    {
+        for (j = 0; j < 2; j++)
+        {
+            n = BlockEdges[i][j];
+            modelEdges[(i * 2) + j][0] = body->vVertexList[n].x;
+            modelEdges[(i * 2) + j][1] = body->vVertexList[n].y;
+            modelEdges[(i * 2) + j][2] = body->vVertexList[n].z;
+        }
+    }
+}
+
+
+// Size instance arrays; 0 frees them.
+void BlockBatch::reserve(int count)
+{
+    int i,j;
+
+    if (count == 0)
+    {
+        if (instanceTransforms != NULL) delete [] instanceTransforms;
+        if (instanceColors != NULL) delete [] instanceColors;
+        if (positions != NULL) delete [] positions;
+        if (normals != NULL) delete [] normals;
+        if (texCoords != NULL) delete [] texCoords;
+        if (colors != NULL) delete [] colors;
+        if (edges != NULL) delete [] edges;
+        instanceTransforms = NULL;
+        instanceColors = NULL;
+        positions = normals = colors = edges = NULL;
+        texCoords = NULL;
+        numInstances = maxInstances = 0;
+        return;
+    }
+    if (count <= maxInstances) return;
+
+    GLfloat (*oldTransforms)[12] = instanceTransforms;
+    GLfloat (*oldColors)[3] = instanceColors;
+    instanceTransforms = new GLfloat[count][12];
+    instanceColors = new GLfloat[count][3];
+    for (i = 0; i < numInstances; i++)
+    {
+        for (j = 0; j < 12; j++) instanceTransforms[i][j] = oldTransforms[i][j];
+        for (j = 0; j < 3; j++) instanceColors[i][j] = oldColors[i][j];
+    }
+    if (oldTransforms != NULL) delete [] oldTransforms;
+    if (oldColors != NULL) delete [] oldColors;
+
+    if (positions != NULL) delete [] positions;
+    if (normals != NULL) delete [] normals;
+    if (texCoords != NULL) delete [] texCoords;
+    if (colors != NULL) delete [] colors;
+    if (edges != NULL) delete [] edges;
+    positions = new GLfloat[count * numModelVertices][3];
+    normals = new GLfloat[count * numModelVertices][3];
+    colors = new GLfloat[count * numModelVertices][3];
+    edges = new GLfloat[count * 24][3];
+
+    // Texture coordinates do not depend on the instance.
+    texCoords = new GLfloat[count * numModelVertices][2];
+    for (i = 0; i < count; i++)
+    {
+        for (j = 0; j < numModelVertices; j++)
+        {
+            texCoords[(i * numModelVertices) + j][0] = modelTexCoords[j][0];
+            texCoords[(i * numModelVertices) + j][1] = modelTexCoords[j][1];
+        }
+    }
+    maxInstances = count;
+}
+
+
+// Add an instance.
+void BlockBatch::add(Vector position, Quaternion orientation,
+GLfloat red, GLfloat green, GLfloat blue)
+{
+    GLfloat *t,w,x,y,z;
+
+    if (numModelVertices == 0) return;
+    if (numInstances == maxInstances) reserve((maxInstances * 2) + 16);
+
+    // Rotation matrix of the unit quaternion, as glRotatef
+    // would build it from the quaternion's angle and axis.
+    t = instanceTransforms[numInstances];
+    w = orientation.n;
+    x = orientation.v.x;
+    y = orientation.v.y;
+    z = orientation.v.z;
+    t[0] = 1.0 - (2.0 * ((y * y) + (z * z)));
+    t[1] = 2.0 * ((x * y) + (w * z));
+    t[2] = 2.0 * ((x * z) - (w * y));
+    t[3] = 2.0 * ((x * y) - (w * z));
+    t[4] = 1.0 - (2.0 * ((x * x) + (z * z)));
+    t[5] = 2.0 * ((y * z) + (w * x));
+    t[6] = 2.0 * ((x * z) + (w * y));
+    t[7] = 2.0 * ((y * z) - (w * x));
+    t[8] = 1.0 - (2.0 * ((x * x) + (y * y)));
+    t[9] = position.x;
+    t[10] = position.y;
+    t[11] = position.z;
+    instanceColors[numInstances][0] = red;
+    instanceColors[numInstances][1] = green;
+    instanceColors[numInstances][2] = blue;
+    numInstances++;
+}
+
+
+// Draw faces.
+void BlockBatch::draw(bool paint)
+{
+    int i,j,k;
+    GLfloat *t;
+
+    if (numInstances == 0) return;
+
+    // Expand the model through the instance transforms.
+    for (i = k = 0; i < numInstances; i++)
+    {
+        t = instanceTransforms[i];
+        for (j = 0; j < numModelVertices; j++, k++)
+        {
+            transform(t, modelPositions[j], positions[k]);
+            if (paint)
+            {
+                rotate(t, modelNormals[j], normals[k]);
+            }
+            else
+            {
+                colors[k][0] = instanceColors[i][0];
+                colors[k][1] = instanceColors[i][1];
+                colors[k][2] = instanceColors[i][2];
+            }
+        }
+    }
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, positions);
+    if (paint)
+    {
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glNormalPointer(GL_FLOAT, 0, normals);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(2, GL_FLOAT, 0, texCoords);
+    }
+    else
+    {
+        glEnableClientState(GL_COLOR_ARRAY);
+        glColorPointer(3, GL_FLOAT, 0, colors);
+    }
+    glDrawArrays(GL_QUADS, 0, numInstances * numModelVertices);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+}
+
+
+// Draw outlines.
+void BlockBatch::drawOutlines()
+{
+    int i,j,k;
+
+    if (numInstances == 0) return;
+    for (i = k = 0; i < numInstances; i++)
+    {
+        for (j = 0; j < 24; j++, k++)
+        {
+            transform(instanceTransforms[i], modelEdges[j], edges[k]);
+        }
+    }
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, edges);
+    glDrawArrays(GL_LINES, 0, numInstances * 24);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+#endif                                            // #ifndef __BLOCK_BATCH_HPP__
@@ -0,0 +1,122 @@
+//***************************************************************************//
+//* File Name: drawQueue.hpp                                                *//
+//* Author:    Tom Portegys, portegys@ilstu.edu                             *//
+//* Date Made: 10/17/26                                                     *//
+//* File Desc: Class declaration and implementation details                 *//
+//*            representing a frame's draws, sorted by render state         *//
+//*            before they are submitted.                                   *//
+//* Rev. Date:                                                              *//
+//* Rev. Desc:                                                              *//
+//*                                                                         *//
+//***************************************************************************//
+
+#ifndef __DRAW_QUEUE_HPP__
+#define __DRAW_QUEUE_HPP__
+
+#ifndef UNIX
+#include <windows.h>
+#endif
+#include <stdlib.h>
+#include <GL/gl.h>
+
+// Draw state key: state bits above the texture name.
+// Keys sort opaque untextured draws first, then opaque textured and lit
+// draws grouped by texture, then blended draws, then draws that must
+// come after everything else.
+#define DRAW_LIT            0x01000000
+#define DRAW_TEXTURED       0x02000000
+#define DRAW_BLENDED        0x04000000
+#define DRAW_LAST           0x08000000
+
+// A draw is a function drawing the object of the given index.
+// Draws with equal keys are submitted in the order they were added.
+class cDrawQueue
+{
+    public:
+
+        // Constructor.
+        cDrawQueue()
+        {
+            items = NULL;
+            numItems = maxItems = 0;
+        }
+
+        // Destructor.
+        ~cDrawQueue()
+        {
+            if (items != NULL) delete [] items;
+        }
+
+        // Remove all draws.
+        void clear() { numItems = 0; }
+
+        // Add draw.
+        void add(unsigned int key, void (*draw)(int), int index);
+
+        // Get number of draws.
+        int getSize() { return(numItems); }
+
+        // Sort draws by key and submit them.
+        void submit();
+
+    private:
+
+        struct DrawItem
+        {
+            unsigned int key;
+            int sequence;
+            void (*draw)(int);
+            int index;
+        };
+        struct DrawItem *items;
+        int numItems;
+        int maxItems;
+
+        static int compareItems(const void *, const void *);
+};
+
+// Add draw.
+void cDrawQueue::add(unsigned int key, void (*draw)(int), int index)
+{
+    int i;
+    struct DrawItem *oldItems;
+
+    if (numItems == maxItems)
+    {
+        oldItems = items;
+        maxItems = (maxItems * 2) + 16;
+        items = new struct DrawItem[maxItems];
+        for (i = 0; i < numItems; i++) items[i] = oldItems[i];
+        if (oldItems != NULL) delete [] oldItems;
+    }
+    items[numItems].key = key;
+    items[numItems].sequence = numItems;
+    items[numItems].draw = draw;
+    items[numItems].index = index;
+    numItems++;
+}
+
+
+// Sort draws by key and submit them.
+void cDrawQueue::submit()
+{
+    int i;
+
+    qsort(items, numItems, sizeof(struct DrawItem), compareItems);
+    for (i = 0; i < numItems; i++)
+    {
+        items[i].draw(items[i].index);
+    }
+}
+
+
+// Compare draws: by key, then in order added.
+int cDrawQueue::compareItems(const void *p1, const void *p2)
+{
+    const struct DrawItem *d1 = (const struct DrawItem *)p1;
+    const struct DrawItem *d2 = (const struct DrawItem *)p2;
+
+    if (d1->key != d2->key) return(d1->key < d2->key ? -1 : 1);
+    return(d1->sequence - d2->sequence);
+}
+#endif                                            // #ifndef __DRAW_QUEUE_HPP__
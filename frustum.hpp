@@ -16,16 +16,30 @@
 #include <windows.h>
 #endif
 #include <GL/gl.h>
+#ifndef NO_SSE
+#include <xmmintrin.h>
+#endif
 #include "math_etc.h"
 
+// Sphere classes.
+#define FRUSTUM_OUTSIDE 0
+#define FRUSTUM_INSIDE 1
+#define FRUSTUM_STRADDLE 2
+
 class Frustum
 {
     public:
 
-        // Constructor.
-        Frustum()
+        // Constructor: from projection and modelview matrices.
+        Frustum(GLfloat *projection, GLfloat *modelview)
+        {
+            ExtractFrustum(projection, modelview);
+        }
+
+        // Update: from new projection and modelview matrices.
+        void update(GLfloat *projection, GLfloat *modelview)
         {
-            ExtractFrustum();
+            ExtractFrustum(projection, modelview);
         }
 
         // Box/frustum bounding planes.
@@ -38,26 +52,27 @@ class Frustum
         // Plane to point distance.
         GLfloat planeToPoint(struct Plane, Vector);
 
+        // Classify spheres as outside, inside or straddling the frustum.
+        // Spheres are given as arrays of center coordinates and radii.
+        void cullSpheres(int count, GLfloat *x, GLfloat *y, GLfloat *z,
+            GLfloat *radius, unsigned char *classes);
+
     private:
 
         // Extract frustum.
-        void ExtractFrustum();
+        void ExtractFrustum(GLfloat *proj, GLfloat *modl);
 
 };
 
-// Extracts The Current View Frustum Plane Equations
+// Extracts The View Frustum Plane Equations
 // Code from: www.markmorley.com/opengl/frustumculling.html
+// The matrices are given rather than read back from OpenGL.
 void
-Frustum::ExtractFrustum()
+Frustum::ExtractFrustum(GLfloat *proj, GLfloat *modl)
 {
-    float   proj[16];                             // For Grabbing The PROJECTION Matrix
-    float   modl[16];                             // For Grabbing The MODELVIEW Matrix
     float   clip[16];                             // Result Of Concatenating PROJECTION and MODELVIEW
     float   t;                                    // Temporary Work Variable
 
-    glGetFloatv( GL_PROJECTION_MATRIX, proj );    // Grab The Current PROJECTION Matrix
-    glGetFloatv( GL_MODELVIEW_MATRIX, modl );     // Grab The Current MODELVIEW Matrix
-
     // Concatenate (Multiply) The Two Matricies
     clip[ 0] = modl[ 0] * proj[ 0] + modl[ 1] * proj[ 4] + modl[ 2] * proj[ 8] + modl[ 3] * proj[12];
     clip[ 1] = modl[ 0] * proj[ 1] + modl[ 1] * proj[ 5] + modl[ 2] * proj[ 9] + modl[ 3] * proj[13];
@@ -170,4 +185,73 @@ GLfloat Frustum::planeToPoint(struct Plane plane, Vector point)
 {
     return((plane.a * point.x) + (plane.b * point.y) + (plane.c * point.z) + plane.d);
 }
+
+
+// Classify spheres.
+// A sphere is outside if it is wholly behind any plane, and inside
+// if it is wholly in front of every plane. Four spheres are tested
+// against each plane at a time.
+void Frustum::cullSpheres(int count, GLfloat *x, GLfloat *y, GLfloat *z,
+GLfloat *radius, unsigned char *classes)
+{
+    int i,j,outside,straddle;
+    GLfloat d;
+
+    i = 0;
+    #ifndef NO_SSE
+    __m128 px,py,pz,r,nr,dist,out,cross;
+    __m128 a[6],b[6],c[6],dd[6];
+
+    for (j = 0; j < 6; j++)
+    {
+        a[j] = _mm_set1_ps(planes[j].a);
+        b[j] = _mm_set1_ps(planes[j].b);
+        c[j] = _mm_set1_ps(planes[j].c);
+        dd[j] = _mm_set1_ps(planes[j].d);
+    }
+    for (; i + 4 <= count; i += 4)
+    {
+        px = _mm_loadu_ps(&x[i]);
+        py = _mm_loadu_ps(&y[i]);
+        pz = _mm_loadu_ps(&z[i]);
+        r = _mm_loadu_ps(&radius[i]);
+        nr = _mm_sub_ps(_mm_setzero_ps(), r);
+        out = cross = _mm_setzero_ps();
+        for (j = 0; j < 6; j++)
+        {
+            dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[j], px), _mm_mul_ps(b[j], py)),
+                _mm_add_ps(_mm_mul_ps(c[j], pz), dd[j]));
+            out = _mm_or_ps(out, _mm_cmplt_ps(dist, nr));
+            cross = _mm_or_ps(cross, _mm_cmplt_ps(dist, r));
+        }
+        outside = _mm_movemask_ps(out);
+        straddle = _mm_movemask_ps(cross);
+        for (j = 0; j < 4; j++)
+        {
+            if (outside & (1 << j))
+                classes[i + j] = FRUSTUM_OUTSIDE;
+            else if (straddle & (1 << j))
+                classes[i + j] = FRUSTUM_STRADDLE;
+            else
+                classes[i + j] = FRUSTUM_INSIDE;
+        }
+    }
+    #endif
+    for (; i < count; i++)
+    {
+        outside = straddle = 0;
+        for (j = 0; j < 6; j++)
+        {
+            d = (planes[j].a * x[i]) + (planes[j].b * y[i]) + (planes[j].c * z[i]) + planes[j].d;
+            if (d < -radius[i]) outside = 1;
+            if (d < radius[i]) straddle = 1;
+        }
+        if (outside)
+            classes[i] = FRUSTUM_OUTSIDE;
+        else if (straddle)
+            classes[i] = FRUSTUM_STRADDLE;
+        else
+            classes[i] = FRUSTUM_INSIDE;
+    }
+}
 #endif
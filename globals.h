@@ -28,7 +28,9 @@ extern int masterXwing;
 #define FIRST_FIXED_BLOCK (FIRST_WALL_BLOCK + NUM_WALL_BLOCKS)
 #define NUM_FIXED_BLOCKS 8
 #define FIRST_BLOCK (FIRST_FIXED_BLOCK + NUM_FIXED_BLOCKS)
-#define NUM_BLOCKS 20
+#define DEFAULT_NUM_BLOCKS 20
+#define NUM_BLOCKS NumBlocks
+extern int NumBlocks;                             // Set by -blocks option.
 
 // X-wing parameters and controls.
 #define NUM_XWINGS 3
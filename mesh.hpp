@@ -0,0 +1,665 @@
+//***************************************************************************//
+//* File Name: mesh.hpp                                                     *//
+//* Author:    Tom Portegys, portegys@ilstu.edu                             *//
+//* Date Made: 10/17/26                                                     *//
+//* File Desc: Class declaration and implementation details                 *//
+//*            representing an indexed vertex buffer mesh built from an     *//
+//*            exported model.                                              *//
+//* Rev. Date:                                                              *//
+//* Rev. Desc:                                                              *//
+//*                                                                         *//
+//***************************************************************************//
+
+#ifndef __MESH_HPP__
+#define __MESH_HPP__
+
+#ifndef UNIX
+#include <windows.h>
+#endif
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <GL/gl.h>
+#ifdef UNIX
+#include <GL/glx.h>
+#endif
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+// OpenGL 1.5 buffer object definitions.
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER         0x8892
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_STATIC_DRAW          0x88E4
+#define GL_STREAM_DRAW          0x88E0
+#endif
+
+// Buffer object entry points, loaded at run time.
+typedef void (APIENTRY *MeshGenBuffersProc)(GLsizei, GLuint *);
+typedef void (APIENTRY *MeshDeleteBuffersProc)(GLsizei, const GLuint *);
+typedef void (APIENTRY *MeshBindBufferProc)(GLenum, GLuint);
+typedef void (APIENTRY *MeshBufferDataProc)(GLenum, ptrdiff_t, const GLvoid *, GLenum);
+typedef void (APIENTRY *MeshBufferSubDataProc)(GLenum, ptrdiff_t, ptrdiff_t, const GLvoid *);
+
+// Floats per vertex attribute: normal and texture coordinate.
+#define MESH_ATTRIBUTE_SIZE 5
+
+// Maximum coarser levels of detail.
+#define MESH_MAX_LEVELS 4
+
+// The mesh keeps one vertex for each distinct (vertex, normal, texture)
+// triple of the model faces and draws the faces with glDrawElements, one
+// call per material run. Vertex positions are held apart from the normals
+// and texture coordinates so that meshes differing only in positions (such
+// as undulations) can share the topology mesh's attribute and index buffers.
+// Buffer objects are used when the OpenGL implementation has them; otherwise
+// the same arrays are drawn as client vertex arrays.
+// Coarser levels of detail are subsets of the faces, made by clustering
+// vertices, and are drawn with the same vertices. They are kept by the
+// topology mesh, so that every mesh sharing it can draw them.
+class cMesh
+{
+    public:
+
+        // Constructor: empty mesh. No OpenGL calls are made until built.
+        cMesh();
+
+        // Destructor.
+        ~cMesh();
+
+        // Build from exported model arrays. Face rows are
+        // {vertex[3], normal[3], texture[3]} indices; material rows are
+        // {material index, face count}.
+        void build(short (*faces)[9], int numFaces, GLfloat (*vertices)[3],
+            GLfloat (*normals)[3], GLfloat (*textures)[2],
+            int (*materials)[2], void (*selectMaterial)(int));
+
+        // Build with the faces of a topology mesh and the given model
+        // vertex positions. A dynamic mesh expects setVertices every frame,
+        // and streams its positions into a fresh buffer each time.
+        void build(cMesh *topology, GLfloat (*vertices)[3], bool dynamic = false);
+
+        // Replace positions with the given model vertex positions.
+        void setVertices(GLfloat (*vertices)[3]);
+
+        // Add a coarser level of detail, clustering vertices on a grid of
+        // the given cell size. Returns the level number, or -1 if full.
+        int addLevel(GLfloat cellSize);
+
+        // Draw all faces.
+        void draw() { drawLevel(0, 0, numFaces - 1); }
+
+        // Draw faces startFace through endFace.
+        void draw(int startFace, int endFace) { drawLevel(0, startFace, endFace); }
+
+        // Draw at a level of detail: 0 is the full mesh. Faces are
+        // numbered as in the full mesh; dropped faces are skipped.
+        void drawLevel(int level) { drawLevel(level, 0, numFaces - 1); }
+        void drawLevel(int level, int startFace, int endFace);
+
+        // Number of distinct vertices.
+        int getNumVertices() { return(numVertices); }
+
+        // Number of levels of detail, including the full mesh.
+        int getNumLevels() { return(topology->numLevels + 1); }
+
+        // Number of faces drawn at a level of detail.
+        int getNumFaces(int level);
+
+        // Buffer object support, also used by other streamed geometry.
+        // The entry points are loaded by initBufferObjects, and are only
+        // valid if bufferObjects is true.
+        static bool bufferObjects;
+        static MeshGenBuffersProc genBuffers;
+        static MeshDeleteBuffersProc deleteBuffers;
+        static MeshBindBufferProc bindBuffer;
+        static MeshBufferDataProc bufferData;
+        static MeshBufferSubDataProc bufferSubData;
+        static void initBufferObjects();
+
+    private:
+
+        cMesh *topology;                          // owner of faces and attributes
+        int numFaces;
+        int numVertices;
+        int *modelVertex;                         // model vertex of each vertex
+        GLfloat (*positions)[3];
+        GLfloat *attributes;                      // normal and texture coordinate
+        GLushort *indices;                        // 3 per face, models are < 64K vertices
+
+        // Material runs.
+        int numGroups;
+        int *groupMaterial;
+        int *groupStart;                          // first face of run
+        void (*selectMaterial)(int);
+
+        // Coarser levels of detail, kept by the topology mesh.
+        // The face map holds the number of level faces before each face
+        // of the full mesh.
+        struct MeshLevel
+        {
+            int numFaces;
+            GLushort *indices;
+            int numGroups;
+            int *groupMaterial;
+            int *groupStart;
+            int *faceMap;
+            GLuint indexBuffer;
+        };
+        struct MeshLevel levels[MESH_MAX_LEVELS];
+        int numLevels;
+
+        // Buffer objects.
+        GLuint positionBuffer;
+        GLuint attributeBuffer;
+        GLuint indexBuffer;
+        bool dynamic;
+
+        void clear();
+        void loadPositions(GLfloat (*vertices)[3]);
+
+        static bool bufferInit;
+        static void *getProcAddress(const char *);
+};
+
+bool cMesh::bufferInit = false;
+bool cMesh::bufferObjects = false;
+MeshGenBuffersProc cMesh::genBuffers = NULL;
+MeshDeleteBuffersProc cMesh::deleteBuffers = NULL;
+MeshBindBufferProc cMesh::bindBuffer = NULL;
+MeshBufferDataProc cMesh::bufferData = NULL;
+MeshBufferSubDataProc cMesh::bufferSubData = NULL;
+
+// Constructor.
+cMesh::cMesh()
+{
+    topology = this;
+    numFaces = numVertices = 0;
+    modelVertex = NULL;
+    positions = NULL;
+    attributes = NULL;
+    indices = NULL;
+    numGroups = 0;
+    groupMaterial = groupStart = NULL;
+    selectMaterial = NULL;
+    numLevels = 0;
+    positionBuffer = attributeBuffer = indexBuffer = 0;
+    dynamic = false;
+}
+
+
+// Destructor.
+cMesh::~cMesh()
+{
+    clear();
+}
+
+
+// Free arrays and buffers.
+void cMesh::clear()
+{
+    int i;
+
+    if (positionBuffer != 0) deleteBuffers(1, &positionBuffer);
+    if (topology == this)
+    {
+        for (i = 0; i < numLevels; i++)
+        {
+            if (levels[i].indexBuffer != 0) deleteBuffers(1, &levels[i].indexBuffer);
+            delete [] levels[i].indices;
+            delete [] levels[i].groupMaterial;
+            delete [] levels[i].groupStart;
+            delete [] levels[i].faceMap;
+        }
+        if (attributeBuffer != 0) deleteBuffers(1, &attributeBuffer);
+        if (indexBuffer != 0) deleteBuffers(1, &indexBuffer);
+        if (modelVertex != NULL) delete [] modelVertex;
+        if (attributes != NULL) delete [] attributes;
+        if (indices != NULL) delete [] indices;
+        if (groupMaterial != NULL) delete [] groupMaterial;
+        if (groupStart != NULL) delete [] groupStart;
+    }
+    if (positions != NULL) delete [] positions;
+    topology = this;
+    numFaces = numVertices = numGroups = numLevels = 0;
+    modelVertex = NULL;
+    positions = NULL;
+    attributes = NULL;
+    indices = NULL;
+    groupMaterial = groupStart = NULL;
+    positionBuffer = attributeBuffer = indexBuffer = 0;
+}
+
+
+// Look up an OpenGL entry point.
+void *cMesh::getProcAddress(const char *name)
+{
+#ifdef UNIX
+    return((void *)glXGetProcAddressARB((const GLubyte *)name));
+#else
+    return((void *)wglGetProcAddress(name));
+#endif
+}
+
+
+// Load buffer object entry points: core in OpenGL 1.5,
+// otherwise from the ARB_vertex_buffer_object extension.
+void cMesh::initBufferObjects()
+{
+    const char *version,*extensions;
+    int major,minor;
+    const char *suffix;
+    char name[32];
+
+    if (bufferInit) return;
+    bufferInit = true;
+
+    major = minor = 0;
+    version = (const char *)glGetString(GL_VERSION);
+    if (version != NULL) sscanf(version, "%d.%d", &major, &minor);
+    if (major > 1 || (major == 1 && minor >= 5))
+    {
+        suffix = "";
+    }
+    else
+    {
+        extensions = (const char *)glGetString(GL_EXTENSIONS);
+        if (extensions == NULL || strstr(extensions, "GL_ARB_vertex_buffer_object") == NULL) return;
+        suffix = "ARB";
+    }
+    sprintf(name, "glGenBuffers%s", suffix);
+    genBuffers = (MeshGenBuffersProc)getProcAddress(name);
+    sprintf(name, "glDeleteBuffers%s", suffix);
+    deleteBuffers = (MeshDeleteBuffersProc)getProcAddress(name);
+    sprintf(name, "glBindBuffer%s", suffix);
+    bindBuffer = (MeshBindBufferProc)getProcAddress(name);
+    sprintf(name, "glBufferData%s", suffix);
+    bufferData = (MeshBufferDataProc)getProcAddress(name);
+    sprintf(name, "glBufferSubData%s", suffix);
+    bufferSubData = (MeshBufferSubDataProc)getProcAddress(name);
+    if (genBuffers != NULL && deleteBuffers != NULL && bindBuffer != NULL &&
+        bufferData != NULL && bufferSubData != NULL) bufferObjects = true;
+}
+
+
+// Build from exported model arrays.
+void cMesh::build(short (*faces)[9], int numFaces, GLfloat (*vertices)[3],
+GLfloat (*normals)[3], GLfloat (*textures)[2],
+int (*materials)[2], void (*selectMaterial)(int))
+{
+    int i,j,k,v,n,t,numModelVertices,mcount,mindex;
+    int *first,*next,*normalIndex,*textureIndex;
+
+    clear();
+    initBufferObjects();
+    this->numFaces = numFaces;
+    this->selectMaterial = selectMaterial;
+
+    // Material runs.
+    groupMaterial = new int[numFaces];
+    groupStart = new int[numFaces];
+    mcount = mindex = 0;
+    for (i = 0; i < numFaces; i++)
+    {
+        if (!mcount)
+        {
+            groupMaterial[numGroups] = materials[mindex][0];
+            groupStart[numGroups] = i;
+            numGroups++;
+            mcount = materials[mindex][1];
+            mindex++;
+        }
+        mcount--;
+    }
+
+    // Share a vertex between faces when vertex, normal and texture
+    // indices all match. Candidates are chained per model vertex.
+    numModelVertices = 0;
+    for (i = 0; i < numFaces; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            if (faces[i][j] >= numModelVertices) numModelVertices = faces[i][j] + 1;
+        }
+    }
+    first = new int[numModelVertices];
+    for (i = 0; i < numModelVertices; i++) first[i] = -1;
+    next = new int[numFaces * 3];
+    modelVertex = new int[numFaces * 3];
+    normalIndex = new int[numFaces * 3];
+    textureIndex = new int[numFaces * 3];
+    indices = new GLushort[numFaces * 3];
+    for (i = 0; i < numFaces; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            v = faces[i][j];
+            n = faces[i][j+3];
+            t = faces[i][j+6];
+            for (k = first[v]; k != -1; k = next[k])
+            {
+                if (normalIndex[k] == n && textureIndex[k] == t) break;
+            }
+            if (k == -1)
+            {
+                k = numVertices++;
+                modelVertex[k] = v;
+                normalIndex[k] = n;
+                textureIndex[k] = t;
+                next[k] = first[v];
+                first[v] = k;
+            }
+            indices[(i * 3) + j] = (GLushort)k;
+        }
+    }
+
+    // Attributes.
+    attributes = new GLfloat[numVertices * MESH_ATTRIBUTE_SIZE];
+    for (k = 0; k < numVertices; k++)
+    {
+        n = normalIndex[k];
+        t = textureIndex[k];
+        attributes[(k * MESH_ATTRIBUTE_SIZE)] = normals[n][0];
+        attributes[(k * MESH_ATTRIBUTE_SIZE) + 1] = normals[n][1];
+        attributes[(k * MESH_ATTRIBUTE_SIZE) + 2] = normals[n][2];
+        attributes[(k * MESH_ATTRIBUTE_SIZE) + 3] = textures[t][0];
+        attributes[(k * MESH_ATTRIBUTE_SIZE) + 4] = textures[t][1];
+    }
+    delete [] first;
+    delete [] next;
+    delete [] normalIndex;
+    delete [] textureIndex;
+
+    if (bufferObjects)
+    {
+        genBuffers(1, &attributeBuffer);
+        bindBuffer(GL_ARRAY_BUFFER, attributeBuffer);
+        bufferData(GL_ARRAY_BUFFER, numVertices * MESH_ATTRIBUTE_SIZE * sizeof(GLfloat),
+            attributes, GL_STATIC_DRAW);
+        bindBuffer(GL_ARRAY_BUFFER, 0);
+        genBuffers(1, &indexBuffer);
+        bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        bufferData(GL_ELEMENT_ARRAY_BUFFER, numFaces * 3 * sizeof(GLushort),
+            indices, GL_STATIC_DRAW);
+        bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    // Positions.
+    dynamic = false;
+    loadPositions(vertices);
+}
+
+
+// Build with the faces of a topology mesh.
+void cMesh::build(cMesh *topology, GLfloat (*vertices)[3], bool dynamic)
+{
+    clear();
+    this->topology = topology;
+    this->dynamic = dynamic;
+    numFaces = topology->numFaces;
+    numVertices = topology->numVertices;
+    modelVertex = topology->modelVertex;
+    attributes = topology->attributes;
+    indices = topology->indices;
+    numGroups = topology->numGroups;
+    groupMaterial = topology->groupMaterial;
+    groupStart = topology->groupStart;
+    selectMaterial = topology->selectMaterial;
+    attributeBuffer = topology->attributeBuffer;
+    indexBuffer = topology->indexBuffer;
+    loadPositions(vertices);
+}
+
+
+// Create positions and their buffer.
+void cMesh::loadPositions(GLfloat (*vertices)[3])
+{
+    positions = new GLfloat[numVertices][3];
+    if (bufferObjects)
+    {
+        genBuffers(1, &positionBuffer);
+        bindBuffer(GL_ARRAY_BUFFER, positionBuffer);
+        bufferData(GL_ARRAY_BUFFER, numVertices * 3 * sizeof(GLfloat), NULL,
+            dynamic ? GL_STREAM_DRAW : GL_STATIC_DRAW);
+        bindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    setVertices(vertices);
+}
+
+
+// Replace positions.
+void cMesh::setVertices(GLfloat (*vertices)[3])
+{
+    int k,v;
+
+    for (k = 0; k < numVertices; k++)
+    {
+        v = modelVertex[k];
+        positions[k][0] = vertices[v][0];
+        positions[k][1] = vertices[v][1];
+        positions[k][2] = vertices[v][2];
+    }
+    if (positionBuffer != 0)
+    {
+        bindBuffer(GL_ARRAY_BUFFER, positionBuffer);
+        if (dynamic)
+        {
+            // Respecify the whole buffer rather than wait on the last draw.
+            bufferData(GL_ARRAY_BUFFER, numVertices * 3 * sizeof(GLfloat), positions,
+                GL_STREAM_DRAW);
+        }
+        else
+        {
+            bufferSubData(GL_ARRAY_BUFFER, 0, numVertices * 3 * sizeof(GLfloat), positions);
+        }
+        bindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
+
+// Add a coarser level of detail.
+// Each vertex is kept, or replaced by the first vertex in its grid cell
+// with the same dominant normal axis and sign, so that the two sides of
+// a thin part stay apart. Faces left with fewer than three distinct
+// vertices are dropped.
+int cMesh::addLevel(GLfloat cellSize)
+{
+    int i,j,k,f,g,e,n,numHash;
+    unsigned int h;
+    int (*key)[4],*first,*next,*cluster;
+    GLfloat min[3],*normal;
+    GLushort v[3];
+    struct MeshLevel *level;
+
+    if (topology != this) return(topology->addLevel(cellSize));
+    if (numLevels == MESH_MAX_LEVELS || numVertices == 0) return(-1);
+
+    // Grid origin.
+    for (j = 0; j < 3; j++) min[j] = positions[0][j];
+    for (k = 1; k < numVertices; k++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            if (positions[k][j] < min[j]) min[j] = positions[k][j];
+        }
+    }
+
+    // Cluster vertices. Cluster representatives are chained by hash.
+    numHash = numVertices;
+    first = new int[numHash];
+    for (i = 0; i < numHash; i++) first[i] = -1;
+    next = new int[numVertices];
+    key = new int[numVertices][4];
+    cluster = new int[numVertices];
+    for (k = 0; k < numVertices; k++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            key[k][j] = (int)((positions[k][j] - min[j]) / cellSize);
+        }
+        normal = &attributes[k * MESH_ATTRIBUTE_SIZE];
+        j = 0;
+        if (fabs(normal[1]) > fabs(normal[j])) j = 1;
+        if (fabs(normal[2]) > fabs(normal[j])) j = 2;
+        key[k][3] = (j * 2) + (normal[j] < 0.0 ? 1 : 0);
+        h = ((unsigned int)key[k][0] * 73856093) ^ ((unsigned int)key[k][1] * 19349663) ^
+            ((unsigned int)key[k][2] * 83492791) ^ (unsigned int)key[k][3];
+        h %= (unsigned int)numHash;
+        for (i = first[h]; i != -1; i = next[i])
+        {
+            if (key[i][0] == key[k][0] && key[i][1] == key[k][1] &&
+                key[i][2] == key[k][2] && key[i][3] == key[k][3]) break;
+        }
+        if (i == -1)
+        {
+            cluster[k] = k;
+            next[k] = first[h];
+            first[h] = k;
+        }
+        else
+        {
+            cluster[k] = i;
+        }
+    }
+
+    // Keep faces with three distinct clusters, by material run.
+    level = &levels[numLevels];
+    level->indices = new GLushort[numFaces * 3];
+    level->groupMaterial = new int[numGroups];
+    level->groupStart = new int[numGroups];
+    level->faceMap = new int[numFaces + 1];
+    level->numFaces = level->numGroups = 0;
+    level->indexBuffer = 0;
+    for (g = 0; g < numGroups; g++)
+    {
+        n = level->numFaces;
+        if (g < numGroups - 1) e = groupStart[g + 1]; else e = numFaces;
+        for (f = groupStart[g]; f < e; f++)
+        {
+            level->faceMap[f] = level->numFaces;
+            for (j = 0; j < 3; j++) v[j] = (GLushort)cluster[indices[(f * 3) + j]];
+            if (v[0] == v[1] || v[1] == v[2] || v[0] == v[2]) continue;
+            for (j = 0; j < 3; j++) level->indices[(level->numFaces * 3) + j] = v[j];
+            level->numFaces++;
+        }
+        if (level->numFaces > n)
+        {
+            level->groupMaterial[level->numGroups] = groupMaterial[g];
+            level->groupStart[level->numGroups] = n;
+            level->numGroups++;
+        }
+    }
+    level->faceMap[numFaces] = level->numFaces;
+    delete [] first;
+    delete [] next;
+    delete [] key;
+    delete [] cluster;
+
+    if (bufferObjects && level->numFaces > 0)
+    {
+        genBuffers(1, &level->indexBuffer);
+        bindBuffer(GL_ELEMENT_ARRAY_BUFFER, level->indexBuffer);
+        bufferData(GL_ELEMENT_ARRAY_BUFFER, level->numFaces * 3 * sizeof(GLushort),
+            level->indices, GL_STATIC_DRAW);
+        bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+    numLevels++;
+    return(numLevels);
+}
+
+
+// Number of faces drawn at a level of detail.
+int cMesh::getNumFaces(int level)
+{
+    if (level > topology->numLevels) level = topology->numLevels;
+    if (level <= 0) return(numFaces);
+    return(topology->levels[level - 1].numFaces);
+}
+
+
+// Draw faces startFace through endFace at a level of detail.
+void cMesh::drawLevel(int level, int startFace, int endFace)
+{
+    int i,s,e,n,groups,*materials,*starts;
+    GLushort *base,*levelIndices;
+    GLuint buffer;
+    struct MeshLevel *l;
+
+    if (numVertices == 0) return;
+    if (startFace < 0) startFace = 0;
+    if (endFace >= numFaces) endFace = numFaces - 1;
+    if (startFace > endFace) return;
+
+    // Level faces, renumbered.
+    if (level > topology->numLevels) level = topology->numLevels;
+    if (level > 0)
+    {
+        l = &topology->levels[level - 1];
+        startFace = l->faceMap[startFace];
+        endFace = l->faceMap[endFace + 1] - 1;
+        if (startFace > endFace) return;
+        n = l->numFaces;
+        groups = l->numGroups;
+        materials = l->groupMaterial;
+        starts = l->groupStart;
+        levelIndices = l->indices;
+        buffer = l->indexBuffer;
+    }
+    else
+    {
+        n = numFaces;
+        groups = numGroups;
+        materials = groupMaterial;
+        starts = groupStart;
+        levelIndices = indices;
+        buffer = indexBuffer;
+    }
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    if (positionBuffer != 0)
+    {
+        bindBuffer(GL_ARRAY_BUFFER, positionBuffer);
+        glVertexPointer(3, GL_FLOAT, 0, NULL);
+        bindBuffer(GL_ARRAY_BUFFER, attributeBuffer);
+        glNormalPointer(GL_FLOAT, MESH_ATTRIBUTE_SIZE * sizeof(GLfloat), NULL);
+        glTexCoordPointer(2, GL_FLOAT, MESH_ATTRIBUTE_SIZE * sizeof(GLfloat),
+            (GLvoid *)(3 * sizeof(GLfloat)));
+        bindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+        base = NULL;
+    }
+    else
+    {
+        glVertexPointer(3, GL_FLOAT, 0, positions);
+        glNormalPointer(GL_FLOAT, MESH_ATTRIBUTE_SIZE * sizeof(GLfloat), attributes);
+        glTexCoordPointer(2, GL_FLOAT, MESH_ATTRIBUTE_SIZE * sizeof(GLfloat), &attributes[3]);
+        base = levelIndices;
+    }
+
+    // One call per material run.
+    for (i = 0; i < groups; i++)
+    {
+        s = starts[i];
+        if (i < groups - 1) e = starts[i + 1] - 1; else e = n - 1;
+        if (e < startFace || s > endFace) continue;
+        if (s < startFace) s = startFace;
+        if (e > endFace) e = endFace;
+        selectMaterial(materials[i]);
+        glDrawElements(GL_TRIANGLES, (e - s + 1) * 3, GL_UNSIGNED_SHORT, base + (s * 3));
+    }
+
+    if (positionBuffer != 0)
+    {
+        bindBuffer(GL_ARRAY_BUFFER, 0);
+        bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+}
+#endif                                            // #ifndef __MESH_HPP__
@@ -27,7 +27,8 @@
 #define GAME_PORT 4507
 
 // Block payload size.
-#define NUM_PAYLOAD_BLOCKS (NUM_BLOCKS + (NUM_XWINGS * NUM_XWING_BLOCKS) + \
+// Networked games always use the default number of blocks.
+#define NUM_PAYLOAD_BLOCKS (DEFAULT_NUM_BLOCKS + (NUM_XWINGS * NUM_XWING_BLOCKS) + \
     (NUM_SQUIDS * NUM_SQUID_BLOCKS))
 
 // Maximum plasma bolt payload size.
@@ -83,10 +84,9 @@ class Network
         {
             plasmaBoltUpdated = true;
         }
-        void fire(PlasmaBolt *bolt)
+        void fire(Xwing *xwing)
         {
-            newPlasmaBolts->add(bolt);
-            plasmaBoltUpdated = true;
+            if (xwing->fire(newPlasmaBolts)) plasmaBoltUpdated = true;
         }
 
     private:
@@ -459,7 +459,7 @@ bool Network::getMaster()
                         if (squid->state != Squid::IDLE)
                         {
                             squid->Idle();
-                            Bodies[j + 1].valid = true;
+                            SetBodyValid(j + 1, true);
                         }
                         else
                         {
@@ -471,7 +471,7 @@ bool Network::getMaster()
                         {
                             xwing = Xwings[message.masterMsg.squidPayload[i].target].xwing;
                             squid->Attack(xwing);
-                            Bodies[j + 1].valid = false;
+                            SetBodyValid(j + 1, false);
                         }
                         else
                         {
@@ -502,8 +502,8 @@ bool Network::getMaster()
                         if (squid->state != Squid::DEAD)
                         {
                             squid->Kill();
-                            Bodies[j].valid = false;
-                            Bodies[j + 1].valid = false;
+                            SetBodyValid(j, false);
+                            SetBodyValid(j + 1, false);
                         }
                         else
                         {
@@ -545,21 +545,21 @@ bool Network::getMaster()
                 Bodies[j].qOrientation.v.x = message.masterMsg.blockPayload[i].quaternion[1];
                 Bodies[j].qOrientation.v.y = message.masterMsg.blockPayload[i].quaternion[2];
                 Bodies[j].qOrientation.v.z = message.masterMsg.blockPayload[i].quaternion[3];
+                InvalidateBodyCache(j);
             }
 
             // If numBolts > 0, a BOLT_PAYLOAD message is included.
             if (message.masterMsg.numBolts == 0) break;
 
             // Replace plasma bolts.
-            delete plasmaBolts;
-            plasmaBolts = new PlasmaBoltSet();
+            plasmaBolts->clear();
             for (i = 0; i < message.masterMsg.numBolts; i++)
             {
-                plasmaBolts->add(new PlasmaBolt(
+                plasmaBolts->add(
                     message.masterBoltMsg.bolts[i].position[0],
                     message.masterBoltMsg.bolts[i].position[1],
                     message.masterBoltMsg.bolts[i].position[2],
-                    0.5, 1.0, message.masterBoltMsg.bolts[i].quaternion));
+                    0.5, 1.0, message.masterBoltMsg.bolts[i].quaternion);
             }
         }
         break;
@@ -643,8 +643,6 @@ bool Network::sendMaster()
     register int i,j;
     register Xwing *xwing;
     register Squid *squid;
-    PlasmaBoltSet::Link *link;
-    PlasmaBolt *bolt;
 
     // Store X-wings.
     for (i = 0; i < NUM_XWINGS; i++)
@@ -717,19 +715,12 @@ bool Network::sendMaster()
     if (plasmaBoltUpdated)
     {
         message.masterMsg.numBolts = plasmaBolts->getSize();
-        for (i = 0, link = plasmaBolts->Set; i < message.masterMsg.numBolts;
-            i++, link = link->next)
+        for (i = 0; i < message.masterMsg.numBolts; i++)
         {
-            bolt = link->p;
-            message.masterBoltMsg.bolts[i].position[0] = bolt->X;
-            message.masterBoltMsg.bolts[i].position[1] = bolt->Y;
-            message.masterBoltMsg.bolts[i].position[2] = bolt->Z;
-            message.masterBoltMsg.bolts[i].speed = bolt->Speed;
-            message.masterBoltMsg.bolts[i].speedFactor = bolt->SpeedFactor;
-            message.masterBoltMsg.bolts[i].quaternion[0] = bolt->Qcalc->quat[0];
-            message.masterBoltMsg.bolts[i].quaternion[1] = bolt->Qcalc->quat[1];
-            message.masterBoltMsg.bolts[i].quaternion[2] = bolt->Qcalc->quat[2];
-            message.masterBoltMsg.bolts[i].quaternion[3] = bolt->Qcalc->quat[3];
+            plasmaBolts->getOrigin(i, message.masterBoltMsg.bolts[i].position);
+            message.masterBoltMsg.bolts[i].speed = plasmaBolts->getSpeed(i);
+            message.masterBoltMsg.bolts[i].speedFactor = plasmaBolts->getSpeedFactor(i);
+            plasmaBolts->getQuaternion(i, message.masterBoltMsg.bolts[i].quaternion);
         }
     }
     else
@@ -812,11 +803,11 @@ bool Network::getSlave()
                 Xwings[i].invulnerable = message.slaveMsg.invulnerable;
                 for (j = 0; j < message.slaveMsg.numBolts; j++)
                 {
-                    plasmaBolts->add(new PlasmaBolt(
+                    plasmaBolts->add(
                         message.slaveBoltMsg.bolts[j].position[0],
                         message.slaveBoltMsg.bolts[j].position[1],
                         message.slaveBoltMsg.bolts[j].position[2],
-                        0.5, 1.0, message.slaveBoltMsg.bolts[j].quaternion));
+                        0.5, 1.0, message.slaveBoltMsg.bolts[j].quaternion);
                 }
                 if (message.slaveMsg.numBolts > 0) plasmaBoltUpdated = true;
             }
@@ -920,8 +911,6 @@ bool Network::getSlave()
 bool Network::sendSlave()
 {
     int i;
-    PlasmaBoltSet::Link *link;
-    PlasmaBolt *bolt;
 
     messageAddr = masterAddr;
     message.type = SLAVE_INFO;
@@ -932,25 +921,14 @@ bool Network::sendSlave()
     message.slaveMsg.speed = Xwings[myXwing].xwing->GetSpeed();
     message.slaveMsg.invulnerable = Xwings[myXwing].invulnerable;
     message.slaveMsg.numBolts = newPlasmaBolts->getSize();
-    for (i = 0, link = newPlasmaBolts->Set; i < message.slaveMsg.numBolts;
-        i++, link = link->next)
-    {
-        bolt = link->p;
-        message.slaveBoltMsg.bolts[i].position[0] = bolt->X;
-        message.slaveBoltMsg.bolts[i].position[1] = bolt->Y;
-        message.slaveBoltMsg.bolts[i].position[2] = bolt->Z;
-        message.slaveBoltMsg.bolts[i].speed = bolt->Speed;
-        message.slaveBoltMsg.bolts[i].speedFactor = bolt->SpeedFactor;
-        message.slaveBoltMsg.bolts[i].quaternion[0] = bolt->Qcalc->quat[0];
-        message.slaveBoltMsg.bolts[i].quaternion[1] = bolt->Qcalc->quat[1];
-        message.slaveBoltMsg.bolts[i].quaternion[2] = bolt->Qcalc->quat[2];
-        message.slaveBoltMsg.bolts[i].quaternion[3] = bolt->Qcalc->quat[3];
-    }
-    if (message.slaveMsg.numBolts > 0)
+    for (i = 0; i < message.slaveMsg.numBolts; i++)
     {
-        delete newPlasmaBolts;
-        newPlasmaBolts = new PlasmaBoltSet();
+        newPlasmaBolts->getOrigin(i, message.slaveBoltMsg.bolts[i].position);
+        message.slaveBoltMsg.bolts[i].speed = newPlasmaBolts->getSpeed(i);
+        message.slaveBoltMsg.bolts[i].speedFactor = newPlasmaBolts->getSpeedFactor(i);
+        newPlasmaBolts->getQuaternion(i, message.slaveBoltMsg.bolts[i].quaternion);
     }
+    newPlasmaBolts->clear();
     if (!sendMessage()) return false;
     return true;
 }
@@ -0,0 +1,399 @@
+//***************************************************************************//
+//* File Name: particleSystem.hpp                                           *//
+//* Author:    Tom Portegys, portegys@ilstu.edu                             *//
+//* Date Made: 10/17/26                                                     *//
+//* File Desc: Class declaration and implementation details                 *//
+//*            representing a pool of particles added by any number of      *//
+//*            emitters and drawn together from one vertex buffer.          *//
+//* Rev. Date:                                                              *//
+//* Rev. Desc:                                                              *//
+//*                                                                         *//
+//***************************************************************************//
+
+#ifndef __PARTICLE_SYSTEM_HPP__
+#define __PARTICLE_SYSTEM_HPP__
+
+#ifndef UNIX
+#include <windows.h>
+#endif
+#include <stdlib.h>
+#include <math.h>
+#include <GL/gl.h>
+#ifndef NO_SSE
+#include <xmmintrin.h>
+#endif
+#include "mesh.hpp"
+#include "texture.hpp"
+#include "renderState.hpp"
+
+// Particle styles.
+#define PARTICLE_SPRITE 0                         // Quad facing the camera.
+#define PARTICLE_STREAK 1                         // Line along the velocity.
+
+// Particle vertex, in the GL_T2F_C4UB_V3F interleaved layout.
+struct ParticleVertex
+{
+    GLfloat s,t;
+    GLubyte color[4];
+    GLfloat x,y,z;
+};
+
+// Particle fields are held in parallel arrays, so that the update moves
+// four particles at a time. Live particles are kept at the front of the
+// arrays: a particle that dies is replaced by the last live particle.
+// Emitters add particles at any time, so that explosions and exhaust
+// streams share the pool; particles added to a full pool are dropped.
+// All particles are written to one vertex array each frame, streamed to
+// a buffer object when there are buffer objects, and drawn with one call
+// per style.
+class cParticleSystem
+{
+    public:
+
+        // Constructor: pool of the given size.
+        cParticleSystem(int maxParticles);
+
+        // Destructor.
+        ~cParticleSystem();
+
+        // Load sprite texture from TGA file.
+        // Textured sprites are decals over black at 0.7 alpha; sprites
+        // are drawn in their color if there is no texture.
+        bool loadTexture(const char *filename);
+
+        // Burst: sprites from a location, with random velocities up to
+        // speed along each axis and random lives fading by fade per frame.
+        void addBurst(GLfloat *location, int count, GLfloat speed, GLfloat size,
+            GLfloat fade, GLubyte *color);
+
+        // Streak from start to end, drawn until the next update.
+        void addStreak(GLfloat *start, GLfloat *end, GLubyte *color);
+
+        // Move and age particles by step frames, removing dead ones.
+        void update(GLfloat step);
+
+        // Draw particles: sprites face the camera of the camera matrix.
+        void draw(GLfloat *camera);
+
+        // Remove all particles.
+        void clear() { numParticles = 0; }
+
+        // Get number of live particles.
+        int getNumParticles() { return(numParticles); }
+
+        // Random numbers for emitters: > -1.0 && < 1.0, and >= 0.0 && < 1.0.
+        GLfloat randomUnit() { return(randomPositive() - randomPositive()); }
+        GLfloat randomPositive()
+        {
+            seed = (seed * 1664525) + 1013904223;
+            return((GLfloat)(seed >> 8) / 16777216.0);
+        }
+
+    private:
+
+        int maxParticles;
+        int numParticles;
+        GLfloat *x,*y,*z;
+        GLfloat *vx,*vy,*vz;
+        GLfloat *life,*fade,*size;
+        unsigned char *style;
+        GLubyte (*color)[4];
+        unsigned int seed;
+
+        // Vertices and their stream buffer.
+        struct ParticleVertex *vertices;
+        GLuint vertexBuffer;
+
+        // Sprite texture.
+        TextureImage texture;
+        bool textureLoaded;
+
+        int add();
+        void remove(int);
+};
+
+// Constructor.
+cParticleSystem::cParticleSystem(int maxParticles)
+{
+    this->maxParticles = maxParticles;
+    numParticles = 0;
+    x = new GLfloat[maxParticles];
+    y = new GLfloat[maxParticles];
+    z = new GLfloat[maxParticles];
+    vx = new GLfloat[maxParticles];
+    vy = new GLfloat[maxParticles];
+    vz = new GLfloat[maxParticles];
+    life = new GLfloat[maxParticles];
+    fade = new GLfloat[maxParticles];
+    size = new GLfloat[maxParticles];
+    style = new unsigned char[maxParticles];
+    color = new GLubyte[maxParticles][4];
+    seed = 1;
+
+    // Sprites need 4 vertices, streaks 2.
+    vertices = new struct ParticleVertex[maxParticles * 4];
+    vertexBuffer = 0;
+    cMesh::initBufferObjects();
+    if (cMesh::bufferObjects) cMesh::genBuffers(1, &vertexBuffer);
+    textureLoaded = false;
+}
+
+
+// Destructor.
+cParticleSystem::~cParticleSystem()
+{
+    delete [] x;
+    delete [] y;
+    delete [] z;
+    delete [] vx;
+    delete [] vy;
+    delete [] vz;
+    delete [] life;
+    delete [] fade;
+    delete [] size;
+    delete [] style;
+    delete [] color;
+    delete [] vertices;
+    if (vertexBuffer != 0) cMesh::deleteBuffers(1, &vertexBuffer);
+}
+
+
+// Load sprite texture.
+bool cParticleSystem::loadTexture(const char *filename)
+{
+    textureLoaded = LoadTGA(&texture, filename);
+    return(textureLoaded);
+}
+
+
+// Add a particle, returning its index, or -1 if the pool is full.
+int cParticleSystem::add()
+{
+    if (numParticles == maxParticles) return(-1);
+    return(numParticles++);
+}
+
+
+// Remove a particle, moving the last particle into its place.
+void cParticleSystem::remove(int i)
+{
+    int j;
+
+    numParticles--;
+    j = numParticles;
+    if (i == j) return;
+    x[i] = x[j];
+    y[i] = y[j];
+    z[i] = z[j];
+    vx[i] = vx[j];
+    vy[i] = vy[j];
+    vz[i] = vz[j];
+    life[i] = life[j];
+    fade[i] = fade[j];
+    size[i] = size[j];
+    style[i] = style[j];
+    color[i][0] = color[j][0];
+    color[i][1] = color[j][1];
+    color[i][2] = color[j][2];
+    color[i][3] = color[j][3];
+}
+
+
+// Add burst of sprites.
+void cParticleSystem::addBurst(GLfloat *location, int count, GLfloat speed, GLfloat size,
+GLfloat fade, GLubyte *color)
+{
+    int i,j;
+
+    for (i = 0; i < count; i++)
+    {
+        if ((j = add()) == -1) return;
+        x[j] = location[0];
+        y[j] = location[1];
+        z[j] = location[2];
+        vx[j] = randomUnit() * randomPositive() * speed;
+        vy[j] = randomUnit() * randomPositive() * speed;
+        vz[j] = randomUnit() * randomPositive() * speed;
+        life[j] = randomPositive();
+        this->fade[j] = fade;
+        this->size[j] = size;
+        style[j] = PARTICLE_SPRITE;
+        this->color[j][0] = color[0];
+        this->color[j][1] = color[1];
+        this->color[j][2] = color[2];
+        this->color[j][3] = color[3];
+    }
+}
+
+
+// Add streak.
+// It has no life left, so the next update removes it.
+void cParticleSystem::addStreak(GLfloat *start, GLfloat *end, GLubyte *color)
+{
+    int j;
+
+    if ((j = add()) == -1) return;
+    x[j] = start[0];
+    y[j] = start[1];
+    z[j] = start[2];
+    vx[j] = end[0] - start[0];
+    vy[j] = end[1] - start[1];
+    vz[j] = end[2] - start[2];
+    life[j] = 0.0;
+    fade[j] = 1.0;
+    size[j] = 1.0;
+    style[j] = PARTICLE_STREAK;
+    this->color[j][0] = color[0];
+    this->color[j][1] = color[1];
+    this->color[j][2] = color[2];
+    this->color[j][3] = color[3];
+}
+
+
+// Move and age particles.
+void cParticleSystem::update(GLfloat step)
+{
+    int i;
+
+    i = 0;
+#ifndef NO_SSE
+    __m128 s = _mm_set1_ps(step);
+    for ( ; i + 4 <= numParticles; i += 4)
+    {
+        _mm_storeu_ps(&x[i], _mm_add_ps(_mm_loadu_ps(&x[i]), _mm_mul_ps(_mm_loadu_ps(&vx[i]), s)));
+        _mm_storeu_ps(&y[i], _mm_add_ps(_mm_loadu_ps(&y[i]), _mm_mul_ps(_mm_loadu_ps(&vy[i]), s)));
+        _mm_storeu_ps(&z[i], _mm_add_ps(_mm_loadu_ps(&z[i]), _mm_mul_ps(_mm_loadu_ps(&vz[i]), s)));
+        _mm_storeu_ps(&life[i], _mm_sub_ps(_mm_loadu_ps(&life[i]),
+            _mm_mul_ps(_mm_loadu_ps(&fade[i]), s)));
+    }
+#endif
+    for ( ; i < numParticles; i++)
+    {
+        x[i] += vx[i] * step;
+        y[i] += vy[i] * step;
+        z[i] += vz[i] * step;
+        life[i] -= fade[i] * step;
+    }
+
+    // Remove dead particles.
+    for (i = 0; i < numParticles; )
+    {
+        if (life[i] <= 0.0) remove(i); else i++;
+    }
+}
+
+
+// Draw particles.
+void cParticleSystem::draw(GLfloat *camera)
+{
+    int i,j,k,numSpriteVertices,numVertices;
+    GLfloat r[3],u[3],d,w,h;
+    struct ParticleVertex *v;
+    const GLubyte *c;
+    static const GLfloat corners[4][2] =
+    {
+        { -1.0, -1.0 }, { 1.0, -1.0 }, { 1.0, 1.0 }, { -1.0, 1.0 }
+    };
+    static const GLubyte decalColor[4] = { 0, 0, 0, 178 };
+
+    if (numParticles == 0) return;
+
+    // Camera right and up vectors.
+    r[0] = camera[0];
+    r[1] = camera[4];
+    r[2] = camera[8];
+    u[0] = camera[1];
+    u[1] = camera[5];
+    u[2] = camera[9];
+    d = sqrt((r[0] * r[0]) + (r[1] * r[1]) + (r[2] * r[2]));
+    if (d > 0.0) { r[0] /= d; r[1] /= d; r[2] /= d; }
+    d = sqrt((u[0] * u[0]) + (u[1] * u[1]) + (u[2] * u[2]));
+    if (d > 0.0) { u[0] /= d; u[1] /= d; u[2] /= d; }
+
+    // Sprite vertices, then streak vertices.
+    v = vertices;
+    for (i = 0; i < numParticles; i++)
+    {
+        if (style[i] != PARTICLE_SPRITE) continue;
+        c = textureLoaded ? decalColor : color[i];
+        for (j = 0; j < 4; j++, v++)
+        {
+            w = corners[j][0] * size[i];
+            h = corners[j][1] * size[i];
+            v->s = (corners[j][0] + 1.0) * 0.5;
+            v->t = (corners[j][1] + 1.0) * 0.5;
+            for (k = 0; k < 4; k++) v->color[k] = c[k];
+            v->x = x[i] + (r[0] * w) + (u[0] * h);
+            v->y = y[i] + (r[1] * w) + (u[1] * h);
+            v->z = z[i] + (r[2] * w) + (u[2] * h);
+        }
+    }
+    numSpriteVertices = (int)(v - vertices);
+    for (i = 0; i < numParticles; i++)
+    {
+        if (style[i] != PARTICLE_STREAK) continue;
+        for (j = 0; j < 2; j++, v++)
+        {
+            v->s = v->t = 0.0;
+            for (k = 0; k < 4; k++) v->color[k] = color[i][k];
+            v->x = x[i] + (vx[i] * size[i] * j);
+            v->y = y[i] + (vy[i] * size[i] * j);
+            v->z = z[i] + (vz[i] * size[i] * j);
+        }
+    }
+    numVertices = (int)(v - vertices);
+
+    // Stream the vertices.
+    if (vertexBuffer != 0)
+    {
+        cMesh::bindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        cMesh::bufferData(GL_ARRAY_BUFFER, numVertices * sizeof(struct ParticleVertex),
+            vertices, GL_STREAM_DRAW);
+        glInterleavedArrays(GL_T2F_C4UB_V3F, 0, NULL);
+    }
+    else
+    {
+        glInterleavedArrays(GL_T2F_C4UB_V3F, 0, vertices);
+    }
+
+    // Sprites: glowing, and drawn over everything.
+    if (numSpriteVertices > 0)
+    {
+        glDepthMask(GL_FALSE);
+        glDisable(GL_DEPTH_TEST);
+        cRenderState::blendFunc(GL_SRC_ALPHA, GL_ONE);
+        cRenderState::enable(GL_BLEND);
+        cRenderState::disable(GL_LIGHTING);
+        if (textureLoaded)
+        {
+            cRenderState::shadeModel(GL_FLAT);
+            cRenderState::enable(GL_TEXTURE_2D);
+            cRenderState::texEnvMode(GL_DECAL);
+            cRenderState::bindTexture(texture.texID);
+        }
+        else
+        {
+            cRenderState::disable(GL_TEXTURE_2D);
+        }
+        glDrawArrays(GL_QUADS, 0, numSpriteVertices);
+        glEnable(GL_DEPTH_TEST);
+        glDepthMask(GL_TRUE);
+    }
+
+    // Streaks: blended lines.
+    if (numVertices > numSpriteVertices)
+    {
+        cRenderState::enable(GL_BLEND);
+        cRenderState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        cRenderState::disable(GL_TEXTURE_2D);
+        cRenderState::disable(GL_LIGHTING);
+        cRenderState::lineWidth(1.0);
+        glDrawArrays(GL_LINES, numSpriteVertices, numVertices - numSpriteVertices);
+    }
+
+    if (vertexBuffer != 0) cMesh::bindBuffer(GL_ARRAY_BUFFER, 0);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+}
+#endif                                            // #ifndef __PARTICLE_SYSTEM_HPP__
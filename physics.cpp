@@ -20,7 +20,17 @@ COPYRIGHT:	Copyright 2000-2001 by David Bourg
 #include "physics.h"
 #include <iostream>
 #include <memory.h>
+#include <new>
 #include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#ifndef NO_SSE
+#include <xmmintrin.h>
+#endif
+#ifdef UNIX
+#include <pthread.h>
+#endif
 #include <GL/gl.h>
 #include <GL/glu.h>
 #include "glaux.h"
@@ -29,17 +39,160 @@ COPYRIGHT:	Copyright 2000-2001 by David Bourg
 // Global variables
 //------------------------------------------------------------------------//
 
-RigidBody   Bodies[MAX_BODIES + 1];
+RigidBody   *Bodies = NULL;
 int         NumBodies = 0;
-Collision   Collisions[(MAX_BODIES + 1) * 8];
+int         MaxBodies = 0;
+int         *ActiveBodies = NULL;
+int         NumActiveBodies = 0;
+int         ActiveBodiesVersion = 0;
+int         *AwakeBodies = NULL;
+int         NumAwakeBodies = 0;
+int         *ActiveSlots = NULL;
+Collision   *Collisions = NULL;
 int         NumCollisions = 0;
+int         MaxCollisions = 0;
+BodyCache   *BodyCaches = NULL;
+
+static bool ReserveBodyStates(int count);
+static bool ReserveSweep(int count);
+static void ResetSweep(void);
+static bool ReserveIslands(int count);
+
+//------------------------------------------------------------------------//
+// Grow an array to hold at least count entries, keeping its contents.
+// Returns: false, leaving the array as it was, if out of memory.
+//------------------------------------------------------------------------//
+template <class T> static bool GrowArray(T *&array, int size, int count)
+{
+    T   *a;
+    int i;
+
+    a = new (std::nothrow) T[count];
+    if (a == NULL) return false;
+    for (i = 0; i < size; i++) a[i] = array[i];
+    delete [] array;
+    array = a;
+    return true;
+}
+
 
 //------------------------------------------------------------------------//
 // This function initializes the global data.
+// The body pool starts with room for maxBodies bodies and grows on demand.
+//------------------------------------------------------------------------//
+void    InitializePhysics(int maxBodies)
+{
+    delete [] Bodies;
+    delete [] ActiveBodies;
+    delete [] AwakeBodies;
+    delete [] ActiveSlots;
+    delete [] Collisions;
+    delete [] BodyCaches;
+    Bodies = NULL;
+    ActiveBodies = AwakeBodies = ActiveSlots = NULL;
+    Collisions = NULL;
+    BodyCaches = NULL;
+    NumBodies = MaxBodies = 0;
+    NumActiveBodies = NumAwakeBodies = 0;
+    NumCollisions = MaxCollisions = 0;
+    ActiveBodiesVersion++;
+    ResetSweep();
+
+    if (maxBodies < 1) maxBodies = 1;
+    ReserveBodies(maxBodies);
+    ReserveCollisions(maxBodies * 8);
+}
+
+
+//------------------------------------------------------------------------//
+// Make room for count bodies.
+// Bodies has one more slot, an invalid body of no group, so that loops
+// over a group may read the body after the last before checking
+// NumBodies.
+//------------------------------------------------------------------------//
+bool    ReserveBodies(int count)
+{
+    int i, n;
+
+    if (count <= MaxBodies) return true;
+    n = MaxBodies * 2;
+    if (n < count) n = count;
+
+    if (!GrowArray(Bodies, MaxBodies, n + 1)) return false;
+    if (!GrowArray(BodyCaches, MaxBodies, n)) return false;
+    if (!GrowArray(ActiveBodies, NumActiveBodies, n)) return false;
+    if (!GrowArray(AwakeBodies, NumAwakeBodies, n)) return false;
+    if (!GrowArray(ActiveSlots, MaxBodies, n)) return false;
+    if (!ReserveBodyStates(n)) return false;
+    if (!ReserveSweep(n)) return false;
+    if (!ReserveIslands(n)) return false;
+    for (i = MaxBodies; i < n; i++)
+    {
+        Bodies[i].valid = false;
+        Bodies[i].group = -1;
+        BodyCaches[i].current = false;
+        ActiveSlots[i] = -1;
+    }
+    Bodies[n].valid = false;
+    Bodies[n].group = -1;
+    MaxBodies = n;
+    return true;
+}
+
+
+//------------------------------------------------------------------------//
+// Make room for count collisions.
+//------------------------------------------------------------------------//
+bool    ReserveCollisions(int count)
+{
+    int n;
+
+    if (count <= MaxCollisions) return true;
+    n = MaxCollisions * 2;
+    if (n < count) n = count;
+    if (!GrowArray(Collisions, NumCollisions, n)) return false;
+    MaxCollisions = n;
+    return true;
+}
+
+
+//------------------------------------------------------------------------//
+// Enable or disable a body.
+// The active list is kept in index order so that iterating it
+// visits bodies in the same order as scanning the whole array.
 //------------------------------------------------------------------------//
-void    InitializePhysics()
+void    SetBodyValid(int index, bool valid)
 {
-    for (int i = 0; i < MAX_BODIES + 1; i++) Bodies[i].valid = false;
+    int i;
+
+    Bodies[index].valid = valid;
+    if (valid)
+    {
+        BodyCaches[index].current = false;
+        WakeBody(index);
+        if (ActiveSlots[index] != -1) return;
+        for (i = NumActiveBodies; i > 0 && ActiveBodies[i - 1] > index; i--)
+        {
+            ActiveBodies[i] = ActiveBodies[i - 1];
+            ActiveSlots[ActiveBodies[i]] = i;
+        }
+        ActiveBodies[i] = index;
+        ActiveSlots[index] = i;
+        NumActiveBodies++;
+    }
+    else
+    {
+        if (ActiveSlots[index] == -1) return;
+        for (i = ActiveSlots[index]; i < NumActiveBodies - 1; i++)
+        {
+            ActiveBodies[i] = ActiveBodies[i + 1];
+            ActiveSlots[ActiveBodies[i]] = i;
+        }
+        ActiveSlots[index] = -1;
+        NumActiveBodies--;
+    }
+    ActiveBodiesVersion++;
+    StaticBVHDirty = true;
 }
 
 
@@ -48,10 +201,11 @@ void    InitializePhysics()
 //------------------------------------------------------------------------//
 void    InitializeObject(int i, float size, int type, int group)
 {
-    if (i >= MAX_BODIES) return;
+    if (i < 0 || !ReserveBodies(i + 1)) return;
     if (i >= NumBodies) NumBodies = i + 1;
 
     InitializeObject(&Bodies[i], size, type, group);
+    SetBodyValid(i, true);
 }
 
 
@@ -157,20 +311,24 @@ void    InitializeObject(RigidBody *body, float size, int type, int group)
     body->type = type;
     body->group = group;
     body->exempt = -1;
+    body->previousStep = -1;
+    body->asleep = false;
+    body->restTime = 0.0f;
 }
 
 
 //------------------------------------------------------------------------//
 // This function clears all of the forces and moments.
+// Only the awake bodies listed by ListAwakeBodies are cleared.
 //------------------------------------------------------------------------//
 void    ClearObjectForces(void)
 {
     Vector  Fb, Mb;
-    int     i;
+    int     i,k;
 
-    for(i=0; i<NumBodies; i++)
+    for(k=0; k<NumAwakeBodies; k++)
     {
-        if (!Bodies[i].valid) continue;
+        i = AwakeBodies[k];
 
         // reset forces and moments:
         Bodies[i].vForces.x = 0.0f;
@@ -201,209 +359,1554 @@ void    ClearObjectForces(void)
 
 
 //------------------------------------------------------------------------//
-//  Using Euler's method
+// Make room for count lanes of SoA state.
+// All of the arrays are carved out of one block, each 16-byte aligned.
+//------------------------------------------------------------------------//
+BodyState   BodyStates;
+
+static bool ReserveBodyStates(int count)
+{
+    int     i, n;
+    char    *block, *p;
+    float   **arrays[] =
+    {
+        &BodyStates.px, &BodyStates.py, &BodyStates.pz,
+        &BodyStates.vx, &BodyStates.vy, &BodyStates.vz,
+        &BodyStates.ax, &BodyStates.ay, &BodyStates.az,
+        &BodyStates.wx, &BodyStates.wy, &BodyStates.wz,
+        &BodyStates.alx, &BodyStates.aly, &BodyStates.alz,
+        &BodyStates.qn, &BodyStates.qx, &BodyStates.qy, &BodyStates.qz,
+        &BodyStates.speed,
+        &BodyStates.minV, &BodyStates.maxV, &BodyStates.minW, &BodyStates.maxW
+    };
+    int     numArrays = sizeof(arrays) / sizeof(arrays[0]);
+
+    n = (count + 3) & ~3;
+    if (n <= BodyStates.capacity) return true;
+    block = (char *)malloc((n * sizeof(float) * numArrays) + 16);
+    if (block == NULL) return false;
+    p = (char *)(((size_t)block + 15) & ~(size_t)15);
+    for (i = 0; i < numArrays; i++)
+    {
+        *arrays[i] = (float *)p;
+        p += n * sizeof(float);
+    }
+    free(BodyStates.block);
+    BodyStates.block = block;
+    BodyStates.capacity = n;
+    BodyStates.count = 0;
+    return true;
+}
+
+
+//------------------------------------------------------------------------//
+// Copy the integration state of the awake bodies into the SoA arrays.
+// Lane k holds body AwakeBodies[k].
+//------------------------------------------------------------------------//
+void    GatherBodyStates(void)
+{
+    int i,k;
+
+    BodyStates.count = (NumAwakeBodies + 3) & ~3;
+    for(k=0; k<BodyStates.count; k++)
+    {
+        if (k >= NumAwakeBodies)
+        {
+            // Padding lanes integrate to nothing.
+            BodyStates.px[k] = BodyStates.py[k] = BodyStates.pz[k] = 0.0f;
+            BodyStates.vx[k] = BodyStates.vy[k] = BodyStates.vz[k] = 0.0f;
+            BodyStates.ax[k] = BodyStates.ay[k] = BodyStates.az[k] = 0.0f;
+            BodyStates.wx[k] = BodyStates.wy[k] = BodyStates.wz[k] = 0.0f;
+            BodyStates.alx[k] = BodyStates.aly[k] = BodyStates.alz[k] = 0.0f;
+            BodyStates.qn[k] = 1.0f;
+            BodyStates.qx[k] = BodyStates.qy[k] = BodyStates.qz[k] = 0.0f;
+            BodyStates.minV[k] = BodyStates.minW[k] = 0.0f;
+            BodyStates.maxV[k] = BodyStates.maxW[k] = 1.0f;
+            continue;
+        }
+        i = AwakeBodies[k];
+        BodyStates.px[k] = Bodies[i].vPosition.x;
+        BodyStates.py[k] = Bodies[i].vPosition.y;
+        BodyStates.pz[k] = Bodies[i].vPosition.z;
+        BodyStates.vx[k] = Bodies[i].vVelocity.x;
+        BodyStates.vy[k] = Bodies[i].vVelocity.y;
+        BodyStates.vz[k] = Bodies[i].vVelocity.z;
+        BodyStates.ax[k] = Bodies[i].vAcceleration.x;
+        BodyStates.ay[k] = Bodies[i].vAcceleration.y;
+        BodyStates.az[k] = Bodies[i].vAcceleration.z;
+        BodyStates.wx[k] = Bodies[i].vAngularVelocity.x;
+        BodyStates.wy[k] = Bodies[i].vAngularVelocity.y;
+        BodyStates.wz[k] = Bodies[i].vAngularVelocity.z;
+        BodyStates.alx[k] = Bodies[i].vAngularAcceleration.x;
+        BodyStates.aly[k] = Bodies[i].vAngularAcceleration.y;
+        BodyStates.alz[k] = Bodies[i].vAngularAcceleration.z;
+        BodyStates.qn[k] = Bodies[i].qOrientation.n;
+        BodyStates.qx[k] = Bodies[i].qOrientation.v.x;
+        BodyStates.qy[k] = Bodies[i].qOrientation.v.y;
+        BodyStates.qz[k] = Bodies[i].qOrientation.v.z;
+
+        // A zero minimum never clamps.
+        if (Bodies[i].type == XWING_BLOCK_TYPE || Bodies[i].type == SQUID_BLOCK_TYPE)
+        {
+            BodyStates.minV[k] = MIN_OBJECT_VELOCITY;
+            BodyStates.maxV[k] = MAX_OBJECT_VELOCITY;
+            BodyStates.minW[k] = MIN_OBJECT_ANGULAR_VELOCITY;
+            BodyStates.maxW[k] = MAX_OBJECT_ANGULAR_VELOCITY;
+        }
+        else
+        {
+            BodyStates.minV[k] = 0.0f;
+            BodyStates.maxV[k] = MAX_VELOCITY;
+            BodyStates.minW[k] = 0.0f;
+            BodyStates.maxW[k] = MAX_ANGULAR_VELOCITY;
+        }
+    }
+}
+
+
+//------------------------------------------------------------------------//
+// Copy the integrated state back into the bodies.
+//------------------------------------------------------------------------//
+void    ScatterBodyStates(void)
+{
+    int i,k;
+    Vector u;
+
+    for(k=0; k<NumAwakeBodies; k++)
+    {
+        i = AwakeBodies[k];
+
+        Bodies[i].vPosition.x = BodyStates.px[k];
+        Bodies[i].vPosition.y = BodyStates.py[k];
+        Bodies[i].vPosition.z = BodyStates.pz[k];
+        Bodies[i].vVelocity.x = BodyStates.vx[k];
+        Bodies[i].vVelocity.y = BodyStates.vy[k];
+        Bodies[i].vVelocity.z = BodyStates.vz[k];
+        Bodies[i].vAngularVelocity.x = BodyStates.wx[k];
+        Bodies[i].vAngularVelocity.y = BodyStates.wy[k];
+        Bodies[i].vAngularVelocity.z = BodyStates.wz[k];
+        Bodies[i].qOrientation.n = BodyStates.qn[k];
+        Bodies[i].qOrientation.v.x = BodyStates.qx[k];
+        Bodies[i].qOrientation.v.y = BodyStates.qy[k];
+        Bodies[i].qOrientation.v.z = BodyStates.qz[k];
+        Bodies[i].fSpeed = BodyStates.speed[k];
+
+        // calculate the velocity in body space:
+        Bodies[i].vVelocityBody = QVRotate(~Bodies[i].qOrientation, Bodies[i].vVelocity);
+
+        // get the Euler angles for our information
+        u = MakeEulerAnglesFromQ(Bodies[i].qOrientation);
+        Bodies[i].vEulerAngles.x = u.x;           // roll
+        Bodies[i].vEulerAngles.y = u.y;           // pitch
+        Bodies[i].vEulerAngles.z = u.z;           // yaw
+    }
+}
+
+
+#ifndef NO_SSE
+//------------------------------------------------------------------------//
+// Clamp the magnitudes of four vectors to [minMag, maxMag],
+// as Vector::Normalize(float) would.
+//------------------------------------------------------------------------//
+static inline void ClampMagnitude4(__m128 &x, __m128 &y, __m128 &z,
+__m128 minMag, __m128 maxMag)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 eps = _mm_set1_ps(tol);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 m, over, under, apply, target, s;
+
+    m = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+    over = _mm_cmpgt_ps(m, maxMag);
+    under = _mm_andnot_ps(over, _mm_cmplt_ps(m, minMag));
+    apply = _mm_or_ps(over, under);
+    if (_mm_movemask_ps(apply) == 0) return;
+
+    target = _mm_or_ps(_mm_and_ps(over, maxMag), _mm_and_ps(under, minMag));
+    m = _mm_or_ps(_mm_and_ps(_mm_cmple_ps(m, eps), one), _mm_andnot_ps(_mm_cmple_ps(m, eps), m));
+    s = _mm_div_ps(target, m);
+
+    // Scale, then flush components below tolerance to zero.
+    s = _mm_or_ps(_mm_and_ps(apply, s), _mm_andnot_ps(apply, one));
+    x = _mm_mul_ps(x, s);
+    y = _mm_mul_ps(y, s);
+    z = _mm_mul_ps(z, s);
+    x = _mm_andnot_ps(_mm_and_ps(apply, _mm_cmplt_ps(_mm_andnot_ps(sign, x), eps)), x);
+    y = _mm_andnot_ps(_mm_and_ps(apply, _mm_cmplt_ps(_mm_andnot_ps(sign, y), eps)), y);
+    z = _mm_andnot_ps(_mm_and_ps(apply, _mm_cmplt_ps(_mm_andnot_ps(sign, z), eps)), z);
+}
+#endif
+
+
+//------------------------------------------------------------------------//
+// Euler step of the SoA state: velocity, clamping, position,
+// angular velocity, orientation and its normalization.
+//------------------------------------------------------------------------//
+void    IntegrateBodyStates(float dt)
+{
+    int i;
+
+#ifndef NO_SSE
+    const __m128 vdt = _mm_set1_ps(dt);
+    const __m128 hdt = _mm_set1_ps(0.5f * dt);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128 x, y, z, wx, wy, wz, qn, qx, qy, qz, dn, dx, dy, dz, mag, nz;
+
+    for(i=0; i<BodyStates.count; i += 4)
+    {
+        // calculate the velocity of the object in earth space:
+        x = _mm_add_ps(_mm_load_ps(&BodyStates.vx[i]), _mm_mul_ps(_mm_load_ps(&BodyStates.ax[i]), vdt));
+        y = _mm_add_ps(_mm_load_ps(&BodyStates.vy[i]), _mm_mul_ps(_mm_load_ps(&BodyStates.ay[i]), vdt));
+        z = _mm_add_ps(_mm_load_ps(&BodyStates.vz[i]), _mm_mul_ps(_mm_load_ps(&BodyStates.az[i]), vdt));
+        ClampMagnitude4(x, y, z, _mm_load_ps(&BodyStates.minV[i]), _mm_load_ps(&BodyStates.maxV[i]));
+        _mm_store_ps(&BodyStates.vx[i], x);
+        _mm_store_ps(&BodyStates.vy[i], y);
+        _mm_store_ps(&BodyStates.vz[i], z);
+        _mm_store_ps(&BodyStates.speed[i],
+            _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z))));
+
+        // calculate the position of the object in earth space:
+        _mm_store_ps(&BodyStates.px[i], _mm_add_ps(_mm_load_ps(&BodyStates.px[i]), _mm_mul_ps(x, vdt)));
+        _mm_store_ps(&BodyStates.py[i], _mm_add_ps(_mm_load_ps(&BodyStates.py[i]), _mm_mul_ps(y, vdt)));
+        _mm_store_ps(&BodyStates.pz[i], _mm_add_ps(_mm_load_ps(&BodyStates.pz[i]), _mm_mul_ps(z, vdt)));
+
+        // Now handle the rotations:
+        wx = _mm_add_ps(_mm_load_ps(&BodyStates.wx[i]), _mm_mul_ps(_mm_load_ps(&BodyStates.alx[i]), vdt));
+        wy = _mm_add_ps(_mm_load_ps(&BodyStates.wy[i]), _mm_mul_ps(_mm_load_ps(&BodyStates.aly[i]), vdt));
+        wz = _mm_add_ps(_mm_load_ps(&BodyStates.wz[i]), _mm_mul_ps(_mm_load_ps(&BodyStates.alz[i]), vdt));
+        ClampMagnitude4(wx, wy, wz, _mm_load_ps(&BodyStates.minW[i]), _mm_load_ps(&BodyStates.maxW[i]));
+        _mm_store_ps(&BodyStates.wx[i], wx);
+        _mm_store_ps(&BodyStates.wy[i], wy);
+        _mm_store_ps(&BodyStates.wz[i], wz);
+
+        // calculate the new rotation quaternion: q += (q * w) * dt/2
+        qn = _mm_load_ps(&BodyStates.qn[i]);
+        qx = _mm_load_ps(&BodyStates.qx[i]);
+        qy = _mm_load_ps(&BodyStates.qy[i]);
+        qz = _mm_load_ps(&BodyStates.qz[i]);
+        dn = _mm_sub_ps(zero, _mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, wx), _mm_mul_ps(qy, wy)), _mm_mul_ps(qz, wz)));
+        dx = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(qn, wx), _mm_mul_ps(qy, wz)), _mm_mul_ps(qz, wy));
+        dy = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(qn, wy), _mm_mul_ps(qz, wx)), _mm_mul_ps(qx, wz));
+        dz = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(qn, wz), _mm_mul_ps(qx, wy)), _mm_mul_ps(qy, wx));
+        qn = _mm_add_ps(qn, _mm_mul_ps(dn, hdt));
+        qx = _mm_add_ps(qx, _mm_mul_ps(dx, hdt));
+        qy = _mm_add_ps(qy, _mm_mul_ps(dy, hdt));
+        qz = _mm_add_ps(qz, _mm_mul_ps(dz, hdt));
+
+        // now normalize the orientation quaternion:
+        mag = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(qn, qn), _mm_mul_ps(qx, qx)),
+            _mm_add_ps(_mm_mul_ps(qy, qy), _mm_mul_ps(qz, qz))));
+        nz = _mm_cmpneq_ps(mag, zero);
+        mag = _mm_or_ps(_mm_and_ps(nz, mag), _mm_andnot_ps(nz, one));
+        _mm_store_ps(&BodyStates.qn[i], _mm_div_ps(qn, mag));
+        _mm_store_ps(&BodyStates.qx[i], _mm_div_ps(qx, mag));
+        _mm_store_ps(&BodyStates.qy[i], _mm_div_ps(qy, mag));
+        _mm_store_ps(&BodyStates.qz[i], _mm_div_ps(qz, mag));
+    }
+#else
+    Vector v, w;
+    Quaternion q;
+    float mag;
+
+    for(i=0; i<BodyStates.count; i++)
+    {
+        v = Vector(BodyStates.vx[i], BodyStates.vy[i], BodyStates.vz[i]);
+        v += Vector(BodyStates.ax[i], BodyStates.ay[i], BodyStates.az[i]) * dt;
+        if (v.Magnitude() > BodyStates.maxV[i])
+        {
+            v.Normalize(BodyStates.maxV[i]);
+        } else if (v.Magnitude() < BodyStates.minV[i])
+        {
+            v.Normalize(BodyStates.minV[i]);
+        }
+        BodyStates.vx[i] = v.x;
+        BodyStates.vy[i] = v.y;
+        BodyStates.vz[i] = v.z;
+        BodyStates.speed[i] = v.Magnitude();
+        BodyStates.px[i] += v.x * dt;
+        BodyStates.py[i] += v.y * dt;
+        BodyStates.pz[i] += v.z * dt;
+
+        w = Vector(BodyStates.wx[i], BodyStates.wy[i], BodyStates.wz[i]);
+        w += Vector(BodyStates.alx[i], BodyStates.aly[i], BodyStates.alz[i]) * dt;
+        if (w.Magnitude() > BodyStates.maxW[i])
+        {
+            w.Normalize(BodyStates.maxW[i]);
+        } else if (w.Magnitude() < BodyStates.minW[i])
+        {
+            w.Normalize(BodyStates.minW[i]);
+        }
+        BodyStates.wx[i] = w.x;
+        BodyStates.wy[i] = w.y;
+        BodyStates.wz[i] = w.z;
+
+        q = Quaternion(BodyStates.qn[i], BodyStates.qx[i], BodyStates.qy[i], BodyStates.qz[i]);
+        q += (q * w) * (0.5f * dt);
+        mag = q.Magnitude();
+        if (mag != 0)
+            q /= mag;
+        BodyStates.qn[i] = q.n;
+        BodyStates.qx[i] = q.v.x;
+        BodyStates.qy[i] = q.v.y;
+        BodyStates.qz[i] = q.v.z;
+    }
+#endif
+}
+
+
+//------------------------------------------------------------------------//
+// Sleeping bodies.
+// A block that has moved slower than the sleep thresholds for SLEEP_TIME
+// may sleep: it is not integrated and is only checked for collisions
+// against awake bodies. Bodies in contact form an island, which sleeps
+// only when all of its bodies may, and wakes as a whole when any of them
+// is hit or pushed. Walls and fixed blocks never move and always sleep.
 //------------------------------------------------------------------------//
-void    StepSimulation(float dtime)
+bool    BodySleeping = true;
+int     NumSleepingBodies = 0;
+int     NumIslands = 0;
+int     *IslandParent = NULL;
+bool    *IslandQuiet = NULL;
+
+static bool ReserveIslands(int count)
+{
+    if (!GrowArray(IslandParent, MaxBodies, count)) return false;
+    if (!GrowArray(IslandQuiet, MaxBodies, count)) return false;
+    return true;
+}
+
+
+// List the active bodies that are awake.
+void    ListAwakeBodies(void)
+{
+    int i,k;
+
+    for(k=NumAwakeBodies=0; k<NumActiveBodies; k++)
+    {
+        i = ActiveBodies[k];
+        if (!Bodies[i].asleep) AwakeBodies[NumAwakeBodies++] = i;
+    }
+}
+
+
+// Wake a body up.
+void    WakeBody(int index)
+{
+    Bodies[index].asleep = false;
+    Bodies[index].restTime = 0.0f;
+}
+
+
+static bool IsStatic(int i)
+{
+    return Bodies[i].type == WALL_TYPE || Bodies[i].type == FIXED_BLOCK_TYPE;
+}
+
+
+static bool IsResting(int i)
+{
+    return Bodies[i].vVelocity.Magnitude() < SLEEP_VELOCITY &&
+        Bodies[i].vAngularVelocity.Magnitude() < SLEEP_ANGULAR_VELOCITY;
+}
+
+
+static int FindIsland(int i)
+{
+    while (IslandParent[i] != i)
+    {
+        IslandParent[i] = IslandParent[IslandParent[i]];
+        i = IslandParent[i];
+    }
+    return i;
+}
+
+
+static void UpdateSleep(float dt)
 {
+    int     i,j,k;
+    RigidBody *body;
+
+    NumSleepingBodies = NumIslands = 0;
+
+    // Sleeping turned off: wake the sleeping blocks.
+    if (!BodySleeping)
+    {
+        for(k=0; k<NumActiveBodies; k++)
+        {
+            i = ActiveBodies[k];
+            if (!IsStatic(i) && Bodies[i].asleep) WakeBody(i);
+        }
+        return;
+    }
+
+    // Join bodies in contact into islands.
+    for(k=0; k<NumActiveBodies; k++)
+    {
+        i = ActiveBodies[k];
+        IslandParent[i] = i;
+        IslandQuiet[i] = true;
+    }
+    for(k=0; k<NumCollisions; k++)
+    {
+        i = Collisions[k].body1;
+        j = Collisions[k].body2;
+        if (IsStatic(i) || IsStatic(j)) continue;
+        i = FindIsland(i);
+        j = FindIsland(j);
+        if (i != j) IslandParent[i] = j;
+    }
+
+    // An island is quiet if all of its blocks have rested long enough.
+    // A sleeping body that is no longer resting was pushed.
+    for(k=0; k<NumActiveBodies; k++)
+    {
+        i = ActiveBodies[k];
+        body = &Bodies[i];
+        if (IsStatic(i)) continue;
+        if (body->type == BLOCK_TYPE && IsResting(i))
+        {
+            if (!body->asleep) body->restTime += dt;
+        }
+        else
+        {
+            body->restTime = 0.0f;
+        }
+        if (body->restTime < SLEEP_TIME) IslandQuiet[FindIsland(i)] = false;
+    }
+
+    for(k=0; k<NumActiveBodies; k++)
+    {
+        i = ActiveBodies[k];
+        body = &Bodies[i];
+        if (IsStatic(i))
+        {
+            body->asleep = true;
+            NumSleepingBodies++;
+            continue;
+        }
+        if (FindIsland(i) == i) NumIslands++;
+        if (!IslandQuiet[FindIsland(i)])
+        {
+            if (body->asleep) WakeBody(i);
+            continue;
+        }
+        if (!body->asleep)
+        {
+            // Come to rest.
+            body->asleep = true;
+            body->vVelocity = Vector(0.0f, 0.0f, 0.0f);
+            body->vVelocityBody = Vector(0.0f, 0.0f, 0.0f);
+            body->vAngularVelocity = Vector(0.0f, 0.0f, 0.0f);
+            body->fSpeed = 0.0f;
+        }
+        NumSleepingBodies++;
+    }
+}
 
-    Vector Ae;
-    int     i,j;
+
+//------------------------------------------------------------------------//
+//  Using Euler's method
+//------------------------------------------------------------------------//
+void    StepSimulation(float dtime, bool clearCollisions)
+{
+    int     i,j,k,end;
     float   dt = dtime;
 
+    if (clearCollisions)
+    {
+        for(k=0; k<NumActiveBodies; k++)
+        {
+            Bodies[ActiveBodies[k]].collision = false;
+        }
+    }
+
+    // Sleeping bodies are not integrated.
+    ListAwakeBodies();
+
     // Clear all of the forces and moments.
     ClearObjectForces();
 
-    // Integrate
-    for(i=0; i<NumBodies; i++)
+    for(k=0; k<NumAwakeBodies; k++)
     {
-        if (!Bodies[i].valid) continue;
-        Bodies[i].collision = false;
+        i = AwakeBodies[k];
 
         // calculate the acceleration of the object in earth space:
-        Ae = Bodies[i].vForces / Bodies[i].fMass;
-        Bodies[i].vAcceleration = Ae;
+        Bodies[i].vAcceleration = Bodies[i].vForces / Bodies[i].fMass;
+        Bodies[i].vAngularAcceleration = Bodies[i].mInertiaInverse *
+            (Bodies[i].vMoments -
+            (Bodies[i].vAngularVelocity^
+            (Bodies[i].mInertia * Bodies[i].vAngularVelocity)));
+    }
 
-        // calculate the velocity of the object in earth space:
-        Bodies[i].vVelocity += Ae * dt;
-        if (Bodies[i].type == XWING_BLOCK_TYPE || Bodies[i].type == SQUID_BLOCK_TYPE)
+    // Integrate
+    GatherBodyStates();
+    IntegrateBodyStates(dt);
+    ScatterBodyStates();
+
+    // Move groups uniformly.
+    for (k = end = 0; k < NumActiveBodies; k++)
+    {
+        i = ActiveBodies[k];
+        if (i < end || Bodies[i].group == -1) continue;
+
+        for (j = i; Bodies[j].group == Bodies[i].group && j < NumBodies; j++)
         {
-            if (Bodies[i].vVelocity.Magnitude() > MAX_OBJECT_VELOCITY)
-            {
-                Bodies[i].vVelocity.Normalize(MAX_OBJECT_VELOCITY);
-            } else if (Bodies[i].vVelocity.Magnitude() < MIN_OBJECT_VELOCITY)
+            Bodies[j].vAcceleration = Bodies[i].vAcceleration;
+            Bodies[j].vVelocity = Bodies[i].vVelocity;
+            Bodies[j].vPosition = Bodies[i].vPosition;
+            Bodies[j].vAngularAcceleration = Bodies[i].vAngularAcceleration;
+            Bodies[j].vAngularVelocity = Bodies[i].vAngularVelocity;
+            Bodies[j].qOrientation = Bodies[i].qOrientation;
+            Bodies[j].vVelocityBody = Bodies[i].vVelocityBody;
+            Bodies[j].fSpeed = Bodies[i].fSpeed;
+            Bodies[j].vEulerAngles.x = Bodies[i].vEulerAngles.x;
+            Bodies[j].vEulerAngles.y = Bodies[i].vEulerAngles.y;
+            Bodies[j].vEulerAngles.z = Bodies[i].vEulerAngles.z;
+        }
+        end = j;
+    }
+
+    // Transform bounding vertices once for this step.
+    UpdateBodyCache();
+
+    // Handle Collisions
+    if(CheckForCollisions() == COLLISION)
+    {
+        ResolveCollisions(dt);
+    }
+
+    // Put resting islands to sleep and wake disturbed ones.
+    UpdateSleep(dt);
+}
+
+
+//------------------------------------------------------------------------//
+// Fixed time step simulation.
+// The elapsed time is added to an accumulator, which is then run off in
+// whole steps of FixedTimeStep, each split into NumSubsteps calls of
+// StepSimulation. At most MaxStepsPerFrame steps are run; time beyond
+// that is dropped rather than carried into later frames. StepAlpha is
+// the time left over as a fraction of a step.
+// Collision flags cover all of the steps run.
+// Returns: number of fixed steps run.
+//------------------------------------------------------------------------//
+float   FixedTimeStep = DEFAULT_FIXED_TIME_STEP;
+int     NumSubsteps = DEFAULT_SUBSTEPS;
+int     MaxStepsPerFrame = DEFAULT_MAX_STEPS_PER_FRAME;
+float   StepAlpha = 1.0f;
+int     SimulationSteps = 0;
+float   StepAccumulator = 0.0f;
+
+int     AdvanceSimulation(float dtime)
+{
+    int     i,k,s,steps;
+    float   dt;
+
+    if (FixedTimeStep <= 0.0f) return 0;
+    if (NumSubsteps < 1) NumSubsteps = 1;
+    dt = FixedTimeStep / (float)NumSubsteps;
+
+    StepAccumulator += dtime;
+    for (steps = 0; StepAccumulator >= FixedTimeStep && steps < MaxStepsPerFrame; steps++)
+    {
+        // Save the state to interpolate from.
+        SimulationSteps++;
+        for(k=0; k<NumActiveBodies; k++)
+        {
+            i = ActiveBodies[k];
+            Bodies[i].vPreviousPosition = Bodies[i].vPosition;
+            Bodies[i].qPreviousOrientation = Bodies[i].qOrientation;
+            Bodies[i].previousStep = SimulationSteps;
+        }
+
+        for (s = 0; s < NumSubsteps; s++)
+        {
+            StepSimulation(dt, steps == 0 && s == 0);
+        }
+        StepAccumulator -= FixedTimeStep;
+    }
+
+    // No step, no new collisions.
+    if (steps == 0)
+    {
+        for(k=0; k<NumActiveBodies; k++)
+        {
+            Bodies[ActiveBodies[k]].collision = false;
+        }
+    }
+
+    // Fell behind: drop the whole steps that did not fit.
+    if (StepAccumulator >= FixedTimeStep)
+    {
+        StepAccumulator -= (float)floor(StepAccumulator / FixedTimeStep) * FixedTimeStep;
+    }
+    StepAlpha = StepAccumulator / FixedTimeStep;
+    return steps;
+}
+
+
+//------------------------------------------------------------------------//
+// Get the position and orientation of a body StepAlpha of the way from
+// its state before the last fixed step to its current state.
+//------------------------------------------------------------------------//
+void    InterpolateBody(int index, Vector *position, Quaternion *orientation)
+{
+    RigidBody   *body = &Bodies[index];
+    Quaternion  q0, q1;
+    float       a, mag;
+
+    if (body->previousStep != SimulationSteps || StepAlpha >= 1.0f)
+    {
+        *position = body->vPosition;
+        *orientation = body->qOrientation;
+        return;
+    }
+
+    a = StepAlpha;
+    *position = body->vPreviousPosition + ((body->vPosition - body->vPreviousPosition) * a);
+
+    // Normalized linear blend along the shorter arc.
+    q0 = body->qPreviousOrientation;
+    q1 = body->qOrientation;
+    if ((q0.n * q1.n) + (q0.v * q1.v) < 0.0f) q1 = q1 * -1.0f;
+    *orientation = (q0 * (1.0f - a)) + (q1 * a);
+    mag = orientation->Magnitude();
+    if (mag != 0) *orientation /= mag;
+}
+
+
+//------------------------------------------------------------------------//
+// Broadphase: sweep and prune over the bounding sphere extents.
+// The sweep list is kept between steps so that the insertion sort
+// only has to repair the few bodies that changed places.
+//------------------------------------------------------------------------//
+int         *SweepList = NULL;
+float       *SweepMin = NULL;
+int         NumSweep = 0;
+int         SweepVersion = -1;
+bool        SweepMoved = false;               // body moved since the sort?
+int         SweepAxis = 0;
+float       SweepMaxRadius = 0.0f;
+BodyPair    *CandidatePairs = NULL;
+int         NumCandidatePairs = 0;
+int         MaxCandidatePairs = 0;
+BVHNode     *StaticBVH = NULL;
+int         NumStaticBVHNodes = 0;
+int         MaxStaticBVHNodes = 0;
+bool        StaticBVHDirty = true;
+int         *StaticBVHBodies = NULL;
+
+static bool ReserveSweep(int count)
+{
+    if (!GrowArray(SweepList, NumSweep, count)) return false;
+    if (!GrowArray(SweepMin, MaxBodies, count)) return false;
+    return true;
+}
+
+static void ResetSweep(void)
+{
+    delete [] SweepList;
+    delete [] SweepMin;
+    SweepList = NULL;
+    SweepMin = NULL;
+    NumSweep = 0;
+    SweepVersion = -1;
+    delete [] StaticBVH;
+    delete [] StaticBVHBodies;
+    StaticBVH = NULL;
+    StaticBVHBodies = NULL;
+    NumStaticBVHNodes = MaxStaticBVHNodes = 0;
+    StaticBVHDirty = true;
+}
+
+
+// Add a candidate pair, growing the pair buffer as needed.
+static void AddCandidatePair(int body1, int body2)
+{
+    int n;
+
+    if (NumCandidatePairs == MaxCandidatePairs)
+    {
+        n = MaxCandidatePairs * 2;
+        if (n < 64) n = 64;
+        if (!GrowArray(CandidatePairs, NumCandidatePairs, n)) return;
+        MaxCandidatePairs = n;
+    }
+    CandidatePairs[NumCandidatePairs].body1 = body1;
+    CandidatePairs[NumCandidatePairs].body2 = body2;
+    NumCandidatePairs++;
+}
+
+static float SweepCoordinate(int i, int axis)
+{
+    switch(axis)
+    {
+        case 0: return Bodies[i].vPosition.x;
+        case 1: return Bodies[i].vPosition.y;
+        default: return Bodies[i].vPosition.z;
+    }
+}
+
+
+// Pick the axis with the widest spread of bodies to sweep along.
+static int ChooseSweepAxis(void)
+{
+    int i, k, n;
+    Vector sum, sum2, p;
+    float vx, vy, vz;
+
+    n = 0;
+    for(k=0; k<NumSweep; k++)
+    {
+        i = SweepList[k];
+        p = Bodies[i].vPosition;
+        sum += p;
+        sum2.x += p.x * p.x;
+        sum2.y += p.y * p.y;
+        sum2.z += p.z * p.z;
+        n++;
+    }
+    if (n == 0) return SweepAxis;
+    vx = sum2.x - (sum.x * sum.x) / (float)n;
+    vy = sum2.y - (sum.y * sum.y) / (float)n;
+    vz = sum2.z - (sum.z * sum.z) / (float)n;
+    if (vx >= vy && vx >= vz) return 0;
+    if (vy >= vz) return 1;
+    return 2;
+}
+
+
+// Sort the moving bodies by the minimum extent along the sweep axis.
+static void SortSweepList(void)
+{
+    int a, b, i;
+    float key;
+
+    // Reset the sweep list when bodies are enabled or disabled.
+    // Static bodies are found through the static tree instead.
+    if (SweepVersion != ActiveBodiesVersion)
+    {
+        for(a=NumSweep=0; a<NumActiveBodies; a++)
+        {
+            i = ActiveBodies[a];
+            if (!IsStatic(i)) SweepList[NumSweep++] = i;
+        }
+        SweepVersion = ActiveBodiesVersion;
+    }
+
+    SweepAxis = ChooseSweepAxis();
+    SweepMaxRadius = 0.0f;
+    for(a=0; a<NumSweep; a++)
+    {
+        i = SweepList[a];
+        SweepMin[i] = SweepCoordinate(i, SweepAxis) - Bodies[i].fRadius;
+        if (Bodies[i].fRadius > SweepMaxRadius) SweepMaxRadius = Bodies[i].fRadius;
+    }
+    for(a=1; a<NumSweep; a++)
+    {
+        i = SweepList[a];
+        key = SweepMin[i];
+        for(b=a-1; b >= 0 && SweepMin[SweepList[b]] > key; b--)
+        {
+            SweepList[b + 1] = SweepList[b];
+        }
+        SweepList[b + 1] = i;
+    }
+    SweepMoved = false;
+}
+
+
+// Bodies that may be tested against each other?
+static bool CanCollide(int i, int j)
+{
+    if ((Bodies[i].type == WALL_TYPE || Bodies[i].type == FIXED_BLOCK_TYPE) &&
+        (Bodies[j].type == WALL_TYPE || Bodies[j].type == FIXED_BLOCK_TYPE)) return false;
+    if (Bodies[i].group != -1 && Bodies[i].group == Bodies[j].group) return false;
+    if (Bodies[i].exempt != -1 && Bodies[i].exempt == Bodies[j].group) return false;
+    if (Bodies[j].exempt != -1 && Bodies[j].exempt == Bodies[i].group) return false;
+    if (Bodies[i].asleep && Bodies[j].asleep) return false;
+    return true;
+}
+
+
+//------------------------------------------------------------------------//
+// Static bounding volume hierarchy.
+// Walls and fixed blocks never move, so their boxes are kept in a tree
+// that moving bodies query instead of sweeping against them. The tree is
+// rebuilt when a static body is enabled, disabled or moved.
+//------------------------------------------------------------------------//
+// Get the global axis aligned box around a body's box.
+void    GetBodyAABB(int index, Vector *min, Vector *max)
+{
+    OBB     *box = &GetBodyCache(index)->box;
+    Vector  r;
+
+    r.x = (float)(fabs(box->axis[0].x) * box->extent[0] +
+        fabs(box->axis[1].x) * box->extent[1] + fabs(box->axis[2].x) * box->extent[2]);
+    r.y = (float)(fabs(box->axis[0].y) * box->extent[0] +
+        fabs(box->axis[1].y) * box->extent[1] + fabs(box->axis[2].y) * box->extent[2]);
+    r.z = (float)(fabs(box->axis[0].z) * box->extent[0] +
+        fabs(box->axis[1].z) * box->extent[1] + fabs(box->axis[2].z) * box->extent[2]);
+    *min = box->center - r;
+    *max = box->center + r;
+}
+
+
+static float AxisCoordinate(Vector v, int axis)
+{
+    switch(axis)
+    {
+        case 0: return v.x;
+        case 1: return v.y;
+        default: return v.z;
+    }
+}
+
+
+// Build a subtree over bodies, splitting at the median of the longest axis.
+static int BuildBVHNode(int *bodies, int count)
+{
+    int     i, j, k, node, axis, half;
+    Vector  min, max, lo, hi, size;
+    float   key;
+
+    node = NumStaticBVHNodes++;
+    GetBodyAABB(bodies[0], &min, &max);
+    for(i=1; i<count; i++)
+    {
+        GetBodyAABB(bodies[i], &lo, &hi);
+        if (lo.x < min.x) min.x = lo.x;
+        if (lo.y < min.y) min.y = lo.y;
+        if (lo.z < min.z) min.z = lo.z;
+        if (hi.x > max.x) max.x = hi.x;
+        if (hi.y > max.y) max.y = hi.y;
+        if (hi.z > max.z) max.z = hi.z;
+    }
+    StaticBVH[node].min = min;
+    StaticBVH[node].max = max;
+    if (count == 1)
+    {
+        // The bounding sphere reaches at most this far beyond the box.
+        size = (max - min) * 0.5f;
+        key = size.x;
+        if (size.y < key) key = size.y;
+        if (size.z < key) key = size.z;
+        key = Bodies[bodies[0]].fRadius - key;
+        StaticBVH[node].slack = key > 0.0f ? key : 0.0f;
+        StaticBVH[node].left = StaticBVH[node].right = -1;
+        StaticBVH[node].body = bodies[0];
+        return node;
+    }
+
+    size = max - min;
+    if (size.x >= size.y && size.x >= size.z) axis = 0;
+    else if (size.y >= size.z) axis = 1;
+    else axis = 2;
+    for(i=1; i<count; i++)
+    {
+        k = bodies[i];
+        key = AxisCoordinate(Bodies[k].vPosition, axis);
+        for(j=i-1; j >= 0 && AxisCoordinate(Bodies[bodies[j]].vPosition, axis) > key; j--)
+        {
+            bodies[j + 1] = bodies[j];
+        }
+        bodies[j + 1] = k;
+    }
+    half = count / 2;
+    StaticBVH[node].body = -1;
+    StaticBVH[node].left = BuildBVHNode(bodies, half);
+    StaticBVH[node].right = BuildBVHNode(&bodies[half], count - half);
+    StaticBVH[node].slack = StaticBVH[StaticBVH[node].left].slack;
+    if (StaticBVH[StaticBVH[node].right].slack > StaticBVH[node].slack)
+    {
+        StaticBVH[node].slack = StaticBVH[StaticBVH[node].right].slack;
+    }
+    return node;
+}
+
+
+//------------------------------------------------------------------------//
+// Build the tree over the active walls and fixed blocks.
+//------------------------------------------------------------------------//
+void    BuildStaticBVH(void)
+{
+    int i, k, n;
+
+    for(k=n=0; k<NumActiveBodies; k++)
+    {
+        if (IsStatic(ActiveBodies[k])) n++;
+    }
+    if (n * 2 > MaxStaticBVHNodes)
+    {
+        delete [] StaticBVH;
+        delete [] StaticBVHBodies;
+        MaxStaticBVHNodes = n * 2;
+        StaticBVH = new BVHNode[MaxStaticBVHNodes];
+        StaticBVHBodies = new int[MaxStaticBVHNodes];
+    }
+    for(k=n=0; k<NumActiveBodies; k++)
+    {
+        i = ActiveBodies[k];
+        if (IsStatic(i)) StaticBVHBodies[n++] = i;
+    }
+    NumStaticBVHNodes = 0;
+    if (n > 0) BuildBVHNode(StaticBVHBodies, n);
+    StaticBVHDirty = false;
+}
+
+
+//------------------------------------------------------------------------//
+// Find the static bodies whose boxes overlap a box.
+// Returns: number of bodies overlapping. Only the first maxBodies are
+// stored, so a caller seeing more than maxBodies should query again with
+// a larger list.
+//------------------------------------------------------------------------//
+int     QueryStaticBVH(Vector min, Vector max, int *bodies, int maxBodies)
+{
+    int     stack[BVH_STACK_DEPTH];
+    int     n, found;
+    BVHNode *node;
+
+    if (StaticBVHDirty) BuildStaticBVH();
+    if (NumStaticBVHNodes == 0) return 0;
+    n = found = 0;
+    stack[n++] = 0;
+    while (n > 0)
+    {
+        node = &StaticBVH[stack[--n]];
+        if (node->min.x > max.x || node->max.x < min.x ||
+            node->min.y > max.y || node->max.y < min.y ||
+            node->min.z > max.z || node->max.z < min.z) continue;
+        if (node->body != -1)
+        {
+            if (found < maxBodies) bodies[found] = node->body;
+            found++;
+            continue;
+        }
+        assert(n + 2 <= BVH_STACK_DEPTH);
+        stack[n++] = node->left;
+        stack[n++] = node->right;
+    }
+    return found;
+}
+
+
+// Segment from p, by d for t in [0,1], passes through box?
+static bool SegmentHitsBox(Vector p, Vector d, Vector min, Vector max)
+{
+    float   t0 = 0.0f, t1 = 1.0f, u, v, w;
+    int     axis;
+
+    for(axis=0; axis<3; axis++)
+    {
+        u = AxisCoordinate(p, axis);
+        w = AxisCoordinate(d, axis);
+        if (fabs(w) < 1.0e-6f)
+        {
+            if (u < AxisCoordinate(min, axis) || u > AxisCoordinate(max, axis)) return false;
+            continue;
+        }
+        v = (AxisCoordinate(min, axis) - u) / w;
+        u = (AxisCoordinate(max, axis) - u) / w;
+        if (v > u) { w = v; v = u; u = w; }
+        if (v > t0) t0 = v;
+        if (u < t1) t1 = u;
+        if (t0 > t1) return false;
+    }
+    return true;
+}
+
+
+//------------------------------------------------------------------------//
+// Find the static bodies whose boxes or bounding spheres, grown by radius,
+// a segment may pass through.
+// Returns: number of bodies found; only the first maxBodies are stored.
+//------------------------------------------------------------------------//
+int     QueryStaticBVHSegment(Vector from, Vector to, float radius, int *bodies, int maxBodies)
+{
+    int     stack[BVH_STACK_DEPTH];
+    int     n, found;
+    BVHNode *node;
+    Vector  d, r;
+
+    if (StaticBVHDirty) BuildStaticBVH();
+    if (NumStaticBVHNodes == 0) return 0;
+    d = to - from;
+    n = found = 0;
+    stack[n++] = 0;
+    while (n > 0)
+    {
+        node = &StaticBVH[stack[--n]];
+        r.x = r.y = r.z = radius + node->slack;
+        if (!SegmentHitsBox(from, d, node->min - r, node->max + r)) continue;
+        if (node->body != -1)
+        {
+            if (found < maxBodies) bodies[found] = node->body;
+            found++;
+            continue;
+        }
+        assert(n + 2 <= BVH_STACK_DEPTH);
+        stack[n++] = node->left;
+        stack[n++] = node->right;
+    }
+    return found;
+}
+
+
+// Segment passes through body's bounding sphere?
+// The body must lie between the ends of the segment.
+static bool SegmentHitsBody(Vector from, Vector d, float length, int body, float *fraction)
+{
+    Vector  v;
+    float   t, c, r;
+
+    v = Bodies[body].vPosition - from;
+    t = (v * d) / length;
+    if (t <= 0.0f || t >= length) return false;
+    c = (v * v) - (t * t);
+    r = Bodies[body].fRadius * Bodies[body].fRadius;
+    if (c >= r) return false;
+    t -= sqrt(r - c);
+    *fraction = t > 0.0f ? t / length : 0.0f;
+    return true;
+}
+
+
+//------------------------------------------------------------------------//
+// Find the first body along the segment from..to whose bounding sphere
+// it passes through. Only bodies whose type is in typeMask (TYPE_MASK bits)
+// are considered. Moving bodies are found through the broadphase sweep
+// list, static bodies through the static tree.
+// Returns: body index, or -1 if none; fraction is how far along the
+// segment the body is entered.
+//------------------------------------------------------------------------//
+int     SegmentQuery(Vector from, Vector to, int typeMask, float *fraction)
+{
+    int     a, i, n, lowest, highest, middle, hit;
+    int     found[MAX_BVH_RESULTS];
+    int     *list;
+    float   length, lo, hi, t, best;
+    Vector  d;
+
+    d = to - from;
+    length = d.Magnitude();
+    hit = -1;
+    best = 1.0f;
+    if (length > 0.0f)
+    {
+        // Static bodies.
+        list = found;
+        n = QueryStaticBVHSegment(from, to, 0.0f, found, MAX_BVH_RESULTS);
+        if (n > MAX_BVH_RESULTS)
+        {
+            list = new int[n];
+            QueryStaticBVHSegment(from, to, 0.0f, list, n);
+        }
+        for(a=0; a<n; a++)
+        {
+            i = list[a];
+            if (!(typeMask & TYPE_MASK(Bodies[i].type))) continue;
+            if (SegmentHitsBody(from, d, length, i, &t) && t < best)
             {
-                Bodies[i].vVelocity.Normalize(MIN_OBJECT_VELOCITY);
+                hit = i;
+                best = t;
             }
         }
-        else
+        if (list != found) delete [] list;
+
+        // Moving bodies overlapping the segment along the sweep axis.
+        // The sweep is sorted by each step; bodies moved outside the
+        // simulation since then need it sorted again.
+        if (SweepMoved || SweepVersion != ActiveBodiesVersion) SortSweepList();
+        lo = AxisCoordinate(from, SweepAxis);
+        hi = AxisCoordinate(to, SweepAxis);
+        if (lo > hi) { t = lo; lo = hi; hi = t; }
+        lo -= SweepMaxRadius * 2.0f;
+        lowest = 0;
+        highest = NumSweep;
+        while (lowest < highest)
+        {
+            middle = (lowest + highest) / 2;
+            if (SweepMin[SweepList[middle]] < lo) lowest = middle + 1;
+            else highest = middle;
+        }
+        for(a=lowest; a<NumSweep; a++)
         {
-            if (Bodies[i].vVelocity.Magnitude() > MAX_VELOCITY)
+            i = SweepList[a];
+            if (SweepMin[i] > hi) break;
+            if (!(typeMask & TYPE_MASK(Bodies[i].type))) continue;
+            if (SegmentHitsBody(from, d, length, i, &t) && t < best)
             {
-                Bodies[i].vVelocity.Normalize(MAX_VELOCITY);
+                hit = i;
+                best = t;
             }
         }
+    }
+    if (fraction != NULL) *fraction = best;
+    return hit;
+}
 
-        // calculate the position of the object in earth space:
-        Bodies[i].vPosition += Bodies[i].vVelocity * dt;
 
-        // Now handle the rotations:
-        float       mag;
+//------------------------------------------------------------------------//
+// Find the first body hit by a ray of the given length.
+// Returns: body index, or -1 if none; distance to the hit.
+//------------------------------------------------------------------------//
+int     Raycast(Vector origin, Vector direction, float length, int typeMask, float *distance)
+{
+    int     hit;
+    float   t;
 
-        Bodies[i].vAngularAcceleration = Bodies[i].mInertiaInverse *
-            (Bodies[i].vMoments -
-            (Bodies[i].vAngularVelocity^
-            (Bodies[i].mInertia * Bodies[i].vAngularVelocity)));
+    direction.Normalize();
+    hit = SegmentQuery(origin, origin + (direction * length), typeMask, &t);
+    if (distance != NULL) *distance = t * length;
+    return hit;
+}
 
-        Bodies[i].vAngularVelocity += Bodies[i].vAngularAcceleration * dt;
-        if (Bodies[i].type == XWING_BLOCK_TYPE || Bodies[i].type == SQUID_BLOCK_TYPE)
+
+// Find the unordered pairs of bodies whose bounding spheres overlap.
+// Each pair is reported once with body1 < body2.
+int FindCandidatePairs(void)
+{
+    int a, b, i, j, n;
+    float max;
+    Vector d, min, lo, tol;
+    int found[MAX_BVH_RESULTS];
+    int *list;
+
+    NumCandidatePairs = 0;
+    SortSweepList();
+
+    // Sweep: only bodies that start before this one ends can overlap it.
+    for(a=0; a<NumSweep; a++)
+    {
+        i = SweepList[a];
+        max = SweepMin[i] + (Bodies[i].fRadius * 2.0f);
+        for(b=a+1; b<NumSweep; b++)
         {
-            if (Bodies[i].vAngularVelocity.Magnitude() > MAX_OBJECT_ANGULAR_VELOCITY)
+            j = SweepList[b];
+            if (SweepMin[j] > max) break;
+            if (!CanCollide(i, j)) continue;
+
+            // bounding sphere check
+            d = Bodies[i].vPosition - Bodies[j].vPosition;
+            if(d.Magnitude() < (Bodies[i].fRadius + Bodies[j].fRadius))
             {
-                Bodies[i].vAngularVelocity.Normalize(MAX_OBJECT_ANGULAR_VELOCITY);
-            } else if (Bodies[i].vAngularVelocity.Magnitude() < MIN_OBJECT_ANGULAR_VELOCITY)
+                if (i < j)
+                {
+                    AddCandidatePair(i, j);
+                }
+                else
+                {
+                    AddCandidatePair(j, i);
+                }
+            }
+        }
+    }
+
+    // Moving bodies against the static tree.
+    tol = Vector(COLLISIONTOLERANCE, COLLISIONTOLERANCE, COLLISIONTOLERANCE);
+    for(a=0; a<NumSweep; a++)
+    {
+        i = SweepList[a];
+        if (Bodies[i].asleep) continue;
+        GetBodyAABB(i, &min, &lo);
+        list = found;
+        n = QueryStaticBVH(min - tol, lo + tol, found, MAX_BVH_RESULTS);
+        if (n > MAX_BVH_RESULTS)
+        {
+            list = new int[n];
+            QueryStaticBVH(min - tol, lo + tol, list, n);
+        }
+        for(b=0; b<n; b++)
+        {
+            j = list[b];
+            if (!CanCollide(i, j)) continue;
+            d = Bodies[i].vPosition - Bodies[j].vPosition;
+            if(d.Magnitude() < (Bodies[i].fRadius + Bodies[j].fRadius))
             {
-                Bodies[i].vAngularVelocity.Normalize(MIN_OBJECT_ANGULAR_VELOCITY);
+                if (i < j)
+                {
+                    AddCandidatePair(i, j);
+                }
+                else
+                {
+                    AddCandidatePair(j, i);
+                }
+            }
+        }
+        if (list != found) delete [] list;
+    }
+
+    return NumCandidatePairs;
+}
+
+
+// Order body tests as the all-pairs loop visited them.
+static int CompareBodyPairs(const void *p1, const void *p2)
+{
+    const BodyPair *b1 = (const BodyPair *)p1;
+    const BodyPair *b2 = (const BodyPair *)p2;
+
+    if (b1->body1 != b2->body1) return b1->body1 - b2->body1;
+    return b1->body2 - b2->body2;
+}
+
+
+// Flag a collision between bodies.
+// For X-wing, non-squid collisions take priority.
+static void FlagCollision(int i, int j)
+{
+    if (Bodies[i].type == XWING_BLOCK_TYPE)
+    {
+        if (Bodies[i].collision)
+        {
+            if (Bodies[j].type != SQUID_BLOCK_TYPE)
+            {
+                Bodies[i].withWho = j;
             }
         }
         else
         {
-            if (Bodies[i].vAngularVelocity.Magnitude() > MAX_ANGULAR_VELOCITY)
-            {
-                Bodies[i].vAngularVelocity.Normalize(MAX_ANGULAR_VELOCITY);
-            }
+            Bodies[i].collision = true;
+            Bodies[i].withWho = j;
+        }
+    }
+    else
+    {
+        Bodies[i].collision = true;
+        Bodies[i].withWho = j;
+    }
+}
+
+
+//------------------------------------------------------------------------//
+// Narrowphase worker threads.
+// The directed pair tests are split into contiguous runs, one per thread,
+// and each thread writes its contacts to its own buffer. Concatenating
+// the buffers in thread order gives the contacts in test order, so the
+// result does not depend on the number of threads.
+//------------------------------------------------------------------------//
+typedef struct  _NarrowphaseTask
+{
+    int             first;                        // range of tests
+    int             last;
+    Collision       *contacts;                    // contact buffer
+    int             numContacts;
+    int             maxContacts;
+#ifdef UNIX
+    pthread_t       thread;
+    bool            active;                       // has work this round?
+    int             round;                        // last round seen
+#else
+    HANDLE          thread;
+    HANDLE          start;                        // work available event
+    HANDLE          done;                         // work finished event
+#endif
+}   NarrowphaseTask;
+
+int             NarrowphaseThreads = 1;
+static NarrowphaseTask NarrowphaseTasks[MAX_NARROWPHASE_THREADS];
+static int      NumNarrowphaseWorkers = 0;
+static bool     NarrowphaseQuit = false;
+static BodyPair *NarrowphaseTests = NULL;
+static int      *NarrowphaseResults = NULL;
+static int      MaxNarrowphaseTests = 0;
+#ifdef UNIX
+static pthread_mutex_t NarrowphaseMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t NarrowphaseStart = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t NarrowphaseDone = PTHREAD_COND_INITIALIZER;
+static int      NarrowphaseRound = 0;
+static int      NarrowphasePending = 0;
+#endif
+
+// The separating axis check is symmetric: a pair of moving bodies
+// is checked once and the reverse test reuses the result.
+static bool ReusesResult(int i, int j)
+{
+    return SATNarrowphase && i > j &&
+        Bodies[j].type != WALL_TYPE && Bodies[j].type != FIXED_BLOCK_TYPE;
+}
+
+
+// Run a range of box checks into the task's contact buffer.
+static void RunNarrowphaseTask(NarrowphaseTask *task)
+{
+    int i,j,k,n;
+
+    task->numContacts = 0;
+    for(k=task->first; k<task->last; k++)
+    {
+        i = NarrowphaseTests[k].body1;
+        j = NarrowphaseTests[k].body2;
+        if (ReusesResult(i, j)) continue;
+
+        // possible collision, do a box check
+        if (task->numContacts + MAX_BOX_CONTACTS > task->maxContacts)
+        {
+            n = task->maxContacts * 2;
+            if (n < task->numContacts + MAX_BOX_CONTACTS) n = task->numContacts + MAX_BOX_CONTACTS;
+            if (!GrowArray(task->contacts, task->numContacts, n))
+            {
+                NarrowphaseResults[k] = NOCOLLISION;
+                continue;
+            }
+            task->maxContacts = n;
+        }
+        NarrowphaseResults[k] = CheckBoxContacts(&task->contacts[task->numContacts], &n,
+            i, j, COLLISIONTOLERANCE);
+        task->numContacts += n;
+    }
+}
+
+
+#ifdef UNIX
+static void *NarrowphaseWorker(void *arg)
+{
+    NarrowphaseTask *task = (NarrowphaseTask *)arg;
+
+    pthread_mutex_lock(&NarrowphaseMutex);
+    for (;;)
+    {
+        while (task->round == NarrowphaseRound && !NarrowphaseQuit)
+        {
+            pthread_cond_wait(&NarrowphaseStart, &NarrowphaseMutex);
         }
+        if (NarrowphaseQuit) break;
+        task->round = NarrowphaseRound;
+        if (!task->active) continue;
+        pthread_mutex_unlock(&NarrowphaseMutex);
+        RunNarrowphaseTask(task);
+        pthread_mutex_lock(&NarrowphaseMutex);
+        task->active = false;
+        if (--NarrowphasePending == 0) pthread_cond_signal(&NarrowphaseDone);
+    }
+    pthread_mutex_unlock(&NarrowphaseMutex);
+    return NULL;
+}
+#else
+static DWORD WINAPI NarrowphaseWorker(LPVOID arg)
+{
+    NarrowphaseTask *task = (NarrowphaseTask *)arg;
 
-        // calculate the new rotation quaternion:
-        Bodies[i].qOrientation +=   (Bodies[i].qOrientation * Bodies[i].vAngularVelocity) *
-            (0.5f * dt);
+    for (;;)
+    {
+        WaitForSingleObject(task->start, INFINITE);
+        if (NarrowphaseQuit) break;
+        RunNarrowphaseTask(task);
+        SetEvent(task->done);
+    }
+    return 0;
+}
+#endif
 
-        // now normalize the orientation quaternion:
-        mag = Bodies[i].qOrientation.Magnitude();
-        if (mag != 0)
-            Bodies[i].qOrientation /= mag;
 
-        // calculate the velocity in body space:
-        Bodies[i].vVelocityBody = QVRotate(~Bodies[i].qOrientation, Bodies[i].vVelocity);
+// Stop the worker threads.
+static void StopNarrowphaseWorkers(void)
+{
+    int t;
+
+    if (NumNarrowphaseWorkers == 0) return;
+#ifdef UNIX
+    pthread_mutex_lock(&NarrowphaseMutex);
+    NarrowphaseQuit = true;
+    pthread_cond_broadcast(&NarrowphaseStart);
+    pthread_mutex_unlock(&NarrowphaseMutex);
+    for (t = 1; t <= NumNarrowphaseWorkers; t++)
+    {
+        pthread_join(NarrowphaseTasks[t].thread, NULL);
+    }
+#else
+    NarrowphaseQuit = true;
+    for (t = 1; t <= NumNarrowphaseWorkers; t++)
+    {
+        SetEvent(NarrowphaseTasks[t].start);
+        WaitForSingleObject(NarrowphaseTasks[t].thread, INFINITE);
+        CloseHandle(NarrowphaseTasks[t].thread);
+        CloseHandle(NarrowphaseTasks[t].start);
+        CloseHandle(NarrowphaseTasks[t].done);
+    }
+#endif
+    NarrowphaseQuit = false;
+    NumNarrowphaseWorkers = 0;
+}
 
-        // calculate the speed:
-        Bodies[i].fSpeed = Bodies[i].vVelocity.Magnitude();
 
-        // get the Euler angles for our information
-        Vector u;
+//------------------------------------------------------------------------//
+// Set the number of threads sharing the narrowphase.
+// One thread runs it on the caller's thread only.
+//------------------------------------------------------------------------//
+void    SetNarrowphaseThreads(int count)
+{
+    int t;
+    NarrowphaseTask *task;
 
-        u = MakeEulerAnglesFromQ(Bodies[i].qOrientation);
-        Bodies[i].vEulerAngles.x = u.x;           // roll
-        Bodies[i].vEulerAngles.y = u.y;           // pitch
-        Bodies[i].vEulerAngles.z = u.z;           // yaw
-    }
+    if (count < 1) count = 1;
+    if (count > MAX_NARROWPHASE_THREADS) count = MAX_NARROWPHASE_THREADS;
+    StopNarrowphaseWorkers();
+    NarrowphaseThreads = 1;
 
-    // Move groups uniformly.
-    for (i = 0; i < NumBodies;)
+    // Task 0 is the calling thread.
+    for (t = 1; t < count; t++)
     {
-        if (!Bodies[i].valid || Bodies[i].group == -1) { i++; continue; }
-
-        for (j = i; Bodies[j].group == Bodies[i].group && j < NumBodies; j++)
+        task = &NarrowphaseTasks[t];
+#ifdef UNIX
+        task->active = false;
+        task->round = NarrowphaseRound;
+        if (pthread_create(&task->thread, NULL, NarrowphaseWorker, task) != 0) break;
+#else
+        task->start = CreateEvent(NULL, FALSE, FALSE, NULL);
+        task->done = CreateEvent(NULL, FALSE, FALSE, NULL);
+        task->thread = CreateThread(NULL, 0, NarrowphaseWorker, task, 0, NULL);
+        if (task->thread == NULL)
         {
-            Bodies[j].vAcceleration = Bodies[i].vAcceleration;
-            Bodies[j].vVelocity = Bodies[i].vVelocity;
-            Bodies[j].vPosition = Bodies[i].vPosition;
-            Bodies[j].vAngularAcceleration = Bodies[i].vAngularAcceleration;
-            Bodies[j].vAngularVelocity = Bodies[i].vAngularVelocity;
-            Bodies[j].qOrientation = Bodies[i].qOrientation;
-            Bodies[j].vVelocityBody = Bodies[i].vVelocityBody;
-            Bodies[j].fSpeed = Bodies[i].fSpeed;
-            Bodies[j].vEulerAngles.x = Bodies[i].vEulerAngles.x;
-            Bodies[j].vEulerAngles.y = Bodies[i].vEulerAngles.y;
-            Bodies[j].vEulerAngles.z = Bodies[i].vEulerAngles.z;
+            CloseHandle(task->start);
+            CloseHandle(task->done);
+            break;
         }
-        i = j;
+#endif
+        NumNarrowphaseWorkers++;
+        NarrowphaseThreads++;
     }
+}
 
-    // Handle Collisions
-    if(CheckForCollisions() == COLLISION)
+
+// Run the tests on the caller and as many workers as are worth waking.
+static void RunNarrowphase(int numTests)
+{
+    int t, threads;
+
+    threads = numTests / MIN_NARROWPHASE_TESTS;
+    if (threads > NumNarrowphaseWorkers + 1) threads = NumNarrowphaseWorkers + 1;
+    if (threads < 1) threads = 1;
+    for (t = 0; t < MAX_NARROWPHASE_THREADS; t++)
     {
-        ResolveCollisions(dt);
+        NarrowphaseTasks[t].first = NarrowphaseTasks[t].last = 0;
+        NarrowphaseTasks[t].numContacts = 0;
+    }
+    for (t = 0; t < threads; t++)
+    {
+        NarrowphaseTasks[t].first = (numTests * t) / threads;
+        NarrowphaseTasks[t].last = (numTests * (t + 1)) / threads;
+    }
+    if (threads == 1)
+    {
+        RunNarrowphaseTask(&NarrowphaseTasks[0]);
+        return;
+    }
+
+#ifdef UNIX
+    pthread_mutex_lock(&NarrowphaseMutex);
+    for (t = 1; t < threads; t++) NarrowphaseTasks[t].active = true;
+    NarrowphasePending = threads - 1;
+    NarrowphaseRound++;
+    pthread_cond_broadcast(&NarrowphaseStart);
+    pthread_mutex_unlock(&NarrowphaseMutex);
+#else
+    for (t = 1; t < threads; t++) SetEvent(NarrowphaseTasks[t].start);
+#endif
+
+    RunNarrowphaseTask(&NarrowphaseTasks[0]);
+
+#ifdef UNIX
+    pthread_mutex_lock(&NarrowphaseMutex);
+    while (NarrowphasePending > 0)
+    {
+        pthread_cond_wait(&NarrowphaseDone, &NarrowphaseMutex);
     }
+    pthread_mutex_unlock(&NarrowphaseMutex);
+#else
+    for (t = 1; t < threads; t++) WaitForSingleObject(NarrowphaseTasks[t].done, INFINITE);
+#endif
 }
 
 
 int CheckForCollisions(void)
 {
     int status = NOCOLLISION;
-    int i,j;
-    Vector  d;
-    pCollision  pCollisionData;
+    int i,j,k,n,t;
     int     check = NOCOLLISION;
+    BodyPair    key, *first;
+    NarrowphaseTask *task;
 
-    pCollisionData = Collisions;
     NumCollisions = 0;
 
-    // check object collisions with each other
-    for(i=0; i<NumBodies; i++)
+    // Get candidate pairs from the broadphase.
+    FindCandidatePairs();
+    if (NumCandidatePairs * 2 > MaxNarrowphaseTests)
     {
-        if (!Bodies[i].valid) continue;
-        if (Bodies[i].type == WALL_TYPE || Bodies[i].type == FIXED_BLOCK_TYPE) continue;
-        for(j=0; j<NumBodies; j++)
+        delete [] NarrowphaseTests;
+        delete [] NarrowphaseResults;
+        MaxNarrowphaseTests = NumCandidatePairs * 2;
+        NarrowphaseTests = new BodyPair[MaxNarrowphaseTests];
+        NarrowphaseResults = new int[MaxNarrowphaseTests];
+    }
+
+    // Flags are set in the order the vertex check visits each moving
+    // body of a pair against the other.
+    for(k=n=0; k<NumCandidatePairs; k++)
+    {
+        i = CandidatePairs[k].body1;
+        j = CandidatePairs[k].body2;
+        if (Bodies[i].type != WALL_TYPE && Bodies[i].type != FIXED_BLOCK_TYPE)
+        {
+            NarrowphaseTests[n].body1 = i;
+            NarrowphaseTests[n].body2 = j;
+            n++;
+        }
+        if (Bodies[j].type != WALL_TYPE && Bodies[j].type != FIXED_BLOCK_TYPE)
         {
-            if (!Bodies[j].valid) continue;
-            if (i == j) continue;
-            if (Bodies[i].group != -1 && Bodies[i].group == Bodies[j].group) continue;
-            if (Bodies[i].exempt != -1 && Bodies[i].exempt == Bodies[j].group) continue;
-            if (Bodies[j].exempt != -1 && Bodies[j].exempt == Bodies[i].group) continue;
+            NarrowphaseTests[n].body1 = j;
+            NarrowphaseTests[n].body2 = i;
+            n++;
+        }
+    }
+    qsort(NarrowphaseTests, n, sizeof(BodyPair), CompareBodyPairs);
 
-            // do a bounding sphere check first
-            d = Bodies[i].vPosition - Bodies[j].vPosition;
-            if(d.Magnitude() < (Bodies[i].fRadius + Bodies[j].fRadius))
-            {                                     // possible collision, do a vertex check
-                check = CheckBoxCollision(pCollisionData, i, j, COLLISIONTOLERANCE);
-                if(check == COLLISION)
-                {
-                    // flag collision
-                    status = COLLISION;
+    // The threads only read the body cache, so bring it up to date first.
+    for(k=0; k<NumActiveBodies; k++)
+    {
+        GetBodyCache(ActiveBodies[k]);
+    }
 
-                    // for X-wing, non-squid collisions take priority.
-                    if (Bodies[i].type == XWING_BLOCK_TYPE)
-                    {
-                        if (Bodies[i].collision)
-                        {
-                            if (Bodies[j].type != SQUID_BLOCK_TYPE)
-                            {
-                                Bodies[i].withWho = j;
-                            }
-                        }
-                        else
-                        {
-                            Bodies[i].collision = true;
-                            Bodies[i].withWho = j;
-                        }
-                    }
-                    else
-                    {
-                        Bodies[i].collision = true;
-                        Bodies[i].withWho = j;
-                    }
-                    if (Bodies[j].type == XWING_BLOCK_TYPE)
-                    {
-                        if (Bodies[j].collision)
-                        {
-                            if (Bodies[i].type != SQUID_BLOCK_TYPE)
-                            {
-                                Bodies[j].withWho = i;
-                            }
-                        }
-                        else
-                        {
-                            Bodies[j].collision = true;
-                            Bodies[j].withWho = i;
-                        }
-                    }
-                    else
-                    {
-                        Bodies[j].collision = true;
-                        Bodies[j].withWho = i;
-                    }
-                }
-            }
+    // check object collisions with each other
+    RunNarrowphase(n);
+
+    // Merge the contact buffers in test order.
+    for(t=0; t<MAX_NARROWPHASE_THREADS; t++)
+    {
+        task = &NarrowphaseTasks[t];
+        if (task->numContacts == 0) continue;
+        if (!ReserveCollisions(NumCollisions + task->numContacts)) break;
+        for(k=0; k<task->numContacts; k++)
+        {
+            Collisions[NumCollisions++] = task->contacts[k];
+        }
+    }
+
+    // Flag collisions in test order.
+    for(k=0; k<n; k++)
+    {
+        i = NarrowphaseTests[k].body1;
+        j = NarrowphaseTests[k].body2;
+        if (ReusesResult(i, j))
+        {
+            key.body1 = j;
+            key.body2 = i;
+            first = (BodyPair *)bsearch(&key, NarrowphaseTests, k, sizeof(BodyPair), CompareBodyPairs);
+            check = NarrowphaseResults[first - NarrowphaseTests];
+            NarrowphaseResults[k] = check;
+        }
+        else
+        {
+            check = NarrowphaseResults[k];
+        }
+        if(check == COLLISION)
+        {
+            // flag collision
+            status = COLLISION;
+            FlagCollision(i, j);
+            FlagCollision(j, i);
         }
     }
 
@@ -415,8 +1918,13 @@ int CheckForSpecificCollision(int body1, int body2, float tolerance)
 {
     pCollision  pCollisionData;
 
-    pCollisionData = Collisions;
     NumCollisions = 0;
+    ReserveCollisions(MAX_BOX_CONTACTS);
+    pCollisionData = Collisions;
+
+    // Bodies are placed ad hoc before these checks.
+    InvalidateBodyCache(body1);
+    InvalidateBodyCache(body2);
 
     if (CheckBoxCollision(pCollisionData, body1, body2, tolerance) == COLLISION)
     {
@@ -578,12 +2086,11 @@ bool    IsPointOnFace(Vector pt, Vector f[4])
 }
 
 
-int CheckBoxCollision(pCollision CollisionData, int body1, int body2, float tolerance)
+int CheckBoxVertexCollision(pCollision CollisionData, int *numContacts, int body1, int body2, float tolerance)
 {
     int     i;
-    Vector  v1[8];
-    Vector  v2[8];
-    Vector  tmp;
+    Vector  *v1;
+    Vector  *v2;
     Vector  u, v;
     float   d;
     Vector  f[4];
@@ -594,17 +2101,11 @@ int CheckBoxCollision(pCollision CollisionData, int body1, int body2, float tole
     Vector  n;
     int status = NOCOLLISION;
 
-    //rotate bounding vertices and covert to global coordinates
-    for(i=0; i<8; i++)
-    {
-        tmp = Bodies[body1].vVertexList[i];
-        v1[i] = QVRotate(Bodies[body1].qOrientation, tmp);
-        v1[i] += Bodies[body1].vPosition;
+    *numContacts = 0;
 
-        tmp = Bodies[body2].vVertexList[i];
-        v2[i] = QVRotate(Bodies[body2].qOrientation, tmp);
-        v2[i] += Bodies[body2].vPosition;
-    }
+    // bounding vertices in global coordinates
+    v1 = GetBodyCache(body1)->vertex;
+    v2 = GetBodyCache(body2)->vertex;
 
     //check each vertex of body i against each face of body j
     for(i=0; i<8; i++)
@@ -640,8 +2141,8 @@ int CheckBoxCollision(pCollision CollisionData, int body1, int body2, float tole
                 if(Vrn < 0.0f)
                 {
                     // have a collision, fill the data structure and return
-                    assert(NumCollisions < (NumBodies*8));
-                    if(NumCollisions < (NumBodies*8))
+                    assert(*numContacts < MAX_BOX_CONTACTS);
+                    if(*numContacts < MAX_BOX_CONTACTS)
                     {
                         CollisionData->body1 = body1;
                         CollisionData->body2 = body2;
@@ -652,7 +2153,7 @@ int CheckBoxCollision(pCollision CollisionData, int body1, int body2, float tole
                         CollisionData->vCollisionTangent.Normalize();
                         CollisionData->vCollisionTangent.Normalize();
                         CollisionData++;
-                        NumCollisions++;
+                        (*numContacts)++;
                         status = true;
                     }
                 }
@@ -690,8 +2191,8 @@ int CheckBoxCollision(pCollision CollisionData, int body1, int body2, float tole
                 if(Vrn < 0.0f)
                 {
                     // have a collision, fill the data structure and return
-                    assert(NumCollisions < (NumBodies*8));
-                    if(NumCollisions < (NumBodies*8))
+                    assert(*numContacts < MAX_BOX_CONTACTS);
+                    if(*numContacts < MAX_BOX_CONTACTS)
                     {
                         CollisionData->body1 = body1;
                         CollisionData->body2 = body2;
@@ -702,7 +2203,7 @@ int CheckBoxCollision(pCollision CollisionData, int body1, int body2, float tole
                         CollisionData->vCollisionTangent.Normalize();
                         CollisionData->vCollisionTangent.Normalize();
                         CollisionData++;
-                        NumCollisions++;
+                        (*numContacts)++;
                         status = true;
                     }
                 }
@@ -740,8 +2241,8 @@ int CheckBoxCollision(pCollision CollisionData, int body1, int body2, float tole
                 if(Vrn < 0.0f)
                 {
                     // have a collision, fill the data structure and return
-                    assert(NumCollisions < (NumBodies*8));
-                    if(NumCollisions < (NumBodies*8))
+                    assert(*numContacts < MAX_BOX_CONTACTS);
+                    if(*numContacts < MAX_BOX_CONTACTS)
                     {
                         CollisionData->body1 = body1;
                         CollisionData->body2 = body2;
@@ -752,7 +2253,7 @@ int CheckBoxCollision(pCollision CollisionData, int body1, int body2, float tole
                         CollisionData->vCollisionTangent.Normalize();
                         CollisionData->vCollisionTangent.Normalize();
                         CollisionData++;
-                        NumCollisions++;
+                        (*numContacts)++;
                         status = true;
                     }
                 }
@@ -790,8 +2291,8 @@ int CheckBoxCollision(pCollision CollisionData, int body1, int body2, float tole
                 if(Vrn < 0.0f)
                 {
                     // have a collision, fill the data structure and return
-                    assert(NumCollisions < (NumBodies*8));
-                    if(NumCollisions < (NumBodies*8))
+                    assert(*numContacts < MAX_BOX_CONTACTS);
+                    if(*numContacts < MAX_BOX_CONTACTS)
                     {
                         CollisionData->body1 = body1;
                         CollisionData->body2 = body2;
@@ -802,7 +2303,7 @@ int CheckBoxCollision(pCollision CollisionData, int body1, int body2, float tole
                         CollisionData->vCollisionTangent.Normalize();
                         CollisionData->vCollisionTangent.Normalize();
                         CollisionData++;
-                        NumCollisions++;
+                        (*numContacts)++;
                         status = true;
                     }
                 }
@@ -840,8 +2341,8 @@ int CheckBoxCollision(pCollision CollisionData, int body1, int body2, float tole
                 if(Vrn < 0.0f)
                 {
                     // have a collision, fill the data structure and return
-                    assert(NumCollisions < (NumBodies*8));
-                    if(NumCollisions < (NumBodies*8))
+                    assert(*numContacts < MAX_BOX_CONTACTS);
+                    if(*numContacts < MAX_BOX_CONTACTS)
                     {
                         CollisionData->body1 = body1;
                         CollisionData->body2 = body2;
@@ -852,7 +2353,7 @@ int CheckBoxCollision(pCollision CollisionData, int body1, int body2, float tole
                         CollisionData->vCollisionTangent.Normalize();
                         CollisionData->vCollisionTangent.Normalize();
                         CollisionData++;
-                        NumCollisions++;
+                        (*numContacts)++;
                         status = true;
                     }
                 }
@@ -890,8 +2391,8 @@ int CheckBoxCollision(pCollision CollisionData, int body1, int body2, float tole
                 if(Vrn < 0.0f)
                 {
                     // have a collision, fill the data structure and return
-                    assert(NumCollisions < (NumBodies*8));
-                    if(NumCollisions < (NumBodies*8))
+                    assert(*numContacts < MAX_BOX_CONTACTS);
+                    if(*numContacts < MAX_BOX_CONTACTS)
                     {
                         CollisionData->body1 = body1;
                         CollisionData->body2 = body2;
@@ -902,7 +2403,7 @@ int CheckBoxCollision(pCollision CollisionData, int body1, int body2, float tole
                         CollisionData->vCollisionTangent.Normalize();
                         CollisionData->vCollisionTangent.Normalize();
                         CollisionData++;
-                        NumCollisions++;
+                        (*numContacts)++;
                         status = true;
                     }
                 }
@@ -915,6 +2416,500 @@ int CheckBoxCollision(pCollision CollisionData, int body1, int body2, float tole
 }
 
 
+//------------------------------------------------------------------------//
+// Separating axis narrowphase for oriented bounding boxes.
+//------------------------------------------------------------------------//
+bool    SATNarrowphase = true;
+
+// Is a box edge along a body axis?
+static bool IsAxisEdge(Vector e)
+{
+    return ((e.x != 0.0f) + (e.y != 0.0f) + (e.z != 0.0f)) == 1;
+}
+
+
+// Transform the bounding vertices and box of a body to global coordinates.
+// The vertex list must be a box with InitializeObject's vertex order:
+// vertex 0 has edges to vertices 4, 3 and 1 along its x, y and z sides.
+// Usually the box is aligned with the body axes, and its axes are the
+// body's. A box given in other coordinates, such as world vertices with
+// no rotation, takes its axes from those edges.
+static void ComputeBodyCache(int index)
+{
+    int     i;
+    Vector  vmin, vmax, c, e[3], r[3];
+    BodyCache   *cache = &BodyCaches[index];
+    OBB     *box = &cache->box;
+    Vector  *v = Bodies[index].vVertexList;
+
+    e[0] = v[0] - v[4];
+    e[1] = v[0] - v[3];
+    e[2] = v[1] - v[0];
+    r[0] = QVRotate(Bodies[index].qOrientation, Vector(1.0f, 0.0f, 0.0f));
+    r[1] = QVRotate(Bodies[index].qOrientation, Vector(0.0f, 1.0f, 0.0f));
+    r[2] = QVRotate(Bodies[index].qOrientation, Vector(0.0f, 0.0f, 1.0f));
+    if (IsAxisEdge(e[0]) && IsAxisEdge(e[1]) && IsAxisEdge(e[2]))
+    {
+        vmin = vmax = v[0];
+        for(i=1; i<8; i++)
+        {
+            c = v[i];
+            if (c.x < vmin.x) vmin.x = c.x;
+            if (c.y < vmin.y) vmin.y = c.y;
+            if (c.z < vmin.z) vmin.z = c.z;
+            if (c.x > vmax.x) vmax.x = c.x;
+            if (c.y > vmax.y) vmax.y = c.y;
+            if (c.z > vmax.z) vmax.z = c.z;
+        }
+        box->axis[0] = r[0];
+        box->axis[1] = r[1];
+        box->axis[2] = r[2];
+        c = (vmin + vmax) * 0.5f;
+        box->extent[0] = (vmax.x - vmin.x) * 0.5f;
+        box->extent[1] = (vmax.y - vmin.y) * 0.5f;
+        box->extent[2] = (vmax.z - vmin.z) * 0.5f;
+    }
+    else
+    {
+        c = Vector(0.0f, 0.0f, 0.0f);
+        for(i=0; i<8; i++) c += v[i];
+        c = c * 0.125f;
+        for(i=0; i<3; i++)
+        {
+            box->extent[i] = e[i].Magnitude() * 0.5f;
+            e[i].Normalize();
+            box->axis[i] = (r[0] * e[i].x) + (r[1] * e[i].y) + (r[2] * e[i].z);
+        }
+        assert((float)fabs(e[0] * e[1]) < 0.01f && (float)fabs(e[0] * e[2]) < 0.01f &&
+            (float)fabs(e[1] * e[2]) < 0.01f);
+    }
+    box->center = Bodies[index].vPosition + (r[0] * c.x) + (r[1] * c.y) + (r[2] * c.z);
+
+    // The rotated body axes serve for all eight vertices.
+    for(i=0; i<8; i++)
+    {
+        c = v[i];
+        cache->vertex[i] = Bodies[index].vPosition + (r[0] * c.x) + (r[1] * c.y) + (r[2] * c.z);
+    }
+    cache->current = true;
+}
+
+
+// Refresh the cache for all active bodies that may have moved.
+void    UpdateBodyCache(void)
+{
+    int i,k;
+
+    for(k=0; k<NumActiveBodies; k++)
+    {
+        i = ActiveBodies[k];
+        if (Bodies[i].asleep && BodyCaches[i].current) continue;
+        ComputeBodyCache(i);
+    }
+}
+
+
+// Mark a moved body's cache entry as out of date.
+// A body moved outside of the simulation is not interpolated.
+void    InvalidateBodyCache(int index)
+{
+    BodyCaches[index].current = false;
+    Bodies[index].previousStep = -1;
+    if (IsStatic(index)) StaticBVHDirty = true;
+    else SweepMoved = true;
+}
+
+
+// Get the cache entry of a body, refreshing it if out of date.
+BodyCache   *GetBodyCache(int index)
+{
+    if (!BodyCaches[index].current) ComputeBodyCache(index);
+    return &BodyCaches[index];
+}
+
+
+// Get the oriented bounding box of a body.
+void    GetBodyOBB(int index, OBB *box)
+{
+    *box = GetBodyCache(index)->box;
+}
+
+
+// Record a contact of body1 against body2 at a point.
+// The normal points from body2 towards body1.
+// Returns: COLLISION if the bodies are approaching at the point.
+static int RecordContact(pCollision &CollisionData, int *numContacts, int body1, int body2, Vector pt, Vector n)
+{
+    Vector  pt1, pt2;
+    Vector  vel1, vel2;
+    Vector  Vr;
+    float   Vrn;
+
+    // calc relative velocity, if <0 collision
+    pt1 = pt - Bodies[body1].vPosition;
+    pt2 = pt - Bodies[body2].vPosition;
+
+    vel1 = Bodies[body1].vVelocityBody + (Bodies[body1].vAngularVelocity^pt1);
+    vel2 = Bodies[body2].vVelocityBody + (Bodies[body2].vAngularVelocity^pt2);
+
+    vel1 = QVRotate(Bodies[body1].qOrientation, vel1);
+    vel2 = QVRotate(Bodies[body2].qOrientation, vel2);
+
+    Vr = (vel1 - vel2);
+    Vrn = Vr * n;
+    if(Vrn >= 0.0f) return NOCOLLISION;
+
+    assert(*numContacts < MAX_BOX_CONTACTS);
+    if(*numContacts >= MAX_BOX_CONTACTS) return NOCOLLISION;
+    CollisionData->body1 = body1;
+    CollisionData->body2 = body2;
+    CollisionData->vCollisionNormal = n;
+    CollisionData->vCollisionPoint = pt;
+    CollisionData->vRelativeVelocity = Vr;
+    CollisionData->vCollisionTangent = -(Vr - ((Vr*n)*n));
+    CollisionData->vCollisionTangent.Normalize();
+    CollisionData++;
+    (*numContacts)++;
+    return COLLISION;
+}
+
+
+// Clip a convex polygon to the half space p * n <= d.
+static int ClipPolygon(Vector *in, int count, Vector n, float d, Vector *out)
+{
+    int     i, j, num;
+    float   di, dj;
+
+    num = 0;
+    for(i=0, j=count-1; i<count; j = i++)
+    {
+        di = (in[i] * n) - d;
+        dj = (in[j] * n) - d;
+        if ((di <= 0.0f) != (dj <= 0.0f))
+        {
+            out[num++] = in[j] + ((in[i] - in[j]) * (dj / (dj - di)));
+        }
+        if (di <= 0.0f) out[num++] = in[i];
+    }
+    return num;
+}
+
+
+// Generate the contacts of the incident box against a face of the
+// reference box. The reference face normal points towards the incident box.
+static int FaceContacts(OBB *ref, int face, Vector nref, OBB *inc, float tolerance, Vector *contacts)
+{
+    int     i, k, u, v, num;
+    float   d, best;
+    Vector  fc, ic, in;
+    Vector  poly[8], clip[8];
+
+    // Incident face is the one most opposed to the reference normal.
+    k = 0;
+    best = 0.0f;
+    for(i=0; i<3; i++)
+    {
+        d = (float)fabs(inc->axis[i] * nref);
+        if (d > best) { best = d; k = i; }
+    }
+    in = inc->axis[k];
+    if ((in * nref) > 0.0f) in = -in;
+    ic = inc->center + (in * inc->extent[k]);
+    u = (k + 1) % 3;
+    v = (k + 2) % 3;
+    poly[0] = ic + (inc->axis[u] * inc->extent[u]) + (inc->axis[v] * inc->extent[v]);
+    poly[1] = ic - (inc->axis[u] * inc->extent[u]) + (inc->axis[v] * inc->extent[v]);
+    poly[2] = ic - (inc->axis[u] * inc->extent[u]) - (inc->axis[v] * inc->extent[v]);
+    poly[3] = ic + (inc->axis[u] * inc->extent[u]) - (inc->axis[v] * inc->extent[v]);
+
+    // Clip to the sides of the reference face.
+    fc = ref->center + (nref * ref->extent[face]);
+    u = (face + 1) % 3;
+    v = (face + 2) % 3;
+    num = 4;
+    num = ClipPolygon(poly, num, ref->axis[u], (ref->axis[u] * fc) + ref->extent[u], clip);
+    num = ClipPolygon(clip, num, -ref->axis[u], -(ref->axis[u] * fc) + ref->extent[u], poly);
+    num = ClipPolygon(poly, num, ref->axis[v], (ref->axis[v] * fc) + ref->extent[v], clip);
+    num = ClipPolygon(clip, num, -ref->axis[v], -(ref->axis[v] * fc) + ref->extent[v], poly);
+
+    // Keep points within tolerance of the reference face.
+    for(i=k=0; i<num; i++)
+    {
+        if (((poly[i] - fc) * nref) <= tolerance) contacts[k++] = poly[i];
+    }
+    return k;
+}
+
+
+// Closest points between the supporting edges of two boxes.
+static Vector EdgeContact(OBB *a, int ea, OBB *b, int eb, Vector n)
+{
+    int     k;
+    Vector  pa, pb, da, db, r;
+    float   s, t, dd, e, f, c;
+
+    // n points from box a towards box b.
+    pa = a->center;
+    pb = b->center;
+    for(k=0; k<3; k++)
+    {
+        if (k != ea) pa += a->axis[k] * (((a->axis[k] * n) > 0.0f) ? a->extent[k] : -a->extent[k]);
+        if (k != eb) pb -= b->axis[k] * (((b->axis[k] * n) > 0.0f) ? b->extent[k] : -b->extent[k]);
+    }
+    da = a->axis[ea];
+    db = b->axis[eb];
+    r = pa - pb;
+    dd = da * db;
+    c = da * r;
+    f = db * r;
+    e = 1.0f - (dd * dd);
+    s = (e > tol) ? ((dd * f) - c) / e : 0.0f;
+    if (s < -a->extent[ea]) s = -a->extent[ea];
+    if (s > a->extent[ea]) s = a->extent[ea];
+    t = (dd * s) + f;
+    if (t < -b->extent[eb]) t = -b->extent[eb];
+    if (t > b->extent[eb]) t = b->extent[eb];
+    s = (dd * t) - c;
+    if (s < -a->extent[ea]) s = -a->extent[ea];
+    if (s > a->extent[ea]) s = a->extent[ea];
+    return ((pa + (da * s)) + (pb + (db * t))) * 0.5f;
+}
+
+
+// Check two bodies' boxes against each other with the separating axis
+// test, stopping at the first axis that separates them by more than the
+// tolerance. Otherwise the axis of least penetration gives the contact
+// normal and a face (clipped) or edge manifold.
+int CheckOBBCollision(pCollision CollisionData, int *numContacts, int body1, int body2, float tolerance)
+{
+    OBB     a, b;
+    float   R[3][3], AbsR[3][3];
+    float   t[3], ra, rb, s, best, len;
+    Vector  d, L, n, bestAxis;
+    int     i, j, bestType, bestI, bestJ, num;
+    Vector  contacts[8];
+    int     status = NOCOLLISION;
+
+    *numContacts = 0;
+    GetBodyOBB(body1, &a);
+    GetBodyOBB(body2, &b);
+
+    // Rotation of b in a's frame, with an epsilon against parallel edges.
+    for(i=0; i<3; i++)
+    {
+        for(j=0; j<3; j++)
+        {
+            R[i][j] = a.axis[i] * b.axis[j];
+            AbsR[i][j] = (float)fabs(R[i][j]) + 1.0e-6f;
+        }
+    }
+    d = b.center - a.center;
+    t[0] = d * a.axis[0];
+    t[1] = d * a.axis[1];
+    t[2] = d * a.axis[2];
+
+    // Face axes of a.
+    best = -1.0e30f;
+    bestType = bestI = bestJ = 0;
+    for(i=0; i<3; i++)
+    {
+        ra = a.extent[i];
+        rb = b.extent[0] * AbsR[i][0] + b.extent[1] * AbsR[i][1] + b.extent[2] * AbsR[i][2];
+        s = (float)fabs(t[i]) - (ra + rb);
+        if (s > tolerance) return NOCOLLISION;
+        if (s > best) { best = s; bestType = 0; bestI = i; }
+    }
+
+    // Face axes of b.
+    for(j=0; j<3; j++)
+    {
+        ra = a.extent[0] * AbsR[0][j] + a.extent[1] * AbsR[1][j] + a.extent[2] * AbsR[2][j];
+        rb = b.extent[j];
+        s = (float)fabs(d * b.axis[j]) - (ra + rb);
+        if (s > tolerance) return NOCOLLISION;
+        if (s > best) { best = s; bestType = 1; bestJ = j; }
+    }
+
+    // Edge cross products; these must beat the face axes by a margin.
+    for(i=0; i<3; i++)
+    {
+        for(j=0; j<3; j++)
+        {
+            L = a.axis[i] ^ b.axis[j];
+            len = L.Magnitude();
+            if (len < 1.0e-3f) continue;
+            ra = a.extent[(i+1)%3] * AbsR[(i+2)%3][j] + a.extent[(i+2)%3] * AbsR[(i+1)%3][j];
+            rb = b.extent[(j+1)%3] * AbsR[i][(j+2)%3] + b.extent[(j+2)%3] * AbsR[i][(j+1)%3];
+            s = ((float)fabs(d * L) - (ra + rb)) / len;
+            if (s > tolerance) return NOCOLLISION;
+            if (s > best + 0.01f) { best = s; bestType = 2; bestI = i; bestJ = j; bestAxis = L / len; }
+        }
+    }
+
+    // Build the manifold. Normals point from body2 towards body1.
+    switch(bestType)
+    {
+        case 0:
+            n = a.axis[bestI];
+            if ((n * d) < 0.0f) n = -n;
+            num = FaceContacts(&a, bestI, n, &b, tolerance, contacts);
+            for(i=0; i<num; i++)
+            {
+                if (RecordContact(CollisionData, numContacts, body1, body2, contacts[i], -n) == COLLISION) status = COLLISION;
+            }
+            break;
+
+        case 1:
+            n = b.axis[bestJ];
+            if ((n * d) > 0.0f) n = -n;
+            num = FaceContacts(&b, bestJ, n, &a, tolerance, contacts);
+            for(i=0; i<num; i++)
+            {
+                if (RecordContact(CollisionData, numContacts, body1, body2, contacts[i], n) == COLLISION) status = COLLISION;
+            }
+            break;
+
+        case 2:
+            n = bestAxis;
+            if ((n * d) < 0.0f) n = -n;
+            contacts[0] = EdgeContact(&a, bestI, &b, bestJ, n);
+            status = RecordContact(CollisionData, numContacts, body1, body2, contacts[0], -n);
+            break;
+    }
+
+    return status;
+}
+
+
+//------------------------------------------------------------------------//
+// Narrowphase box check, by separating axes or by vertices against faces.
+// The separating axis test is symmetric, the vertex test one-sided.
+// The two generate different contacts. The vertex test, run in both
+// directions, records every vertex of either box within the tolerance of
+// the other's faces. The separating axis test records one manifold per
+// pair: the incident face clipped to the reference face, or a single
+// point for an edge contact. Near-touching pairs inside the tolerance can
+// also be classified differently: see BenchmarkNarrowphase.
+// Up to MAX_BOX_CONTACTS contacts are written to CollisionData and
+// counted in numContacts; no globals are changed.
+//------------------------------------------------------------------------//
+int CheckBoxContacts(pCollision CollisionData, int *numContacts, int body1, int body2, float tolerance)
+{
+    if (SATNarrowphase)
+    {
+        return CheckOBBCollision(CollisionData, numContacts, body1, body2, tolerance);
+    }
+    else
+    {
+        return CheckBoxVertexCollision(CollisionData, numContacts, body1, body2, tolerance);
+    }
+}
+
+
+// Box check adding its contacts to NumCollisions.
+int CheckBoxCollision(pCollision CollisionData, int body1, int body2, float tolerance)
+{
+    int status, n;
+
+    status = CheckBoxContacts(CollisionData, &n, body1, body2, tolerance);
+    NumCollisions += n;
+    return status;
+}
+
+
+//------------------------------------------------------------------------//
+// Time the vertex and separating axis narrowphases on the same
+// candidate pairs of randomly placed blocks.
+// Replaces the current bodies.
+//------------------------------------------------------------------------//
+void    BenchmarkNarrowphase(int numBodies, int iterations)
+{
+    int     i, j, k, it;
+    int     vertexHits, satHits, agree, hit1, hit2, n1, n2;
+    int     vertexContacts, satContacts, vertexOnly, satOnly;
+    float   span;
+    clock_t start;
+    double  vertexTime, satTime;
+
+    // Pack blocks closely enough for frequent contacts.
+    srand(1);
+    InitializePhysics(numBodies);
+    span = (float)pow((double)numBodies, 1.0 / 3.0) * BLOCK_SIZE * 1.2f;
+    for(i=0; i<numBodies; i++)
+    {
+        InitializeObject(i, BLOCK_SIZE, BLOCK_TYPE, -1);
+        Bodies[i].vPosition = Vector(span * (float)rand() / RAND_MAX,
+            span * (float)rand() / RAND_MAX, span * (float)rand() / RAND_MAX);
+        Bodies[i].qOrientation = MakeQFromEulerAngles((float)(rand()%360),
+            (float)(rand()%360), (float)(rand()%360));
+        Bodies[i].vVelocity = Vector(MAX_VELOCITY * ((float)rand() / RAND_MAX - 0.5f),
+            MAX_VELOCITY * ((float)rand() / RAND_MAX - 0.5f),
+            MAX_VELOCITY * ((float)rand() / RAND_MAX - 0.5f));
+        Bodies[i].vVelocityBody = QVRotate(~Bodies[i].qOrientation, Bodies[i].vVelocity);
+    }
+    UpdateBodyCache();
+    FindCandidatePairs();
+    ReserveCollisions(MAX_BOX_CONTACTS * 2);
+
+    // Vertex check, run in both directions as CheckForCollisions does.
+    vertexHits = vertexContacts = 0;
+    start = clock();
+    for(it=0; it<iterations; it++)
+    {
+        for(k=0; k<NumCandidatePairs; k++)
+        {
+            i = CandidatePairs[k].body1;
+            j = CandidatePairs[k].body2;
+            hit1 = CheckBoxVertexCollision(Collisions, &n1, i, j, COLLISIONTOLERANCE);
+            hit2 = CheckBoxVertexCollision(&Collisions[n1], &n2, j, i, COLLISIONTOLERANCE);
+            if (hit1 == COLLISION || hit2 == COLLISION) vertexHits++;
+            vertexContacts += n1 + n2;
+        }
+    }
+    vertexTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    // Separating axis check, once per pair.
+    satHits = satContacts = 0;
+    start = clock();
+    for(it=0; it<iterations; it++)
+    {
+        for(k=0; k<NumCandidatePairs; k++)
+        {
+            if (CheckOBBCollision(Collisions, &n1, CandidatePairs[k].body1,
+                CandidatePairs[k].body2, COLLISIONTOLERANCE) == COLLISION) satHits++;
+            satContacts += n1;
+        }
+    }
+    satTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    // Agreement on which pairs collide.
+    agree = vertexOnly = satOnly = 0;
+    for(k=0; k<NumCandidatePairs; k++)
+    {
+        i = CandidatePairs[k].body1;
+        j = CandidatePairs[k].body2;
+        hit1 = CheckBoxVertexCollision(Collisions, &n1, i, j, COLLISIONTOLERANCE);
+        hit2 = CheckBoxVertexCollision(&Collisions[n1], &n2, j, i, COLLISIONTOLERANCE);
+        hit1 = (hit1 == COLLISION || hit2 == COLLISION);
+        hit2 = (CheckOBBCollision(Collisions, &n1, i, j, COLLISIONTOLERANCE) == COLLISION);
+        if (hit1 == hit2) agree++;
+        else if (hit1) vertexOnly++;
+        else satOnly++;
+    }
+
+    printf("Narrowphase benchmark: %d bodies, %d candidate pairs, %d iterations\n",
+        numBodies, NumCandidatePairs, iterations);
+    printf("  vertex/face:     %.3f s, %.3f us/pair, %d collisions, %d contacts\n", vertexTime,
+        (vertexTime * 1.0e6) / ((double)NumCandidatePairs * iterations + 1.0), vertexHits / iterations,
+        vertexContacts / iterations);
+    printf("  separating axis: %.3f s, %.3f us/pair, %d collisions, %d contacts\n", satTime,
+        (satTime * 1.0e6) / ((double)NumCandidatePairs * iterations + 1.0), satHits / iterations,
+        satContacts / iterations);
+    printf("  agreement:       %d of %d pairs (%d vertex/face only, %d separating axis only)\n",
+        agree, NumCandidatePairs, vertexOnly, satOnly);
+}
+
+
 //------------------------------------------------------------------------//
 //
 //------------------------------------------------------------------------//
@@ -55,6 +55,9 @@ typedef struct _RigidBody
     float       fSpeed;                           // speed (magnitude of the velocity)
 
     Quaternion  qOrientation;                     // orientation in earth coordinates
+    Vector      vPreviousPosition;                // position before the last fixed step
+    Quaternion  qPreviousOrientation;             // orientation before the last fixed step
+    int         previousStep;                     // fixed step of the above, -1 if none
 
     Vector      vForces;                          // total force on body
     Vector      vMoments;                         // total moment (torque) on body
@@ -70,11 +73,18 @@ typedef struct _RigidBody
     bool        collision;                        // collision?
     int         withWho;                          // with who: index.
     int         exempt;                           // no collisions with this group.
+    bool        asleep;                           // at rest and not simulated?
+    float       restTime;                         // time spent below sleep thresholds
 
 } RigidBody, *pRigidBody;
 
-extern RigidBody Bodies[];
+extern RigidBody *Bodies;
 extern int NumBodies;
+extern int MaxBodies;
+extern int *ActiveBodies;                         // valid bodies, in index order.
+extern int NumActiveBodies;
+extern int *AwakeBodies;                          // active bodies not asleep, in index order.
+extern int NumAwakeBodies;
 
 typedef struct  _Collision
 {
@@ -87,7 +97,26 @@ typedef struct  _Collision
     Vector          vCollisionTangent;
 }   Collision, *pCollision;
 
-#define     MAX_BODIES              200
+extern Collision *Collisions;
+extern int NumCollisions;
+extern int MaxCollisions;
+
+typedef struct  _BodyPair
+{
+    int             body1;
+    int             body2;
+}   BodyPair;
+
+extern BodyPair *CandidatePairs;
+extern int NumCandidatePairs;
+
+#define     DEFAULT_MAX_BODIES      200
+#define     MAX_BOX_CONTACTS        48            // 8 vertices x 6 faces.
+#define     DEFAULT_FIXED_TIME_STEP 0.1f
+#define     DEFAULT_SUBSTEPS        1
+#define     DEFAULT_MAX_STEPS_PER_FRAME 5
+#define     MAX_NARROWPHASE_THREADS 16
+#define     MIN_NARROWPHASE_TESTS   64            // tests worth a thread.
 #define     BLOCK_SIZE              2.0f
 #define     FIXED_BLOCK_SIZE        5.0f
 
@@ -97,6 +126,7 @@ typedef struct  _Collision
 #define     FIXED_BLOCK_TYPE        2
 #define     XWING_BLOCK_TYPE        3
 #define     SQUID_BLOCK_TYPE        4
+#define     TYPE_MASK(type)         (1 << (type)) // body type set bit
 
 #define     MAX_VELOCITY            1.0f
 #define     MAX_ANGULAR_VELOCITY    0.2f
@@ -110,24 +140,147 @@ typedef struct  _Collision
 #define     PENETRATING             -1
 #define     CONTACT                 2
 
+#define     SLEEP_VELOCITY          0.05f
+#define     SLEEP_ANGULAR_VELOCITY  0.05f
+#define     SLEEP_TIME              1.0f          // rest time before sleeping
+
 #define     COLLISIONTOLERANCE      0.15f
 #define     PENETRATIONTOLERANCE    0.1f
 #define     COEFFICIENTOFRESTITUTION        0.5f
 #define     FRICTIONCOEFFICIENT     0.9f
+
+//------------------------------------------------------------------------//
+// Structure-of-arrays copy of the body integration state.
+// Bodies[] remains the AoS view of every body; StepSimulation gathers
+// the hot fields into these arrays, integrates four bodies at a time,
+// and scatters the results back. Each array is 16-byte aligned.
+//------------------------------------------------------------------------//
+typedef struct  _BodyState
+{
+    float           *px;                      // position
+    float           *py;
+    float           *pz;
+    float           *vx;                      // velocity
+    float           *vy;
+    float           *vz;
+    float           *ax;                      // acceleration
+    float           *ay;
+    float           *az;
+    float           *wx;                      // angular velocity
+    float           *wy;
+    float           *wz;
+    float           *alx;                     // angular acceleration
+    float           *aly;
+    float           *alz;
+    float           *qn;                      // orientation
+    float           *qx;
+    float           *qy;
+    float           *qz;
+    float           *speed;                   // magnitude of velocity
+    float           *minV;                    // velocity limits
+    float           *maxV;
+    float           *minW;                    // angular velocity limits
+    float           *maxW;
+    int             count;                    // padded to a multiple of 4
+    int             capacity;
+    void            *block;                   // storage for the arrays
+}   BodyState;
+
+extern BodyState BodyStates;
+
+//------------------------------------------------------------------------//
+// Oriented bounding box in global coordinates.
+//------------------------------------------------------------------------//
+typedef struct  _OBB
+{
+    Vector          center;
+    Vector          axis[3];                      // unit axes
+    float           extent[3];                    // half widths along axes
+}   OBB;
+
+extern bool BodySleeping;                         // let resting bodies sleep?
+extern int NumSleepingBodies;
+extern int NumIslands;                            // contact islands of moving bodies
+extern float FixedTimeStep;                       // simulation time per fixed step
+extern int NumSubsteps;                           // StepSimulation calls per fixed step
+extern int MaxStepsPerFrame;                      // fixed steps AdvanceSimulation may run
+extern float StepAlpha;                           // fraction of a step not yet simulated
+extern bool SATNarrowphase;                       // separating axis narrowphase?
+extern int NarrowphaseThreads;
+
+//------------------------------------------------------------------------//
+// World space vertices and box of a body, cached per simulation step.
+// StepSimulation refreshes the active bodies after integration; code that
+// moves a body outside of the simulation must call InvalidateBodyCache.
+//------------------------------------------------------------------------//
+typedef struct  _BodyCache
+{
+    Vector          vertex[8];                    // vVertexList in global coordinates
+    OBB             box;
+    bool            current;                      // matches the body?
+}   BodyCache;
+
+extern BodyCache *BodyCaches;
+
+//------------------------------------------------------------------------//
+// Bounding volume hierarchy over the static bodies (walls and fixed
+// blocks), built from their cached boxes. A node is a leaf when body != -1.
+//------------------------------------------------------------------------//
+typedef struct  _BVHNode
+{
+    Vector          min, max;                     // global axis aligned bounds
+    int             left, right;                  // child nodes
+    int             body;                         // leaf body, -1 if none
+    float           slack;                        // bounding sphere reach beyond bounds
+}   BVHNode;
+
+#define     MAX_BVH_RESULTS         64            // query list size; retry larger if exceeded.
+#define     BVH_STACK_DEPTH         64            // tree is split at medians, so depth ~ log2(bodies).
+
+extern BVHNode *StaticBVH;
+extern int NumStaticBVHNodes;
+extern bool StaticBVHDirty;                       // rebuild before next query?
+
 //------------------------------------------------------------------------//
 // Function headers
 //------------------------------------------------------------------------//
-void    InitializePhysics();
+void    InitializePhysics(int maxBodies = DEFAULT_MAX_BODIES);
+bool    ReserveBodies(int count);
+bool    ReserveCollisions(int count);
+void    SetBodyValid(int index, bool valid);
 void    InitializeObject(int index, float size, int type, int group);
 void    InitializeObject(RigidBody *, float size, int type, int group);
 void    ClearObjectForces(void);
-void    StepSimulation(float dtime);              // step dt time in the simulation
+void    ListAwakeBodies(void);
+void    WakeBody(int index);
+void    StepSimulation(float dtime, bool clearCollisions = true);   // step dt time in the simulation
+int     AdvanceSimulation(float dtime);           // run fixed steps for dt elapsed time
+void    InterpolateBody(int index, Vector *position, Quaternion *orientation);
+void    GatherBodyStates(void);
+void    IntegrateBodyStates(float dt);
+void    ScatterBodyStates(void);
+int     FindCandidatePairs(void);
 int     CheckForCollisions(void);
+void    SetNarrowphaseThreads(int count);
 int     CheckForSpecificCollision(int, int, float);
 void    ResolveCollisions(float);
 float   CalcDistanceFromPointToPlane(Vector pt, Vector u, Vector v, Vector ptOnPlane);
 bool    IsPointOnFace(Vector pt, Vector f[4]);
 int     CheckBoxCollision(pCollision CollisionData, int body1, int body2, float tolerance);
+int     CheckBoxContacts(pCollision CollisionData, int *numContacts, int body1, int body2, float tolerance);
+int     CheckBoxVertexCollision(pCollision CollisionData, int *numContacts, int body1, int body2, float tolerance);
+int     CheckOBBCollision(pCollision CollisionData, int *numContacts, int body1, int body2, float tolerance);
+void    GetBodyOBB(int index, OBB *box);
+void    UpdateBodyCache(void);
+void    InvalidateBodyCache(int index);
+BodyCache   *GetBodyCache(int index);
+void    GetBodyAABB(int index, Vector *min, Vector *max);
+void    BuildStaticBVH(void);
+int     QueryStaticBVH(Vector min, Vector max, int *bodies, int maxBodies);
+int     QueryStaticBVHSegment(Vector from, Vector to, float radius, int *bodies, int maxBodies);
+int     SegmentQuery(Vector from, Vector to, int typeMask, float *fraction = NULL);
+int     Raycast(Vector origin, Vector direction, float length, int typeMask, float *distance = NULL);
+void    BenchmarkNarrowphase(int numBodies, int iterations);
 
 Vector  GetBodyZAxisVector(int index);
 Vector  GetBodyXAxisVector(int index);
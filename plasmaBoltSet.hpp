@@ -9,39 +9,87 @@
 //*                                                                         *//
 //***************************************************************************//
 
-#include "plasmaBolt.hpp"
+#include <math.h>
+#include <string.h>
+#include <GL/gl.h>
+#include <GL/glu.h>
+#include "quaternion.hpp"
+#include "renderState.hpp"
 
 #ifndef __PLASMA_BOLT_SET__
 #define __PLASMA_BOLT_SET__
 
+// Pi
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Default capacity.
+#define MAX_PLASMA_BOLTS 500
+
+// Bolt torus model.
+#define PLASMA_BOLT_INNER_RADIUS 0.01
+#define PLASMA_BOLT_OUTER_RADIUS 0.04
+#define PLASMA_BOLT_SIDES 10
+#define PLASMA_BOLT_RINGS 10
+#define PLASMA_BOLT_MODEL_VERTICES (PLASMA_BOLT_SIDES * PLASMA_BOLT_RINGS)
+#define PLASMA_BOLT_MODEL_QUADS (PLASMA_BOLT_SIDES * PLASMA_BOLT_RINGS)
+
+// Number of hit grid cells (power of 2).
+#define PLASMA_BOLT_GRID_SIZE 1024
+
+// The set is a pool of bolts held in parallel arrays: position,
+// direction of travel, speed and distance travelled, with the rotation
+// each bolt was fired with. Bolts are numbered 0 through getSize() - 1.
+// A bolt that goes out of range or hits something is made inactive,
+// and removed by the next update, which moves the later bolts down, so
+// that bolts stay in the order they were fired. Bolts added to a full
+// set are dropped.
+//
+// A bolt hits an object when the path of its last move passes within
+// the object's radius, so a fast bolt cannot jump through an object
+// between frames.
+//
+// Hits are resolved in a batch. The frame's objects are added as hit
+// queries, and resolveHits sorts the active bolts by path midpoint into
+// a hashed grid of cells as wide as the largest query plus the longest
+// path. Each query, in the order added, destroys the newest active bolt
+// hitting it, the same bolt that collision would destroy.
+//
+// The bolt torus is built once in bolt coordinates. Drawing expands it
+// through every active bolt's rotation and position into one vertex
+// array, and draws all the bolts with a single call.
 class PlasmaBoltSet
 {
 
     public:
 
-        // Set link.
-        class Link
-        {
-            public:
-                PlasmaBolt *p;
-                Link *next;
-        };
+        // Parameters.
+        static const GLfloat PLASMA_BOLT_SPEED;
+        static const GLfloat PLASMA_BOLT_RANGE;
+        static const GLfloat PLASMA_BOLT_OFFSET;
 
         // Constructor.
-        PlasmaBoltSet();
+        PlasmaBoltSet(int capacity = MAX_PLASMA_BOLTS);
 
         // Destructor.
         ~PlasmaBoltSet();
 
-        // Add a bolt to the set.
-        void add(PlasmaBolt *);
+        // Add a bolt at a position with a rotation. It travels backward
+        // along the rotation's y axis at the given speed plus the bolt
+        // speed. Returns the bolt number, or -1 if the set is full.
+        int add(GLfloat x, GLfloat y, GLfloat z, GLfloat speed, GLfloat speedFactor,
+            GLfloat q[4]);
 
         // Go: update and draw.
         void Go() { update(); draw(); }
 
-        // Move active and delete inactive bolts.
+        // Move active and remove inactive bolts.
         void update();
 
+        // Move bolt.
+        void move(int i);
+
         // Draw bolts.
         void draw();
 
@@ -49,112 +97,395 @@ class PlasmaBoltSet
         bool isNear(float *v, float r);
 
         // A bolt collides with object of given radius and position?
+        // The newest bolt hitting it is destroyed.
         bool collision(float *v, float r);
 
+        // Remove all bolts.
+        void clear() { size = 0; }
+
+        // Remove all hit queries.
+        void clearHitQueries() { numHitQueries = numHits = 0; }
+
+        // Add hit query for a body of given position and radius.
+        // Queries of a group are added together; a hit on a body with
+        // a group of zero or more ends the remaining queries of the group.
+        void addHitQuery(float *v, float r, int body, int group);
+
+        // Resolve hit queries, destroying bolts that hit.
+        // Returns the number of hits.
+        int resolveHits();
+
+        // Get bolt and body of hit.
+        int getHitBolt(int i) { return(hits[i].bolt); }
+        int getHitBody(int i) { return(hits[i].body); }
+
         // Get number of bolts in set.
         int getSize() { return(size); }
 
-        Link *Set;
+        // Bolt access.
+        bool isActive(int i) { return(active[i]); }
+        void deactivate(int i) { active[i] = false; }
+        void setSpeed(int i, GLfloat s) { speed[i] = s + PLASMA_BOLT_SPEED; }
+        GLfloat getSpeed(int i) { return(speed[i]); }
+        void setSpeedFactor(int i, GLfloat f) { speedFactor[i] = f; }
+        GLfloat getSpeedFactor(int i) { return(speedFactor[i]); }
+        void getQuaternion(int i, GLfloat *q)
+        {
+            q[0] = quaternion[i][0];
+            q[1] = quaternion[i][1];
+            q[2] = quaternion[i][2];
+            q[3] = quaternion[i][3];
+        }
+
+        // Get bolt origin, as given to add.
+        void getOrigin(int i, GLfloat *p)
+        {
+            p[0] = x[i];
+            p[1] = y[i];
+            p[2] = z[i];
+        }
+
+        // Get bolt position in world coordinates: the center of the
+        // drawn bolt, ahead of its origin.
+        void getPosition(int i, GLfloat *p)
+        {
+            p[0] = x[i] + (dx[i] * PLASMA_BOLT_OFFSET);
+            p[1] = y[i] + (dy[i] * PLASMA_BOLT_OFFSET);
+            p[2] = z[i] + (dz[i] * PLASMA_BOLT_OFFSET);
+        }
+
+        // Get bolt position before its last move.
+        void getPreviousPosition(int i, GLfloat *p)
+        {
+            p[0] = x[i] + (dx[i] * (PLASMA_BOLT_OFFSET - step[i]));
+            p[1] = y[i] + (dy[i] * (PLASMA_BOLT_OFFSET - step[i]));
+            p[2] = z[i] + (dz[i] * (PLASMA_BOLT_OFFSET - step[i]));
+        }
+
+        // Bolt's last move passes within radius of position?
+        bool sweepHits(int i, float *v, float r);
+
+    private:
+
+        int capacity;
         int size;
+        GLfloat *x,*y,*z;
+        GLfloat *dx,*dy,*dz;                      // direction of travel
+        GLfloat *speed;
+        GLfloat *speedFactor;
+        GLfloat *distance;
+        GLfloat *step;                            // last move
+        bool *active;
+        GLfloat (*quaternion)[4];
+        GLfloat (*rotation)[4][4];
+
+        // Hit queries and hits.
+        struct HitQuery
+        {
+            GLfloat position[3];
+            GLfloat radius;
+            int body;
+            int group;
+        };
+        struct HitQuery *hitQueries;
+        int numHitQueries;
+        int maxHitQueries;
+        struct Hit
+        {
+            int bolt;
+            int body;
+        };
+        struct Hit *hits;
+        int numHits;
+
+        // Hit grid: bolts sorted by cell, newest first within a cell.
+        GLfloat cellSize;
+        GLfloat maxReach;
+        int cellStart[PLASMA_BOLT_GRID_SIZE + 1];
+        int *cellBolts;
+        int *boltCells;
+
+        // Bolt model, and the frame's vertices and quads.
+        static GLfloat modelVertices[PLASMA_BOLT_MODEL_VERTICES][3];
+        static GLuint modelQuads[PLASMA_BOLT_MODEL_QUADS][4];
+        static bool modelBuilt;
+        static void buildModel();
+        GLfloat (*vertices)[3];
+        GLuint (*quads)[4];
+        int maxDraw;
+
+        void copy(int to, int from);
+        void reserve(int);
+        void buildGrid();
+        int findHit(struct HitQuery *);
+        int cellOf(GLfloat x, GLfloat y, GLfloat z);
 };
 
+// Parameters.
+const GLfloat PlasmaBoltSet::PLASMA_BOLT_SPEED = 0.5;
+const GLfloat PlasmaBoltSet::PLASMA_BOLT_RANGE = 20.0;
+const GLfloat PlasmaBoltSet::PLASMA_BOLT_OFFSET = 0.15;
+
+// Bolt model.
+GLfloat PlasmaBoltSet::modelVertices[PLASMA_BOLT_MODEL_VERTICES][3];
+GLuint PlasmaBoltSet::modelQuads[PLASMA_BOLT_MODEL_QUADS][4];
+bool PlasmaBoltSet::modelBuilt = false;
+
 // Constructor.
-PlasmaBoltSet::PlasmaBoltSet()
+PlasmaBoltSet::PlasmaBoltSet(int capacity)
 {
-    Set = NULL;
+    this->capacity = capacity;
     size = 0;
+    x = new GLfloat[capacity];
+    y = new GLfloat[capacity];
+    z = new GLfloat[capacity];
+    dx = new GLfloat[capacity];
+    dy = new GLfloat[capacity];
+    dz = new GLfloat[capacity];
+    speed = new GLfloat[capacity];
+    speedFactor = new GLfloat[capacity];
+    distance = new GLfloat[capacity];
+    step = new GLfloat[capacity];
+    active = new bool[capacity];
+    quaternion = new GLfloat[capacity][4];
+    rotation = new GLfloat[capacity][4][4];
+    hitQueries = NULL;
+    numHitQueries = maxHitQueries = 0;
+    hits = NULL;
+    numHits = 0;
+    cellSize = 1.0;
+    maxReach = 0.0;
+    vertices = NULL;
+    quads = NULL;
+    maxDraw = 0;
+    cellBolts = new int[capacity];
+    boltCells = new int[capacity];
 }
 
 
 // Destructor.
 PlasmaBoltSet::~PlasmaBoltSet()
 {
-    Link *l;
+    delete [] x;
+    delete [] y;
+    delete [] z;
+    delete [] dx;
+    delete [] dy;
+    delete [] dz;
+    delete [] speed;
+    delete [] speedFactor;
+    delete [] distance;
+    delete [] step;
+    delete [] active;
+    delete [] quaternion;
+    delete [] rotation;
+    if (hitQueries != NULL) delete [] hitQueries;
+    if (hits != NULL) delete [] hits;
+    delete [] cellBolts;
+    delete [] boltCells;
+    if (vertices != NULL) delete [] vertices;
+    if (quads != NULL) delete [] quads;
+}
+
 
-    while (Set != NULL)
+// Add a plasma bolt to the set.
+int PlasmaBoltSet::add(GLfloat x, GLfloat y, GLfloat z, GLfloat speed, GLfloat speedFactor,
+GLfloat q[4])
+{
+    int i;
+    GLfloat d;
+
+    if (size == capacity) return(-1);
+    i = size++;
+    this->x[i] = x;
+    this->y[i] = y;
+    this->z[i] = z;
+    this->speed[i] = speed + PLASMA_BOLT_SPEED;
+    this->speedFactor[i] = speedFactor;
+    distance[i] = 0.0;
+    step[i] = 0.0;
+    active[i] = true;
+    quaternion[i][0] = q[0];
+    quaternion[i][1] = q[1];
+    quaternion[i][2] = q[2];
+    quaternion[i][3] = q[3];
+    cQuaternion qcalc(q);
+    qcalc.build_rotmatrix(rotation[i], qcalc.quat);
+    dx[i] = -rotation[i][1][0];
+    dy[i] = -rotation[i][1][1];
+    dz[i] = -rotation[i][1][2];
+    d = sqrt((dx[i] * dx[i]) + (dy[i] * dy[i]) + (dz[i] * dz[i]));
+    if (d > 0.0)
     {
-        l = Set;
-        Set = Set->next;
-        delete l->p;
-        delete l;
+        dx[i] /= d;
+        dy[i] /= d;
+        dz[i] /= d;
     }
+    return(i);
 }
 
 
-// Add a plasma bolt to the set.
-void PlasmaBoltSet::add(PlasmaBolt *p)
+// Copy a plasma bolt to another place.
+void PlasmaBoltSet::copy(int i, int j)
 {
-    Link *l;
-
-    if (p == NULL) return;
-    l = new Link();
-    l->p = p;
-    l->next = Set;
-    Set = l;
-    size++;
+    x[i] = x[j];
+    y[i] = y[j];
+    z[i] = z[j];
+    dx[i] = dx[j];
+    dy[i] = dy[j];
+    dz[i] = dz[j];
+    speed[i] = speed[j];
+    speedFactor[i] = speedFactor[j];
+    distance[i] = distance[j];
+    step[i] = step[j];
+    active[i] = active[j];
+    memcpy(quaternion[i], quaternion[j], sizeof(quaternion[i]));
+    memcpy(rotation[i], rotation[j], sizeof(rotation[i]));
 }
 
 
-// Move active and delete inactive plasma bolts.
+// Move active and remove inactive plasma bolts.
 void PlasmaBoltSet::update()
 {
-    Link *l,*l2;
+    int i,n;
 
-    for (l = Set, l2 = NULL; l != NULL; )
+    for (i = n = 0; i < size; i++)
     {
-        if (l->p->Active)
+        if (!active[i]) continue;
+        if (n != i) copy(n, i);
+        move(n);
+        n++;
+    }
+    size = n;
+}
+
+
+// Move plasma bolt.
+void PlasmaBoltSet::move(int i)
+{
+    GLfloat d;
+
+    d = speed[i] * speedFactor[i];
+    step[i] = d;
+    distance[i] += fabs(d);
+    x[i] += dx[i] * d;
+    y[i] += dy[i] * d;
+    z[i] += dz[i] * d;
+    if (distance[i] >= PLASMA_BOLT_RANGE)
+    {
+        active[i] = false;
+    }
+}
+
+
+// Build the bolt model: the torus glutSolidTorus would draw, turned
+// to face along the bolt's y axis and moved ahead of the bolt origin.
+void PlasmaBoltSet::buildModel()
+{
+    int i,j,k;
+    GLfloat phi,theta,d;
+
+    for (i = k = 0; i < PLASMA_BOLT_RINGS; i++)
+    {
+        phi = (GLfloat)(2.0 * M_PI) * (GLfloat)i / (GLfloat)PLASMA_BOLT_RINGS;
+        for (j = 0; j < PLASMA_BOLT_SIDES; j++, k++)
         {
-            l->p->move();
-            l2 = l;
-            l = l->next;
+            theta = (GLfloat)(2.0 * M_PI) * (GLfloat)j / (GLfloat)PLASMA_BOLT_SIDES;
+            d = PLASMA_BOLT_OUTER_RADIUS + (PLASMA_BOLT_INNER_RADIUS * cos(theta));
+            modelVertices[k][0] = cos(phi) * d;
+            modelVertices[k][1] = -(PLASMA_BOLT_INNER_RADIUS * sin(theta)) - PLASMA_BOLT_OFFSET;
+            modelVertices[k][2] = sin(phi) * d;
+
+            // Quads wind counterclockwise seen from outside.
+            modelQuads[k][0] = k;
+            modelQuads[k][1] = (((i + 1) % PLASMA_BOLT_RINGS) * PLASMA_BOLT_SIDES) + j;
+            modelQuads[k][2] = (((i + 1) % PLASMA_BOLT_RINGS) * PLASMA_BOLT_SIDES) +
+                ((j + 1) % PLASMA_BOLT_SIDES);
+            modelQuads[k][3] = (i * PLASMA_BOLT_SIDES) + ((j + 1) % PLASMA_BOLT_SIDES);
         }
-        else
+    }
+    modelBuilt = true;
+}
+
+
+// Size the draw arrays for a number of bolts.
+// They grow by doubling, up to the pool's capacity, so that firing
+// bolts does not rebuild them every frame.
+void PlasmaBoltSet::reserve(int count)
+{
+    int i,j,k,n;
+
+    if (count <= maxDraw) return;
+    n = maxDraw * 2;
+    if (n < count) n = count;
+    if (n > capacity) n = capacity;
+    if (vertices != NULL) delete [] vertices;
+    if (quads != NULL) delete [] quads;
+    vertices = new GLfloat[n * PLASMA_BOLT_MODEL_VERTICES][3];
+
+    // Quads do not change with the bolts.
+    quads = new GLuint[n * PLASMA_BOLT_MODEL_QUADS][4];
+    for (i = 0; i < n; i++)
+    {
+        for (j = 0; j < PLASMA_BOLT_MODEL_QUADS; j++)
         {
-            // Delete inactive plasma bolt.
-            if (l2 == NULL)
+            for (k = 0; k < 4; k++)
             {
-                Set = l->next;
-                delete l->p;
-                delete l;
-                l = Set;
+                quads[(i * PLASMA_BOLT_MODEL_QUADS) + j][k] =
+                    (i * PLASMA_BOLT_MODEL_VERTICES) + modelQuads[j][k];
             }
-            else
-            {
-                l2->next = l->next;
-                delete l->p;
-                delete l;
-                l = l2->next;
-            }
-            size--;
         }
     }
+    maxDraw = n;
 }
 
 
 // Draw plasma bolts.
 void PlasmaBoltSet::draw()
 {
-    Link *l;
+    int i,j,n;
+    GLfloat *m,*v,*w;
 
-    glDisable(GL_BLEND);
-    glDisable(GL_TEXTURE_2D);
-    glDisable(GL_LIGHTING);
+    if (!modelBuilt) buildModel();
+    reserve(size);
 
-    for (l = Set; l != NULL; l = l->next)
+    // Expand the model through the active bolts' transforms.
+    for (i = n = 0; i < size; i++)
     {
-        l->p->draw();
+        if (!active[i]) continue;
+        m = &rotation[i][0][0];
+        for (j = 0; j < PLASMA_BOLT_MODEL_VERTICES; j++)
+        {
+            v = modelVertices[j];
+            w = vertices[(n * PLASMA_BOLT_MODEL_VERTICES) + j];
+            w[0] = (m[0] * v[0]) + (m[4] * v[1]) + (m[8] * v[2]) + x[i];
+            w[1] = (m[1] * v[0]) + (m[5] * v[1]) + (m[9] * v[2]) + y[i];
+            w[2] = (m[2] * v[0]) + (m[6] * v[1]) + (m[10] * v[2]) + z[i];
+        }
+        n++;
     }
+    if (n == 0) return;
+
+    cRenderState::disable(GL_BLEND);
+    cRenderState::disable(GL_TEXTURE_2D);
+    cRenderState::disable(GL_LIGHTING);
+
+    glColor3f(0.5, 1.0, 0.5);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, vertices);
+    glDrawElements(GL_QUADS, n * PLASMA_BOLT_MODEL_QUADS * 4, GL_UNSIGNED_INT, quads);
+    glDisableClientState(GL_VERTEX_ARRAY);
 }
 
 
 // A bolt is near object of given radius and position?
 bool PlasmaBoltSet::isNear(float *v, float r)
 {
-    Link *l;
+    int i;
 
-    for (l = Set; l != NULL; l = l->next)
+    for (i = 0; i < size; i++)
     {
-        if (l->p->isNear(v, r)) return(true);
+        if (sweepHits(i, v, r)) return(true);
     }
     return(false);
 }
@@ -164,16 +495,190 @@ bool PlasmaBoltSet::isNear(float *v, float r)
 // Collision destroys plasma bolt.
 bool PlasmaBoltSet::collision(float *v, float r)
 {
-    Link *l;
+    int i;
 
-    for (l = Set; l != NULL; l = l->next)
+    for (i = size - 1; i >= 0; i--)
     {
-        if (l->p->isNear(v, r))
+        if (!active[i]) continue;
+        if (sweepHits(i, v, r))
         {
-            l->p->Active = false;                 // destroy bolt.
+            active[i] = false;                    // destroy bolt.
             return(true);
         }
     }
     return(false);
 }
+
+
+// Bolt's last move passes within radius of position?
+bool PlasmaBoltSet::sweepHits(int i, float *v, float r)
+{
+    GLfloat p[3],d[3],t;
+
+    // Find the closest point to the position along the move.
+    getPreviousPosition(i, p);
+    t = 0.0;
+    if (step[i] != 0.0)
+    {
+        t = (((v[0] - p[0]) * dx[i]) + ((v[1] - p[1]) * dy[i]) +
+            ((v[2] - p[2]) * dz[i])) / step[i];
+        if (t < 0.0) t = 0.0;
+        if (t > 1.0) t = 1.0;
+    }
+    d[0] = v[0] - (p[0] + (dx[i] * step[i] * t));
+    d[1] = v[1] - (p[1] + (dy[i] * step[i] * t));
+    d[2] = v[2] - (p[2] + (dz[i] * step[i] * t));
+    return(((d[0] * d[0]) + (d[1] * d[1]) + (d[2] * d[2])) <= (r * r));
+}
+
+
+// Add hit query.
+void PlasmaBoltSet::addHitQuery(float *v, float r, int body, int group)
+{
+    int i;
+    struct HitQuery *oldQueries;
+
+    if (numHitQueries == maxHitQueries)
+    {
+        oldQueries = hitQueries;
+        maxHitQueries = (maxHitQueries * 2) + 16;
+        hitQueries = new struct HitQuery[maxHitQueries];
+        for (i = 0; i < numHitQueries; i++) hitQueries[i] = oldQueries[i];
+        if (oldQueries != NULL) delete [] oldQueries;
+        if (hits != NULL) delete [] hits;
+        hits = new struct Hit[maxHitQueries];
+    }
+    hitQueries[numHitQueries].position[0] = v[0];
+    hitQueries[numHitQueries].position[1] = v[1];
+    hitQueries[numHitQueries].position[2] = v[2];
+    hitQueries[numHitQueries].radius = r;
+    hitQueries[numHitQueries].body = body;
+    hitQueries[numHitQueries].group = group;
+    numHitQueries++;
+}
+
+
+// Resolve hit queries.
+int PlasmaBoltSet::resolveHits()
+{
+    int i,j,b;
+
+    numHits = 0;
+    if (numHitQueries == 0 || size == 0) return(0);
+
+    // A bolt hitting a query has its path midpoint within the query
+    // radius plus half the longest path. Cells span that reach, so a
+    // query overlaps at most 8 cells.
+    maxReach = 0.0;
+    for (i = 0; i < size; i++)
+    {
+        if (active[i] && fabs(step[i]) > maxReach) maxReach = fabs(step[i]);
+    }
+    maxReach *= 0.5;
+    cellSize = 0.0;
+    for (i = 0; i < numHitQueries; i++)
+    {
+        if (hitQueries[i].radius > cellSize) cellSize = hitQueries[i].radius;
+    }
+    cellSize = (cellSize + maxReach) * 2.0;
+    if (cellSize <= 0.0) cellSize = 1.0;
+    buildGrid();
+
+    for (i = 0; i < numHitQueries; i++)
+    {
+        if ((b = findHit(&hitQueries[i])) == -1) continue;
+        active[b] = false;                        // destroy bolt.
+        hits[numHits].bolt = b;
+        hits[numHits].body = hitQueries[i].body;
+        numHits++;
+
+        // End group.
+        if (hitQueries[i].group >= 0)
+        {
+            for (j = i + 1; j < numHitQueries &&
+                hitQueries[j].group == hitQueries[i].group; j++) {}
+            i = j - 1;
+        }
+    }
+    return(numHits);
+}
+
+
+// Sort active bolts into grid cells by path midpoint.
+void PlasmaBoltSet::buildGrid()
+{
+    int i,c;
+    GLfloat p[3];
+
+    for (c = 0; c <= PLASMA_BOLT_GRID_SIZE; c++) cellStart[c] = 0;
+    for (i = 0; i < size; i++)
+    {
+        if (!active[i]) continue;
+        getPosition(i, p);
+        p[0] -= dx[i] * step[i] * 0.5;
+        p[1] -= dy[i] * step[i] * 0.5;
+        p[2] -= dz[i] * step[i] * 0.5;
+        boltCells[i] = cellOf(p[0], p[1], p[2]);
+        cellStart[boltCells[i] + 1]++;
+    }
+    for (c = 0; c < PLASMA_BOLT_GRID_SIZE; c++) cellStart[c + 1] += cellStart[c];
+    for (i = size - 1; i >= 0; i--)
+    {
+        if (!active[i]) continue;
+        cellBolts[cellStart[boltCells[i]]++] = i;
+    }
+
+    // Filling advanced the starts to the ends: shift them back.
+    for (c = PLASMA_BOLT_GRID_SIZE; c > 0; c--) cellStart[c] = cellStart[c - 1];
+    cellStart[0] = 0;
+}
+
+
+// Find newest active bolt hitting query.
+int PlasmaBoltSet::findHit(struct HitQuery *query)
+{
+    int i,j,k,n,b,c,hit;
+    int lo[3],hi[3];
+    GLfloat r;
+
+    r = query->radius + maxReach;
+    for (i = 0; i < 3; i++)
+    {
+        lo[i] = (int)floor((query->position[i] - r) / cellSize);
+        hi[i] = (int)floor((query->position[i] + r) / cellSize);
+    }
+    hit = -1;
+    for (i = lo[0]; i <= hi[0]; i++)
+    {
+        for (j = lo[1]; j <= hi[1]; j++)
+        {
+            for (k = lo[2]; k <= hi[2]; k++)
+            {
+                c = cellOf(((GLfloat)i + 0.5) * cellSize,
+                    ((GLfloat)j + 0.5) * cellSize, ((GLfloat)k + 0.5) * cellSize);
+                for (n = cellStart[c]; n < cellStart[c + 1]; n++)
+                {
+                    b = cellBolts[n];
+                    if (hit != -1 && b <= hit) break;
+                    if (!active[b]) continue;
+                    if (sweepHits(b, query->position, query->radius)) hit = b;
+                }
+            }
+        }
+    }
+    return(hit);
+}
+
+
+// Get grid cell of point.
+int PlasmaBoltSet::cellOf(GLfloat x, GLfloat y, GLfloat z)
+{
+    unsigned int i,j,k;
+
+    i = (unsigned int)(int)floor(x / cellSize);
+    j = (unsigned int)(int)floor(y / cellSize);
+    k = (unsigned int)(int)floor(z / cellSize);
+    return((int)(((i * 73856093u) ^ (j * 19349663u) ^ (k * 83492791u)) &
+        (PLASMA_BOLT_GRID_SIZE - 1)));
+}
 #endif
@@ -0,0 +1,285 @@
+//***************************************************************************//
+//* File Name: renderState.hpp                                              *//
+//* Author:    Tom Portegys, portegys@ilstu.edu                             *//
+//* Date Made: 10/17/26                                                     *//
+//* File Desc: Class declaration and implementation details                 *//
+//*            representing a cache of OpenGL render state that skips       *//
+//*            state changes which would not change anything.               *//
+//* Rev. Date:                                                              *//
+//* Rev. Desc:                                                              *//
+//*                                                                         *//
+//***************************************************************************//
+
+#ifndef __RENDER_STATE_HPP__
+#define __RENDER_STATE_HPP__
+
+#ifndef UNIX
+#include <windows.h>
+#endif
+#include <GL/gl.h>
+
+// Cached capabilities.
+#define NUM_RENDER_STATE_CAPS 5
+
+// Attribute stack depth (OpenGL guarantees at least 16).
+#define RENDER_STATE_STACK_DEPTH 16
+
+// Drawing code sets the blend, texture, lighting, shading, texture
+// environment, blend function and line width state through this class
+// instead of calling OpenGL directly. The last value set is remembered,
+// and a call that would set the same value again is skipped.
+// State is unknown (-1) until first set, and is forgotten at the start
+// of each frame and by invalidate, for code that sets it directly.
+class cRenderState
+{
+    public:
+
+        // Enable and disable capability (glEnable/glDisable).
+        static void enable(GLenum cap) { setCap(cap, 1); }
+        static void disable(GLenum cap) { setCap(cap, 0); }
+
+        // Shading model (glShadeModel).
+        static void shadeModel(GLenum mode);
+
+        // Texture environment mode (glTexEnvf GL_TEXTURE_ENV_MODE).
+        static void texEnvMode(GLenum mode);
+
+        // Bind 2D texture (glBindTexture).
+        static void bindTexture(GLuint name);
+
+        // Blend function (glBlendFunc).
+        static void blendFunc(GLenum sfactor, GLenum dfactor);
+
+        // Line width (glLineWidth).
+        static void lineWidth(GLfloat width);
+
+        // Save and restore attributes (glPushAttrib/glPopAttrib).
+        // The pop restores the cached values of the saved attributes.
+        static void pushAttrib(GLbitfield mask);
+        static void popAttrib();
+
+        // Forget cached state.
+        static void invalidate();
+
+        // Start frame: forget cached state and count the last frame.
+        static void beginFrame();
+
+        // State changes issued and skipped in the last whole frame.
+        static int getIssued() { return(lastIssued); }
+        static int getSkipped() { return(lastSkipped); }
+
+    private:
+
+        struct State
+        {
+            int caps[NUM_RENDER_STATE_CAPS];
+            int shadeModel;
+            int texEnvMode;
+            int texture;
+            int blendSrc, blendDst;
+            GLfloat lineWidth;
+        };
+        static struct State state;
+        static struct State stack[RENDER_STATE_STACK_DEPTH];
+        static GLbitfield stackMasks[RENDER_STATE_STACK_DEPTH];
+        static int stackSize;
+
+        // Changes issued and skipped.
+        static int issued, skipped;
+        static int lastIssued, lastSkipped;
+
+        static void setCap(GLenum cap, int value);
+};
+
+// Cached capabilities and the attribute groups that save them.
+static struct
+{
+    GLenum cap;
+    GLbitfield attribs;
+} RenderStateCaps[NUM_RENDER_STATE_CAPS] =
+{
+    { GL_BLEND, GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT },
+    { GL_TEXTURE_2D, GL_ENABLE_BIT | GL_TEXTURE_BIT },
+    { GL_LIGHTING, GL_ENABLE_BIT | GL_LIGHTING_BIT },
+    { GL_LINE_SMOOTH, GL_ENABLE_BIT | GL_LINE_BIT },
+    { GL_POINT_SMOOTH, GL_ENABLE_BIT | GL_POINT_BIT }
+};
+
+struct cRenderState::State cRenderState::state =
+{
+    { -1, -1, -1, -1, -1 }, -1, -1, -1, -1, -1, -1.0
+};
+struct cRenderState::State cRenderState::stack[RENDER_STATE_STACK_DEPTH];
+GLbitfield cRenderState::stackMasks[RENDER_STATE_STACK_DEPTH];
+int cRenderState::stackSize = 0;
+int cRenderState::issued = 0;
+int cRenderState::skipped = 0;
+int cRenderState::lastIssued = 0;
+int cRenderState::lastSkipped = 0;
+
+// Enable or disable capability.
+void cRenderState::setCap(GLenum cap, int value)
+{
+    int i;
+
+    for (i = 0; i < NUM_RENDER_STATE_CAPS; i++)
+    {
+        if (RenderStateCaps[i].cap == cap) break;
+    }
+    if (i < NUM_RENDER_STATE_CAPS)
+    {
+        if (state.caps[i] == value)
+        {
+            skipped++;
+            return;
+        }
+        state.caps[i] = value;
+        issued++;
+    }
+    if (value == 1) glEnable(cap); else glDisable(cap);
+}
+
+
+// Shading model.
+void cRenderState::shadeModel(GLenum mode)
+{
+    if (state.shadeModel == (int)mode)
+    {
+        skipped++;
+        return;
+    }
+    state.shadeModel = (int)mode;
+    issued++;
+    glShadeModel(mode);
+}
+
+
+// Texture environment mode.
+void cRenderState::texEnvMode(GLenum mode)
+{
+    if (state.texEnvMode == (int)mode)
+    {
+        skipped++;
+        return;
+    }
+    state.texEnvMode = (int)mode;
+    issued++;
+    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, (GLfloat)mode);
+}
+
+
+// Bind 2D texture.
+void cRenderState::bindTexture(GLuint name)
+{
+    if (state.texture == (int)name)
+    {
+        skipped++;
+        return;
+    }
+    state.texture = (int)name;
+    issued++;
+    glBindTexture(GL_TEXTURE_2D, name);
+}
+
+
+// Blend function.
+void cRenderState::blendFunc(GLenum sfactor, GLenum dfactor)
+{
+    if (state.blendSrc == (int)sfactor && state.blendDst == (int)dfactor)
+    {
+        skipped++;
+        return;
+    }
+    state.blendSrc = (int)sfactor;
+    state.blendDst = (int)dfactor;
+    issued++;
+    glBlendFunc(sfactor, dfactor);
+}
+
+
+// Line width.
+void cRenderState::lineWidth(GLfloat width)
+{
+    if (state.lineWidth == width)
+    {
+        skipped++;
+        return;
+    }
+    state.lineWidth = width;
+    issued++;
+    glLineWidth(width);
+}
+
+
+// Save attributes.
+void cRenderState::pushAttrib(GLbitfield mask)
+{
+    glPushAttrib(mask);
+    if (stackSize < RENDER_STATE_STACK_DEPTH)
+    {
+        stack[stackSize] = state;
+        stackMasks[stackSize] = mask;
+    }
+    stackSize++;
+}
+
+
+// Restore attributes.
+// Values outside the saved groups were not restored, so stay cached.
+void cRenderState::popAttrib()
+{
+    int i;
+    GLbitfield mask;
+    struct State *saved;
+
+    glPopAttrib();
+    if (stackSize == 0) return;
+    stackSize--;
+    if (stackSize >= RENDER_STATE_STACK_DEPTH)
+    {
+        invalidate();
+        return;
+    }
+    saved = &stack[stackSize];
+    mask = stackMasks[stackSize];
+    for (i = 0; i < NUM_RENDER_STATE_CAPS; i++)
+    {
+        if (mask & RenderStateCaps[i].attribs) state.caps[i] = saved->caps[i];
+    }
+    if (mask & GL_LIGHTING_BIT) state.shadeModel = saved->shadeModel;
+    if (mask & GL_TEXTURE_BIT)
+    {
+        state.texEnvMode = saved->texEnvMode;
+        state.texture = saved->texture;
+    }
+    if (mask & GL_COLOR_BUFFER_BIT)
+    {
+        state.blendSrc = saved->blendSrc;
+        state.blendDst = saved->blendDst;
+    }
+    if (mask & GL_LINE_BIT) state.lineWidth = saved->lineWidth;
+}
+
+
+// Forget cached state.
+void cRenderState::invalidate()
+{
+    int i;
+
+    for (i = 0; i < NUM_RENDER_STATE_CAPS; i++) state.caps[i] = -1;
+    state.shadeModel = state.texEnvMode = state.texture = -1;
+    state.blendSrc = state.blendDst = -1;
+    state.lineWidth = -1.0;
+    for (i = 0; i < stackSize && i < RENDER_STATE_STACK_DEPTH; i++) stack[i] = state;
+}
+
+
+// Start frame.
+void cRenderState::beginFrame()
+{
+    lastIssued = issued;
+    lastSkipped = skipped;
+    issued = skipped = 0;
+    invalidate();
+}
+#endif                                            // #ifndef __RENDER_STATE_HPP__
@@ -44,7 +44,10 @@
 #endif
 #include "globals.h"
 #include "frustum.hpp"
-#include "explosion.hpp"
+#include "transform.hpp"
+#include "blockBatch.hpp"
+#include "drawQueue.hpp"
+#include "particleSystem.hpp"
 #include "frameRate.hpp"
 #include "fmod.h"
 #ifdef NETWORK
@@ -57,9 +60,9 @@
 // Game name and usage.
 #define NAME "Space Squids"
 #ifdef NETWORK
-char *Usage = "Usage: %s [-id \"<X-wing ID>\"] [-color <X-wing random color seed>] [-fullscreen] [-connect <Master IP address>]\n";
+char *Usage = "Usage: %s [-id \"<X-wing ID>\"] [-color <X-wing random color seed>] [-fullscreen] [-threads <number of physics threads>] [-substeps <physics substeps per frame>] [-connect <Master IP address>]\n";
 #else
-char *Usage = "Usage: %s [-id \"<X-wing ID>\"] [-color <X-wing random color seed>] [-fullscreen]\n";
+char *Usage = "Usage: %s [-id \"<X-wing ID>\"] [-color <X-wing random color seed>] [-fullscreen] [-threads <number of physics threads>] [-substeps <physics substeps per frame>] [-blocks <number of blocks>] [-benchmark]\n";
 #endif
 
 // Network and master player status.
@@ -111,14 +114,21 @@ int myXwing = 0;                                  // Index of user's xwing.
 
 // Plasma bolts.
 class PlasmaBoltSet *plasmaBolts;
+bool boltsHitFixedBlocks();
 
 // Squids.
 struct SquidControls Squids[NUM_SQUIDS];
 void moveSquid(int);
 
-// Explosion.
+// Particles: explosions and exhaust streams.
+#define MAX_PARTICLES 4096
 #define NUM_EXPLOSION_PARTICLES 100
-cExplosion *explosion;
+#define EXPLOSION_SPEED 0.5
+#define EXPLOSION_SIZE 0.1
+#define EXPLOSION_FADE 0.04
+GLubyte ExplosionColor[4] = { 255, 51, 0, 178 };
+cParticleSystem *particles;
+void addExplosion(int body);
 
 // Frustum and camera position.
 #define FRUSTUM_ANGLE 15.0
@@ -135,9 +145,35 @@ GLfloat CameraPosition[3] = { CAMERA_X, CAMERA_Y, CAMERA_Z };
 #define CAMERA_ABOVE 0.15
 
 // Camera frustum.
+// The projection and camera matrices are built on the CPU and loaded
+// into OpenGL, so the frustum does not need to read them back.
 Frustum *frustum;
 bool inFrustum(int);
 
+// Bodies in camera view this frame, one bit per body.
+// Bounding spheres of all the bodies are culled together, and only
+// spheres straddling the frustum get the bounding block test.
+unsigned int *VisibleBodies = NULL;
+int MaxCullBodies = 0;
+GLfloat *CullX,*CullY,*CullZ,*CullRadius;
+unsigned char *CullClasses;
+void cullBodies();
+inline bool isVisible(int index)
+{
+    return((VisibleBodies[index >> 5] & (1u << (index & 31))) != 0);
+}
+cTransform ProjectionTransform;
+cTransform CameraTransform;
+
+// Levels of detail are chosen by projected size: the pixels spanned by
+// a unit length of the object's model. A level changes only once the
+// size is past the level's bound by the hysteresis fraction, so objects
+// near a bound do not flicker between levels.
+#define DETAIL_HYSTERESIS 0.2
+GLfloat XwingDetailSizes[NUM_XWING_DETAILS - 1] = { 96.0, 32.0 };
+GLfloat SquidDetailSizes[NUM_SQUID_DETAILS - 1] = { 96.0, 48.0, 24.0 };
+int selectDetail(cGameObject *, int detail, GLfloat *sizes, int numSizes, GLfloat *eye);
+
 // Delay for "spring-loaded" camera lag..
 #define CAMERA_DELAY_SIZE 50
 struct
@@ -166,6 +202,9 @@ bool SpotLightSwitch = true;
 // Max block initialization tries.
 #define BLOCK_INIT_TRIES 10
 
+// Number of free-floating blocks.
+int NumBlocks = DEFAULT_NUM_BLOCKS;
+
 // Block texture and material.
 #ifndef UNIX
 #define HELLBOX 1                                 // "Hellraiser" box
@@ -177,13 +216,18 @@ bool SpotLightSwitch = true;
 #define HELLBOX_BMP4_IMAGE "Hell4.bmp"
 #define HELLBOX_BMP5_IMAGE "Hell5.bmp"
 #define HELLBOX_BMP6_IMAGE "Hell6.bmp"
-GLuint BlockTextureName[6];
-GLint FixedBlockDisplay[7];
-GLint BlockDisplay[7];
+#define BLOCK_ATLAS_COLUMNS 4                     // Images are tiles of one texture.
+#define BLOCK_ATLAS_ROWS 2
+char *HellboxImages[6] =
+{
+    HELLBOX_BMP1_IMAGE, HELLBOX_BMP2_IMAGE, HELLBOX_BMP3_IMAGE,
+    HELLBOX_BMP4_IMAGE, HELLBOX_BMP5_IMAGE, HELLBOX_BMP6_IMAGE
+};
+int HellboxFaceImages[6] = { 0, 2, 1, 3, 2, 5 };  // Image of each block face.
 #else
 #define BLOCK_TGA_IMAGE "flake.tga"
-GLuint BlockTextureName;
 #endif
+GLuint BlockTextureName;
 bool BlockTextureLoaded;
 bool PaintBlocks = true;
 struct
@@ -213,10 +257,8 @@ void createBlock(int);
 void setBlockVertices(int, float, float, float, float, float, float);
 bool positionBlock(int);
 void buildWallDisplay(int),buildBlockDisplay(int);
-#ifdef HELLBOX
-void buildFixedBlockDisplays();
-void buildBlockDisplays();
-#endif
+class BlockBatch BlockInstances;                  // Blocks drawn this frame.
+class BlockBatch FixedBlockInstances;
 bool ShowBoundingBlocks = false;
 bool DrawWalls = true;
 
@@ -291,18 +333,23 @@ void getSounds(), freeSounds();
 bool debugMode = false;
 void idle(void);
 
+// The frame's draws, sorted by render state.
+class cDrawQueue DrawQueue;
+void drawSquid(int), drawSquidBody(int), drawXwing(int), drawXwingID(int);
+void drawBoundingBlock(int), drawStars(int), drawWall(int), drawBlocks(int);
+void drawPlasmaBolts(int), drawParticles(int);
+
 // Get world position of a point.
-void localToWorld(GLfloat *local, GLfloat *world);
 
 // Display function.
 void
 display(void)
 {
-    int i,j,k,si,xi,sb,xb;
-    Vector axis;
-    float angle;
+    int i,j,k,n,si,xi,sb,xb;
+    Vector position;
+    Quaternion orientation;
     GLfloat e[3],p[3],f[3],u[3],b,a;
-    GLfloat l[3],w[3];
+    GLfloat w[3];
     Xwing *xwing;
     Squid *squid;
 
@@ -313,6 +360,9 @@ display(void)
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
 
+    // Start counting render state changes.
+    cRenderState::beginFrame();
+
     // Not ready to display?
     if (UserMode == INTRO || UserMode == OPTIONS || UserMode == FATAL)
     {
@@ -350,6 +400,13 @@ display(void)
             return;
         }
 
+        // Render the squid impostor once the window is showing.
+        if (!Squid::ImpostorCreated())
+        {
+            Squids[0].squid->CreateImpostor();
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        }
+
         // Camera follows above and behind X-wing in a spring-loaded fashion.
         xwing = Xwings[myXwing].xwing;
         xwing->GetPosition(p);
@@ -387,79 +444,80 @@ display(void)
         e[0] = p[0] + (u[0] * (b + Xwings[myXwing].speed)) + (f[0] * a);
         e[1] = p[1] + (u[1] * (b + Xwings[myXwing].speed)) + (f[1] * a);
         e[2] = p[2] + (u[2] * (b + Xwings[myXwing].speed)) + (f[2] * a);
-        gluLookAt(e[0], e[1], e[2], p[0], p[1], p[2], f[0], f[1], f[2]);
+        CameraTransform.identity();
+        CameraTransform.lookAt(e, p, f);
+        glLoadMatrixf(CameraTransform.m);
 
-        // Get updated camera frustum.
-        delete frustum;
-        frustum = new Frustum();
+        // Update camera frustum.
+        frustum->update(ProjectionTransform.m, CameraTransform.m);
 
         // Move the blocks and determine collisions.
         #ifdef NETWORK
         if (Master)
         #endif
-            StepSimulation(frameRate.speedFactor * BLOCKSPEED_TUNE);
+            AdvanceSimulation(frameRate.speedFactor * BLOCKSPEED_TUNE);
+
+        // Draws are queued as the frame is run, then submitted together.
+        DrawQueue.clear();
 
         // Update and draw plasma bolts.
-        plasmaBolts->Go();
+        plasmaBolts->update();
+        DrawQueue.add(0, drawPlasmaBolts, 0);
+
+        // Move particles.
+        particles->update(frameRate.speedFactor);
+
+        // Bodies are queued for plasma bolt hits as they are processed.
+        plasmaBolts->clearHitQueries();
+
+        // Move squids and X-wings.
+        #ifdef NETWORK
+        if (Master)
+        {
+            #endif
+            for (si = 0; si < NUM_SQUIDS; si++) moveSquid(si);
+            for (xi = 0; xi < NUM_XWINGS; xi++) moveXwing(xi);
+            #ifdef NETWORK
+        }
+        #endif
+
+        // Find the bodies in view where they will be drawn.
+        cullBodies();
+        Squid::SetViewpoint(e);
 
         // Process squids.
         for (si = 0; si < NUM_SQUIDS; si++)
         {
             squid = Squids[si].squid;
             sb = Squids[si].bodyGroup;
-
-            // Move the squid.
-            #ifdef NETWORK
-            if (Master)
-            #endif
-                moveSquid(si);
             if (!squid->IsAlive()) continue;
 
             // Draw.
-            if (inFrustum(sb) || inFrustum(sb + 1))
+            if (isVisible(sb) || isVisible(sb + 1))
             {
-                squid->Draw();
+                squid->SetDetail(selectDetail(squid, squid->GetDetail(),
+                    SquidDetailSizes, NUM_SQUID_DETAILS - 1, e));
+                DrawQueue.add(DRAW_TEXTURED | DRAW_LIT, drawSquid, si);
+                DrawQueue.add(DRAW_BLENDED | DRAW_TEXTURED | DRAW_LIT, drawSquidBody, si);
             }
 
-            // Plasma bolt explodes squid when it hits body bounding block.
+            // Plasma bolt will explode squid if it hits body bounding block.
             for (i = sb; Bodies[i].group == sb && i < NumBodies; i++)
             {
                 if (!ShowBoundingBlocks && i != sb) break;
                 if (!Bodies[i].valid) break;
 
-                glMatrixMode(GL_MODELVIEW);
-                glPushMatrix();
-
-                // Transform block.
-                glTranslatef(Bodies[i].vPosition.x, Bodies[i].vPosition.y, Bodies[i].vPosition.z);
-                angle = QGetAngle(Bodies[i].qOrientation);
-                angle = RadiansToDegrees(angle);
-                angle = -angle;
-                axis = QGetAxis(Bodies[i].qOrientation);
-                glRotatef(angle, axis.x, axis.y, axis.z);
-
                 // Draw bounding block?
-                if (ShowBoundingBlocks)
-                {
-                    glDisable(GL_BLEND);
-                    glDisable(GL_TEXTURE_2D);
-                    glDisable(GL_LIGHTING);
-                    glLineWidth(1.0);
-
-                    // Draw block.
-                    glColor3f(Bodies[i].red, Bodies[i].green, Bodies[i].blue);
-                    glCallList(Bodies[i].display);
-                }
+                if (ShowBoundingBlocks) DrawQueue.add(0, drawBoundingBlock, i);
 
                 // Get world position of block.
                 if (i == sb)
                 {
-                    l[0] = l[1] = l[2] = 0.0;
-                    localToWorld(l, w);
+                    w[0] = Bodies[i].vPosition.x;
+                    w[1] = Bodies[i].vPosition.y;
+                    w[2] = Bodies[i].vPosition.z;
                 }
 
-                glPopMatrix();
-
                 // Plasma bolt hits squid?
                 #ifdef NETWORK
                 if (Master)
@@ -468,14 +526,7 @@ display(void)
                     if (squid->IsExploding()) continue;
                     if (i == sb)
                     {
-                        if (plasmaBolts->collision(w, Bodies[i].fRadius))
-                        {
-                            #ifdef NETWORK
-                            network->setPlasmaBoltUpdated();
-                            #endif
-                            // Explode squid.
-                            explodeSquid(si);
-                        }
+                        plasmaBolts->addHitQuery(w, Bodies[i].fRadius, i, sb);
                     }
                     #ifdef NETWORK
                 }
@@ -488,49 +539,34 @@ display(void)
         {
             xwing = Xwings[xi].xwing;
             xb = Xwings[xi].bodyGroup;
-
-            // Move the X-wing.
-            #ifdef NETWORK
-            if (Master)
-            #endif
-                moveXwing(xi);
             if (!xwing->IsAlive()) continue;
 
-            // Draw X-wing.
-            xwing->Draw();
+            // Draw X-wing if any of its bounding blocks is in view.
+            for (i = xb; Bodies[i].group == xb && i < NumBodies; i++)
+            {
+                if (isVisible(i)) break;
+            }
+            if (i < NumBodies && Bodies[i].group == xb)
+            {
+                xwing->SetDetail(selectDetail(xwing, xwing->GetDetail(),
+                    XwingDetailSizes, NUM_XWING_DETAILS - 1, e));
+                DrawQueue.add(DRAW_TEXTURED | DRAW_LIT, drawXwing, xi);
+                DrawQueue.add(DRAW_BLENDED, drawXwingID, xi);
+                xwing->EmitExhaust(particles);
+            }
 
-            // Plasma bolt explodes X-wing when it hits a bounding block.
-            glDisable(GL_BLEND);
-            glDisable(GL_TEXTURE_2D);
-            glDisable(GL_LIGHTING);
-            glLineWidth(1.0);
+            // Plasma bolt will explode X-wing if it hits a bounding block.
             for (i = xb; Bodies[i].group == xb && i < NumBodies; i++)
             {
                 if (!Bodies[i].valid) break;
 
-                glMatrixMode(GL_MODELVIEW);
-                glPushMatrix();
-
-                // Transform block.
-                glTranslatef(Bodies[i].vPosition.x, Bodies[i].vPosition.y, Bodies[i].vPosition.z);
-                angle = QGetAngle(Bodies[i].qOrientation);
-                angle = RadiansToDegrees(angle);
-                angle = -angle;
-                axis = QGetAxis(Bodies[i].qOrientation);
-                glRotatef(angle, axis.x, axis.y, axis.z);
-
                 // Draw bounding block?
-                if (ShowBoundingBlocks)
-                {
-                    glColor3f(Bodies[i].red, Bodies[i].green, Bodies[i].blue);
-                    glCallList(Bodies[i].display);
-                }
+                if (ShowBoundingBlocks) DrawQueue.add(0, drawBoundingBlock, i);
 
                 // Get world position of block.
-                l[0] = l[1] = l[2] = 0.0;
-                localToWorld(l, w);
-
-                glPopMatrix();
+                w[0] = Bodies[i].vPosition.x;
+                w[1] = Bodies[i].vPosition.y;
+                w[2] = Bodies[i].vPosition.z;
 
                 // Plasma bolt hits X-wing?
                 #ifdef NETWORK
@@ -538,149 +574,116 @@ display(void)
                 {
                     #endif
                     if (xwing->IsExploding()) continue;
-                    if (plasmaBolts->collision(w, Bodies[i].fRadius))
-                    {
-                        #ifdef NETWORK
-                        network->setPlasmaBoltUpdated();
-                        #endif
-                        if (Xwings[xi].invulnerable) continue;
 
-                        // Explode X-wing.
-                        explodeXwing(xi);
-                    }
+                    // An invulnerable X-wing absorbs every bolt hitting it.
+                    plasmaBolts->addHitQuery(w, Bodies[i].fRadius, i,
+                        Xwings[xi].invulnerable ? -1 : xb);
                     #ifdef NETWORK
                 }
                 #endif
             }
         }
 
-        glDisable(GL_BLEND);
-        glDisable(GL_TEXTURE_2D);
-        glDisable(GL_LIGHTING);
-        glLineWidth(1.0);
-        glColor3f(1.0, 1.0, 1.0);
-
         // Draw stars.
-        glPointSize(3.0);
-        glEnable(GL_POINT_SMOOTH);
-        glCallList(StarDisplay);
-        glPointSize(1.0);
-        glDisable(GL_POINT_SMOOTH);
+        DrawQueue.add(0, drawStars, 0);
 
         // Draw wall grids?
         if (DrawWalls)
         {
             for (i = 0; i < 6; i++)
             {
-                if (inFrustum(i)) glCallList(Bodies[i].display);
+                if (isVisible(i)) DrawQueue.add(0, drawWall, i);
             }
         }
 
-        // Draw blocks.
-        if (PaintBlocks)
-        {
-            glShadeModel(GL_SMOOTH);
-            glEnable(GL_TEXTURE_2D);
-            glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-            #ifndef HELLBOX
-            glBindTexture(GL_TEXTURE_2D, BlockTextureName);
-            #endif
-            glEnable(GL_LIGHTING);
-        }
-        else
-        {
-            glDisable(GL_BLEND);
-            glDisable(GL_TEXTURE_2D);
-            glDisable(GL_LIGHTING);
-        }
-        glLineWidth(1.0);
-        for (i = 0; i < NumBodies; i++)
+        // Gather blocks in camera view to draw together.
+        BlockInstances.clear();
+        FixedBlockInstances.clear();
+        for (n = 0; n < NumActiveBodies; n++)
         {
-            if (!Bodies[i].valid) continue;
+            i = ActiveBodies[n];
             if (Bodies[i].type != BLOCK_TYPE && Bodies[i].type != FIXED_BLOCK_TYPE) continue;
 
-            glMatrixMode(GL_MODELVIEW);
-            glPushMatrix();
-
-            // Transform block.
-            glTranslatef(Bodies[i].vPosition.x, Bodies[i].vPosition.y, Bodies[i].vPosition.z);
-            angle = QGetAngle(Bodies[i].qOrientation);
-            angle = RadiansToDegrees(angle);
-            axis = QGetAxis(Bodies[i].qOrientation);
-            glRotatef(angle, axis.x, axis.y, axis.z);
-
-            // Draw block if in camera view.
-            if (inFrustum(i))
+            // Blend block between physics steps.
+            InterpolateBody(i, &position, &orientation);
+            if (isVisible(i))
             {
-                #ifdef HELLBOX
-                if (!PaintBlocks)
-                {
-                    glColor3f(Bodies[i].red, Bodies[i].green, Bodies[i].blue);
-                }
-                for (j = 0; j < 6; j++)
-                {
-                    if (PaintBlocks)
-                    {
-                        switch(j)
-                        {
-                            case 0: k = 0; break;
-                            case 2: k = 1; break;
-                            case 1: k = 2; break;
-                            case 3: k = 3; break;
-                            case 4: k = 2; break;
-                            case 5: k = 5; break;
-                        }
-                        glBindTexture(GL_TEXTURE_2D, BlockTextureName[k]);
-                    }
-                    if (Bodies[i].type == FIXED_BLOCK_TYPE)
-                    {
-                        glCallList(FixedBlockDisplay[j]);
-                    }
-                    else
-                    {
-                        glCallList(BlockDisplay[j]);
-                    }
-                }
-                if (!PaintBlocks)
+                if (Bodies[i].type == FIXED_BLOCK_TYPE)
                 {
-                    if (Bodies[i].type == FIXED_BLOCK_TYPE)
-                    {
-                        glCallList(FixedBlockDisplay[6]);
-                    }
-                    else
-                    {
-                        glCallList(BlockDisplay[6]);
-                    }
+                    FixedBlockInstances.add(position, orientation,
+                        Bodies[i].red, Bodies[i].green, Bodies[i].blue);
                 }
-                #else
-                if (!PaintBlocks)
+                else
                 {
-                    glColor3f(Bodies[i].red, Bodies[i].green, Bodies[i].blue);
+                    BlockInstances.add(position, orientation,
+                        Bodies[i].red, Bodies[i].green, Bodies[i].blue);
                 }
-                glCallList(Bodies[i].display);
-                #endif
             }
 
             // Destroy plasma bolts hitting block.
-            l[0] = l[1] = l[2] = 0.0;
-            localToWorld(l, w);
+            // Fixed blocks are checked per bolt through the static tree.
+            w[0] = position.x;
+            w[1] = position.y;
+            w[2] = position.z;
 
-            glPopMatrix();
+            if (Bodies[i].type == FIXED_BLOCK_TYPE) continue;
+            #ifdef NETWORK
+            if (Master)
+            #endif
+                plasmaBolts->addHitQuery(w, Bodies[i].fRadius, i, -1);
+        }
 
+        // Resolve plasma bolt hits on squids, X-wings and blocks.
+        n = plasmaBolts->resolveHits();
+        for (k = 0; k < n; k++)
+        {
             #ifdef NETWORK
-            if (Master && plasmaBolts->collision(w, Bodies[i].fRadius))
-                network->setPlasmaBoltUpdated();
-            #else
-            plasmaBolts->collision(w, Bodies[i].fRadius);
+            network->setPlasmaBoltUpdated();
             #endif
+            i = plasmaBolts->getHitBody(k);
+            if (Bodies[i].type == SQUID_BLOCK_TYPE)
+            {
+                for (si = 0; Squids[si].bodyGroup != Bodies[i].group; si++) {}
+
+                // Explode squid.
+                explodeSquid(si);
+            }
+            else if (Bodies[i].type == XWING_BLOCK_TYPE)
+            {
+                for (xi = 0; Xwings[xi].bodyGroup != Bodies[i].group; xi++) {}
+                if (Xwings[xi].invulnerable) continue;
+
+                // Explode X-wing.
+                explodeXwing(xi);
+            }
+        }
+
+        // Draw blocks.
+        if (PaintBlocks)
+        {
+            DrawQueue.add(DRAW_TEXTURED | DRAW_LIT | BlockTextureName, drawBlocks, 0);
+        }
+        else
+        {
+            DrawQueue.add(0, drawBlocks, 0);
         }
 
-        // Explosion.
-        if (explosion->GetNumLiveParticles() > 0)
+        #ifdef NETWORK
+        if (Master && boltsHitFixedBlocks())
+            network->setPlasmaBoltUpdated();
+        #else
+        boltsHitFixedBlocks();
+        #endif
+
+        // Particles, over the translucent squid bodies.
+        if (particles->getNumParticles() > 0)
         {
-            explosion->Go();
+            DrawQueue.add(DRAW_LAST | DRAW_BLENDED, drawParticles, 0);
         }
 
+        // Submit the frame's draws.
+        DrawQueue.submit();
+
         // Check for and handle end of game.
         if (WinPending)
         {
@@ -755,25 +758,131 @@ display(void)
         glFlush();
     }
 
-    // Get world position of a point.
-    void localToWorld(GLfloat *local, GLfloat *world)
+    // Draw squid guts and tentacles.
+    void drawSquid(int index)
     {
-        int i,j;
-        GLfloat m[16];
-        Matrix x(4,4),p(4,1),t(4,1);
-
-        glGetFloatv( GL_MODELVIEW_MATRIX, m );
-        for (i=0; i < 4; i++)
-            for (j=0; j < 4; j++)
-                x(i,j) = m[(j*4)+i];
-        p(0,0) = local[0];
-        p(1,0) = local[1];
-        p(2,0) = local[2];
-        p(3,0) = 1.0;
-        t = x * p;
-        world[0] = t(0,0);
-        world[1] = t(1,0);
-        world[2] = t(2,0);
+        Squids[index].squid->DrawOpaque();
+    }
+
+    // Draw squid translucent body.
+    void drawSquidBody(int index)
+    {
+        Squids[index].squid->DrawTranslucent();
+    }
+
+    // Draw X-wing.
+    void drawXwing(int index)
+    {
+        Xwings[index].xwing->DrawOpaque();
+    }
+
+    // Draw X-wing ID.
+    void drawXwingID(int index)
+    {
+        Xwings[index].xwing->DrawTranslucent();
+    }
+
+    // Draw bounding block.
+    void drawBoundingBlock(int index)
+    {
+        Vector axis;
+        float angle;
+
+        cRenderState::disable(GL_BLEND);
+        cRenderState::disable(GL_TEXTURE_2D);
+        cRenderState::disable(GL_LIGHTING);
+        cRenderState::lineWidth(1.0);
+
+        glMatrixMode(GL_MODELVIEW);
+        glPushMatrix();
+
+        // Transform block.
+        glTranslatef(Bodies[index].vPosition.x, Bodies[index].vPosition.y, Bodies[index].vPosition.z);
+        angle = QGetAngle(Bodies[index].qOrientation);
+        angle = RadiansToDegrees(angle);
+        angle = -angle;
+        axis = QGetAxis(Bodies[index].qOrientation);
+        glRotatef(angle, axis.x, axis.y, axis.z);
+
+        // Draw block.
+        glColor3f(Bodies[index].red, Bodies[index].green, Bodies[index].blue);
+        glCallList(Bodies[index].display);
+
+        glPopMatrix();
+    }
+
+    // Draw stars.
+    void drawStars(int)
+    {
+        cRenderState::disable(GL_BLEND);
+        cRenderState::disable(GL_TEXTURE_2D);
+        cRenderState::disable(GL_LIGHTING);
+        glColor3f(1.0, 1.0, 1.0);
+        glPointSize(3.0);
+        cRenderState::enable(GL_POINT_SMOOTH);
+        glCallList(StarDisplay);
+        glPointSize(1.0);
+        cRenderState::disable(GL_POINT_SMOOTH);
+    }
+
+    // Draw wall grid.
+    void drawWall(int index)
+    {
+        cRenderState::disable(GL_BLEND);
+        cRenderState::disable(GL_TEXTURE_2D);
+        cRenderState::disable(GL_LIGHTING);
+        cRenderState::lineWidth(1.0);
+        glColor3f(1.0, 1.0, 1.0);
+        glCallList(Bodies[index].display);
+    }
+
+    // Draw the blocks gathered this frame.
+    void drawBlocks(int)
+    {
+        cRenderState::pushAttrib(GL_CURRENT_BIT | GL_LIGHTING_BIT);
+        cRenderState::disable(GL_BLEND);
+        if (PaintBlocks)
+        {
+            cRenderState::shadeModel(GL_SMOOTH);
+            cRenderState::enable(GL_TEXTURE_2D);
+            cRenderState::texEnvMode(GL_MODULATE);
+            cRenderState::bindTexture(BlockTextureName);
+            cRenderState::enable(GL_LIGHTING);
+            glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, BlockMaterial.ambient);
+            glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, BlockMaterial.diffuse);
+            glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, BlockMaterial.specular);
+            glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, BlockMaterial.emission);
+            glMaterialf (GL_FRONT_AND_BACK, GL_SHININESS, BlockMaterial.phExp);
+        }
+        else
+        {
+            cRenderState::disable(GL_TEXTURE_2D);
+            cRenderState::disable(GL_LIGHTING);
+        }
+        cRenderState::lineWidth(1.0);
+        BlockInstances.draw(PaintBlocks);
+        FixedBlockInstances.draw(PaintBlocks);
+        #ifdef HELLBOX
+        if (!PaintBlocks)
+        #endif
+        {
+            glColor3f(1.0, 1.0, 1.0);
+            BlockInstances.drawOutlines();
+            FixedBlockInstances.drawOutlines();
+        }
+        cRenderState::popAttrib();
+    }
+
+    // Draw plasma bolts.
+    void drawPlasmaBolts(int)
+    {
+        plasmaBolts->draw();
+    }
+
+    // Draw particles.
+    void drawParticles(int)
+    {
+        particles->draw(CameraTransform.m);
     }
 
     // Move X-wing normally and during collisions.
@@ -784,7 +893,8 @@ display(void)
         Xwing *xwing;
         cSpacial *spacial;
         GLfloat v[3];
-        Vector axis;
+        Vector axis,position;
+        Quaternion orientation;
         float angle;
 
         // Access X-wing.
@@ -810,7 +920,7 @@ display(void)
             {
                 for (i = xb; Bodies[i].group == xb && i < NumBodies; i++)
                 {
-                    Bodies[i].valid = false;
+                    SetBodyValid(i, false);
                 }
                 return;
             }
@@ -835,17 +945,20 @@ display(void)
                 Bodies[i].qOrientation.v.x = spacial->qcalc->quat[0];
                 Bodies[i].qOrientation.v.y = spacial->qcalc->quat[1];
                 Bodies[i].qOrientation.v.z = spacial->qcalc->quat[2];
+                InvalidateBodyCache(i);
             }
             return;
         }
 
         // Collision: bounding blocks in control of movement.
+        // Follow them blended between physics steps, as blocks are drawn.
         Xwings[index].collisionSteps--;
-        spacial->x = Bodies[xb].vPosition.x;
-        spacial->y = Bodies[xb].vPosition.y;
-        spacial->z = Bodies[xb].vPosition.z;
-        angle = QGetAngle(Bodies[xb].qOrientation);
-        axis = QGetAxis(Bodies[xb].qOrientation);
+        InterpolateBody(xb, &position, &orientation);
+        spacial->x = position.x;
+        spacial->y = position.y;
+        spacial->z = position.z;
+        angle = QGetAngle(orientation);
+        axis = QGetAxis(orientation);
         v[0] = axis.x;
         v[1] = axis.y;
         v[2] = axis.z;
@@ -899,7 +1012,7 @@ display(void)
         Xwings[i].invulnerable = false;
         for (j = Xwings[i].bodyGroup; Bodies[j].group == Xwings[i].bodyGroup && j < NumBodies; j++)
         {
-            Bodies[j].valid = true;
+            SetBodyValid(j, true);
             if (j == Xwings[i].bodyGroup)
             {
                 // Try to position non-overlapping block.
@@ -917,6 +1030,7 @@ display(void)
 
                 // Other blocks have same position.
                 Bodies[j].vPosition = Bodies[Xwings[i].bodyGroup].vPosition;
+                InvalidateBodyCache(j);
             }
         }
     }
@@ -930,10 +1044,9 @@ display(void)
         xwing->Explode();
         for (register int i = xb; Bodies[i].group == xb && i < NumBodies; i++)
         {
-            Bodies[i].valid = false;
+            SetBodyValid(i, false);
         }
-        explosion->SetLocation(Bodies[xb].vPosition.x, Bodies[xb].vPosition.y, Bodies[xb].vPosition.z);
-        explosion->Reset();
+        addExplosion(xb);
 
         // Play explosion sound.
         if (explosionSound && !muteMode) FSOUND_PlaySound(FSOUND_FREE, explosionSound);
@@ -947,8 +1060,65 @@ display(void)
         xwing->Kill();
         for (register int i = xb; Bodies[i].group == xb && i < NumBodies; i++)
         {
-            Bodies[i].valid = false;
+            SetBodyValid(i, false);
+        }
+    }
+
+    // Destroy plasma bolts hitting fixed blocks.
+    bool
+        boltsHitFixedBlocks()
+    {
+        GLfloat p[3],q[3],w[3];
+        Vector lo,hi;
+        int b,i,k,n;
+        int found[MAX_BVH_RESULTS];
+        int *list;
+        bool hit = false;
+
+        for (b = 0; b < plasmaBolts->getSize(); b++)
+        {
+            if (!plasmaBolts->isActive(b)) continue;
+
+            // Query around the bolt's last move.
+            plasmaBolts->getPreviousPosition(b, p);
+            plasmaBolts->getPosition(b, q);
+            for (k = 0; k < 3; k++)
+            {
+                if (p[k] > q[k])
+                {
+                    w[0] = p[k];
+                    p[k] = q[k];
+                    q[k] = w[0];
+                }
+            }
+            lo = Vector(p[0], p[1], p[2]);
+            hi = Vector(q[0], q[1], q[2]);
+            lo -= Vector(FIXED_BLOCK_SIZE, FIXED_BLOCK_SIZE, FIXED_BLOCK_SIZE);
+            hi += Vector(FIXED_BLOCK_SIZE, FIXED_BLOCK_SIZE, FIXED_BLOCK_SIZE);
+            list = found;
+            n = QueryStaticBVH(lo, hi, found, MAX_BVH_RESULTS);
+            if (n > MAX_BVH_RESULTS)
+            {
+                list = new int[n];
+                QueryStaticBVH(lo, hi, list, n);
+            }
+            for (k = 0; k < n; k++)
+            {
+                i = list[k];
+                if (Bodies[i].type != FIXED_BLOCK_TYPE) continue;
+                w[0] = Bodies[i].vPosition.x;
+                w[1] = Bodies[i].vPosition.y;
+                w[2] = Bodies[i].vPosition.z;
+                if (plasmaBolts->sweepHits(b, w, Bodies[i].fRadius))
+                {
+                    plasmaBolts->deactivate(b);   // destroy bolt.
+                    hit = true;
+                    break;
+                }
+            }
+            if (list != found) delete [] list;
         }
+        return(hit);
     }
 
     // Move squid normally and during collisions.
@@ -961,7 +1131,8 @@ display(void)
         Xwing *xwing;
         GLfloat v[3];
         Vector x,v1,v2;
-        float a,d,d1,d2;
+        Quaternion orientation;
+        float a,d;
         bool attack;
 
         // Access squid.
@@ -988,31 +1159,8 @@ display(void)
                 {
                     // Within attack range, is X-wing visible?
                     // Check if obscured by a block, as defined by the block radius.
-                    for (i = 0; i < NumBodies; i++)
-                    {
-                        if (!Bodies[i].valid) continue;
-                        if (Bodies[i].type != BLOCK_TYPE && Bodies[i].type != FIXED_BLOCK_TYPE) continue;
-
-                        // Make sure block is "between" X-wing and squid.
-                        v1 = Bodies[sb].vPosition - Bodies[i].vPosition;
-                        v1.Normalize();
-                        v2 = Bodies[sb].vPosition - Bodies[xb].vPosition;
-                        v2.Normalize();
-                        if ((v2*v1) <= 0.0) continue;
-                        v1 = Bodies[xb].vPosition - Bodies[i].vPosition;
-                        d1 = v1.Magnitude();
-                        v1.Normalize();
-                        v2 = Bodies[xb].vPosition - Bodies[sb].vPosition;
-                        v2.Normalize();
-                        d2 = v2 * v1;             // dot product: cos of angle.
-                        if (d2 <= 0.0) continue;
-
-                        // Is distance from block to segment between X-wing and squid < block radius?
-                        d = d2 * d1;
-                        d = sqrt((d1 * d1) - (d * d));
-                        if (d < Bodies[i].fRadius) break;
-                    }
-                    if (i == NumBodies)
+                    if (SegmentQuery(Bodies[sb].vPosition, Bodies[xb].vPosition,
+                        TYPE_MASK(BLOCK_TYPE) | TYPE_MASK(FIXED_BLOCK_TYPE)) == -1)
                     {
                         attack = true;
                         break;
@@ -1022,12 +1170,12 @@ display(void)
             if (attack)
             {
                 squid->Attack(xwing);
-                Bodies[sb + 1].valid = false;     // Disable tentacles' bounding box.
+                SetBodyValid(sb + 1, false);      // Disable tentacles' bounding box.
             }
             else
             {
                 squid->Idle();
-                Bodies[sb + 1].valid = true;
+                SetBodyValid(sb + 1, true);
             }
         }
 
@@ -1045,7 +1193,7 @@ display(void)
             if (!xwing->IsAlive())
             {
                 squid->Idle();
-                Bodies[sb + 1].valid = true;
+                SetBodyValid(sb + 1, true);
                 Bodies[sb].exempt = -1;
                 Bodies[sb + 1].exempt = -1;
                 return;
@@ -1091,6 +1239,7 @@ display(void)
                 Bodies[i].qOrientation.v.x = spacial->qcalc->quat[0];
                 Bodies[i].qOrientation.v.y = spacial->qcalc->quat[1];
                 Bodies[i].qOrientation.v.z = spacial->qcalc->quat[2];
+                InvalidateBodyCache(i);
             }
 
             // Explode target?
@@ -1179,17 +1328,20 @@ display(void)
                 Bodies[i].qOrientation.v.x = spacial->qcalc->quat[0];
                 Bodies[i].qOrientation.v.y = spacial->qcalc->quat[1];
                 Bodies[i].qOrientation.v.z = spacial->qcalc->quat[2];
+                InvalidateBodyCache(i);
             }
             return;
         }
 
         // Collision: bounding blocks in control of movement.
+        // Follow them blended between physics steps, as blocks are drawn.
         Squids[index].collisionSteps--;
-        spacial->x = Bodies[sb].vPosition.x;
-        spacial->y = Bodies[sb].vPosition.y;
-        spacial->z = Bodies[sb].vPosition.z;
-        a = QGetAngle(Bodies[sb].qOrientation);
-        x = QGetAxis(Bodies[sb].qOrientation);
+        InterpolateBody(sb, &x, &orientation);
+        spacial->x = x.x;
+        spacial->y = x.y;
+        spacial->z = x.z;
+        a = QGetAngle(orientation);
+        x = QGetAxis(orientation);
         v[0] = x.x;
         v[1] = x.y;
         v[2] = x.z;
@@ -1204,30 +1356,104 @@ display(void)
         register int sb = Squids[index].bodyGroup;
 
         squid->Explode();
-        Bodies[sb].valid = false;
-        Bodies[sb + 1].valid = false;
-        explosion->SetLocation(Bodies[sb].vPosition.x, Bodies[sb].vPosition.y, Bodies[sb].vPosition.z);
-        explosion->Reset();
+        SetBodyValid(sb, false);
+        SetBodyValid(sb + 1, false);
+        addExplosion(sb);
 
         // Play explosion sound.
         if (explosionSound && !muteMode) FSOUND_PlaySound(FSOUND_FREE, explosionSound);
     }
 
+    // Add explosion at body.
+    void addExplosion(int body)
+    {
+        GLfloat p[3];
+
+        p[0] = Bodies[body].vPosition.x;
+        p[1] = Bodies[body].vPosition.y;
+        p[2] = Bodies[body].vPosition.z;
+        particles->addBurst(p, NUM_EXPLOSION_PARTICLES, EXPLOSION_SPEED, EXPLOSION_SIZE,
+            EXPLOSION_FADE, ExplosionColor);
+    }
+
+    // Cull bodies against the camera frustum into the visibility bits.
+    void cullBodies()
+    {
+        int i,n;
+
+        // Grow arrays.
+        if (NumBodies > MaxCullBodies)
+        {
+            if (VisibleBodies != NULL)
+            {
+                delete [] VisibleBodies;
+                delete [] CullX;
+                delete [] CullY;
+                delete [] CullZ;
+                delete [] CullRadius;
+                delete [] CullClasses;
+            }
+            MaxCullBodies = NumBodies;
+            VisibleBodies = new unsigned int[(MaxCullBodies + 31) / 32];
+            CullX = new GLfloat[MaxCullBodies];
+            CullY = new GLfloat[MaxCullBodies];
+            CullZ = new GLfloat[MaxCullBodies];
+            CullRadius = new GLfloat[MaxCullBodies];
+            CullClasses = new unsigned char[MaxCullBodies];
+        }
+
+        // Bounding spheres, so no rotation is needed.
+        for (i = 0; i < NumBodies; i++)
+        {
+            CullX[i] = Bodies[i].vPosition.x;
+            CullY[i] = Bodies[i].vPosition.y;
+            CullZ[i] = Bodies[i].vPosition.z;
+            CullRadius[i] = Bodies[i].fRadius;
+        }
+        frustum->cullSpheres(NumBodies, CullX, CullY, CullZ, CullRadius, CullClasses);
+
+        // Set visibility, testing the bounding blocks of straddlers.
+        n = (MaxCullBodies + 31) / 32;
+        for (i = 0; i < n; i++) VisibleBodies[i] = 0;
+        for (i = 0; i < NumBodies; i++)
+        {
+            if (!Bodies[i].valid) continue;
+            if (CullClasses[i] == FRUSTUM_OUTSIDE) continue;
+            if (CullClasses[i] == FRUSTUM_STRADDLE && !inFrustum(i)) continue;
+            VisibleBodies[i >> 5] |= (1u << (i & 31));
+        }
+    }
+
+    // Select object's level of detail from its projected size.
+    // Level i is drawn down to sizes[i] pixels.
+    int selectDetail(cGameObject *object, int detail, GLfloat *sizes, int numSizes, GLfloat *eye)
+    {
+        GLfloat p[3],d,size;
+
+        object->GetPosition(p);
+        p[0] -= eye[0];
+        p[1] -= eye[1];
+        p[2] -= eye[2];
+        d = sqrt((p[0] * p[0]) + (p[1] * p[1]) + (p[2] * p[2]));
+        if (d < FRUSTUM_NEAR) d = FRUSTUM_NEAR;
+        size = (object->GetScale() / d) * (WindowHeight * 0.5) /
+            tan(FRUSTUM_ANGLE * 0.5 * (M_PI / 180.0));
+        if (detail > numSizes) detail = numSizes;
+        while (detail > 0 && size >= sizes[detail - 1] * (1.0 + DETAIL_HYSTERESIS)) detail--;
+        while (detail < numSizes && size < sizes[detail] * (1.0 - DETAIL_HYSTERESIS)) detail++;
+        return(detail);
+    }
+
     // Is block in frustum?
     bool
         inFrustum(int index)
     {
         int i,j;
-        Vector v[8],vtmp;
+        Vector *v;
         float d;
 
-        // Rotate bounding vertices and convert to global coordinates.
-        for(i=0; i<8; i++)
-        {
-            vtmp = Bodies[index].vVertexList[i];
-            v[i] = QVRotate(Bodies[index].qOrientation, vtmp);
-            v[i] += Bodies[index].vPosition;
-        }
+        // Bounding vertices in global coordinates.
+        v = GetBodyCache(index)->vertex;
 
         // Check for vertex intersecting frustum.
         for (i = 0; i < 6; i++)
@@ -1593,15 +1819,17 @@ display(void)
                     #ifdef NETWORK
                             if (Master)
                             {
-                                plasmaBolts->add(xwing->fire());
-                                network->setPlasmaBoltUpdated();
+                                if (xwing->fire(plasmaBolts))
+                                {
+                                    network->setPlasmaBoltUpdated();
+                                }
                             }
                             else
                             {
-                                network->fire(xwing->fire());
+                                network->fire(xwing);
                             }
                     #else
-                            plasmaBolts->add(xwing->fire());
+                            xwing->fire(plasmaBolts);
                     #endif
                             Xwings[myXwing].shotCount++;
 
@@ -1992,7 +2220,7 @@ display(void)
         TextureImage t;
         #endif
         class cSpacial *spacial;
-        GLfloat v[3];
+        GLfloat v[3],e[3],c[3],u[3];
         Vector axis;
         float angle;
 
@@ -2035,9 +2263,13 @@ display(void)
         glLoadIdentity();
 
         // Camera.
+        e[0] = CAMERA_X; e[1] = CAMERA_Y; e[2] = CAMERA_Z;
+        c[0] = c[1] = c[2] = 0.0;
+        u[0] = 0.0; u[1] = 1.0; u[2] = 0.0;
+        ProjectionTransform.perspective(FRUSTUM_ANGLE, FRUSTUM_ASPECT, FRUSTUM_NEAR, FRUSTUM_FAR);
+        ProjectionTransform.lookAt(e, c, u);
         glMatrixMode(GL_PROJECTION);
-        gluPerspective(FRUSTUM_ANGLE, FRUSTUM_ASPECT, FRUSTUM_NEAR, FRUSTUM_FAR);
-        gluLookAt(CAMERA_X, CAMERA_Y, CAMERA_Z, 0.0, 0.0, 0.0, 0.0, 1.0, 0.);
+        glLoadMatrixf(ProjectionTransform.m);
 
         // Get options.
         for (i = 1; i < argc;)
@@ -2080,6 +2312,56 @@ display(void)
                 i++;
                 continue;
             }
+            // Number of physics substeps per step.
+            if (strcmp(argv[i], "-substeps") == 0)
+            {
+                i++;
+                if (i < argc && (NumSubsteps = atoi(argv[i])) > 0)
+                {
+                    i++;
+                    continue;
+                }
+                NumSubsteps = DEFAULT_SUBSTEPS;
+                sprintf(UserMessage, Usage, argv[0]);
+                UserMode = FATAL;
+                break;
+            }
+            // Number of threads sharing collision checks.
+            if (strcmp(argv[i], "-threads") == 0)
+            {
+                i++;
+                if (i < argc && atoi(argv[i]) > 0)
+                {
+                    SetNarrowphaseThreads(atoi(argv[i]));
+                    i++;
+                    continue;
+                }
+                sprintf(UserMessage, Usage, argv[0]);
+                UserMode = FATAL;
+                break;
+            }
+            #ifndef NETWORK
+            // Number of blocks in arena.
+            if (strcmp(argv[i], "-blocks") == 0)
+            {
+                i++;
+                if (i < argc && (NumBlocks = atoi(argv[i])) >= 0)
+                {
+                    i++;
+                    continue;
+                }
+                NumBlocks = DEFAULT_NUM_BLOCKS;
+                sprintf(UserMessage, Usage, argv[0]);
+                UserMode = FATAL;
+                break;
+            }
+            // Time the collision narrowphase and quit.
+            if (strcmp(argv[i], "-benchmark") == 0)
+            {
+                BenchmarkNarrowphase(1000, 100);
+                exit(0);
+            }
+            #endif
             #ifdef NETWORK
             // Connect to master game?
             if (strcmp(argv[i], "-connect") == 0)
@@ -2180,17 +2462,16 @@ display(void)
             if (Squids[i].attackRange < 0.0) Squids[i].attackRange = 0.0;
         }
 
+        // One fixed physics step per frame at the target frame rate,
+        // catching up no further than the frame rate speed factor allows.
+        FixedTimeStep = BLOCKSPEED_TUNE;
+        MaxStepsPerFrame = (int)FrameRate::maxSpeedFactor;
+
         // Create blocks.
-        InitializePhysics();
         j = NUM_WALL_BLOCKS + NUM_FIXED_BLOCKS + NUM_BLOCKS + (NUM_XWINGS * NUM_XWING_BLOCKS);
+        InitializePhysics(j + (NUM_SQUIDS * NUM_SQUID_BLOCKS));
         NumBodies = j + (NUM_SQUIDS * NUM_SQUID_BLOCKS);
-        if (NumBodies >= MAX_BODIES)
-        {
-            sprintf(UserMessage, "Block overflow: Numbodies=%d, MAX_BODIES=%d\n", NumBodies, MAX_BODIES);
-            UserMode = FATAL;
-            NumBodies = MAX_BODIES - 1;
-        }
-        for (i = 0; i < j; i++)
+        for (i = 0; i < j; i++)
         {
             createBlock(i);
         }
@@ -2198,6 +2479,8 @@ display(void)
         {
             createBlock(i);                       // Create squid bounding boxes in pairs.
         }
+        UpdateBodyCache();
+        BuildStaticBVH();
 
         // Co-locate squids with bounding blocks.
         for (i = 0; i < NUM_SQUIDS; i++)
@@ -2220,48 +2503,29 @@ display(void)
             spacial->qcalc->build_rotmatrix(spacial->rotmatrix, spacial->qcalc->quat);
         }
 
+        // Create block models.
         #ifdef HELLBOX
-        // Create box display lists.
-        buildFixedBlockDisplays();
-        buildBlockDisplays();
+        if (NUM_FIXED_BLOCKS > 0)
+        {
+            FixedBlockInstances.build(&Bodies[FIRST_FIXED_BLOCK], (int)(FIXED_BLOCK_SIZE / 1.0),
+                HellboxFaceImages, BLOCK_ATLAS_COLUMNS, BLOCK_ATLAS_ROWS);
+        }
+        if (NUM_BLOCKS > 0)
+        {
+            BlockInstances.build(&Bodies[FIRST_BLOCK], (int)(BLOCK_SIZE / 1.0),
+                HellboxFaceImages, BLOCK_ATLAS_COLUMNS, BLOCK_ATLAS_ROWS);
+        }
+        #else
+        if (NUM_FIXED_BLOCKS > 0) FixedBlockInstances.build(&Bodies[FIRST_FIXED_BLOCK], 1);
+        if (NUM_BLOCKS > 0) BlockInstances.build(&Bodies[FIRST_BLOCK], 1);
         #endif
 
         // Load block textures.
         #ifdef HELLBOX
         BlockTextureLoaded = true;
-        if (!CreateBmpTexture(HELLBOX_BMP1_IMAGE, &BlockTextureName[0]))
-        {
-            sprintf(UserMessage, "Cannot load texture %s\n", HELLBOX_BMP1_IMAGE);
-            UserMode = FATAL;
-            BlockTextureLoaded = false;
-        }
-        if (!CreateBmpTexture(HELLBOX_BMP2_IMAGE, &BlockTextureName[1]))
-        {
-            sprintf(UserMessage, "Cannot load texture %s\n", HELLBOX_BMP2_IMAGE);
-            UserMode = FATAL;
-            BlockTextureLoaded = false;
-        }
-        if (!CreateBmpTexture(HELLBOX_BMP3_IMAGE, &BlockTextureName[2]))
-        {
-            sprintf(UserMessage, "Cannot load texture %s\n", HELLBOX_BMP3_IMAGE);
-            UserMode = FATAL;
-            BlockTextureLoaded = false;
-        }
-        if (!CreateBmpTexture(HELLBOX_BMP4_IMAGE, &BlockTextureName[3]))
-        {
-            sprintf(UserMessage, "Cannot load texture %s\n", HELLBOX_BMP4_IMAGE);
-            UserMode = FATAL;
-            BlockTextureLoaded = false;
-        }
-        if (!CreateBmpTexture(HELLBOX_BMP5_IMAGE, &BlockTextureName[4]))
+        if (!CreateBmpAtlasTexture(HellboxImages, 6, BLOCK_ATLAS_COLUMNS, BLOCK_ATLAS_ROWS, &BlockTextureName))
         {
-            sprintf(UserMessage, "Cannot load texture %s\n", HELLBOX_BMP5_IMAGE);
-            UserMode = FATAL;
-            BlockTextureLoaded = false;
-        }
-        if (!CreateBmpTexture(HELLBOX_BMP6_IMAGE, &BlockTextureName[5]))
-        {
-            sprintf(UserMessage, "Cannot load texture %s\n", HELLBOX_BMP6_IMAGE);
+            sprintf(UserMessage, "Cannot load textures %s through %s\n", HELLBOX_BMP1_IMAGE, HELLBOX_BMP6_IMAGE);
             UserMode = FATAL;
             BlockTextureLoaded = false;
         }
@@ -2283,9 +2547,9 @@ display(void)
         // Build star field display.
         buildStarDisplay();
 
-        // Create explosion.
-        explosion = new cExplosion(NUM_EXPLOSION_PARTICLES);
-        explosion->KillParticles();
+        // Create particles.
+        particles = new cParticleSystem(MAX_PARTICLES);
+        particles->loadTexture("explosion.tga");
 
         // Create lights.
         glEnable(GL_LIGHTING);
@@ -2302,7 +2566,7 @@ display(void)
         glEnable(GL_LIGHT1);
 
         // Get camera frustum.
-        frustum = new Frustum();
+        frustum = new Frustum(ProjectionTransform.m, CameraTransform.m);
 
         // Use full screen?
         #ifndef UNIX
@@ -2325,7 +2589,7 @@ display(void)
             Xwings[i].xwing->Kill();
             for (j = Xwings[i].bodyGroup; Bodies[j].group == Xwings[i].bodyGroup && j < NumBodies; j++)
             {
-                Bodies[j].valid = false;
+                SetBodyValid(j, false);
             }
         }
 
@@ -2438,7 +2702,7 @@ display(void)
                 // Try to position non-overlapping block.
                 if (!positionBlock(index))
                 {
-                    Bodies[index].valid = false;
+                    SetBodyValid(index, false);
                     return;
                 }
 
@@ -2530,17 +2794,6 @@ display(void)
             Bodies[index].green = (float)(rand()%256) / 255.0;
             Bodies[index].blue = (float)(rand()%256) / 255.0;
 
-            #ifndef HELLBOX
-            // Build display list.
-            if (index == FIRST_FIXED_BLOCK)
-            {
-                buildBlockDisplay(index);
-            }
-            else
-            {
-                Bodies[index].display = Bodies[FIRST_FIXED_BLOCK].display;
-            }
-            #endif
             return;
         }
 
@@ -2558,7 +2811,7 @@ display(void)
             // Try to position non-overlapping block.
             if (!positionBlock(index))
             {
-                Bodies[index].valid = false;
+                SetBodyValid(index, false);
                 return;
             }
 
@@ -2589,17 +2842,6 @@ display(void)
             Bodies[index].green = (float)(rand()%256) / 255.0;
             Bodies[index].blue = (float)(rand()%256) / 255.0;
 
-            #ifndef HELLBOX
-            // Build display list.
-            if (index == FIRST_BLOCK)
-            {
-                buildBlockDisplay(index);
-            }
-            else
-            {
-                Bodies[index].display = Bodies[FIRST_BLOCK].display;
-            }
-            #endif
             return;
         }
 
@@ -2610,15 +2852,12 @@ display(void)
             si = (index - FIRST_SQUID_BLOCK) / NUM_SQUID_BLOCKS;
             sb = Squids[si].bodyGroup;
             InitializeObject(index, 0.5, SQUID_BLOCK_TYPE, sb);
-            for (i = 0; i < 8; i++)
-            {
-                Bodies[index].vVertexList[i].y += 0.1;
-            }
+            setBlockVertices(index, -0.25, 0.25, -0.15, 0.35, -0.25, 0.25);
 
             // Try to position non-overlapping block.
             if (!positionBlock(index))
             {
-                Bodies[index].valid = false;
+                SetBodyValid(index, false);
                 return;
             }
 
@@ -2662,6 +2901,10 @@ display(void)
     void
         setBlockVertices(int index, float xmin, float xmax, float ymin, float ymax, float zmin, float zmax)
     {
+        int i;
+        float r,d;
+        Vector *v;
+
         Bodies[index].vVertexList[0].x = xmax;
         Bodies[index].vVertexList[0].y = ymax;
         Bodies[index].vVertexList[0].z = zmin;
@@ -2693,6 +2936,16 @@ display(void)
         Bodies[index].vVertexList[7].x = xmin;
         Bodies[index].vVertexList[7].y = ymin;
         Bodies[index].vVertexList[7].z = zmin;
+
+        // Bounding sphere through the farthest vertex.
+        for (i = 0, r = 0.0; i < 8; i++)
+        {
+            v = &Bodies[index].vVertexList[i];
+            d = (v->x * v->x) + (v->y * v->y) + (v->z * v->z);
+            if (d > r) r = d;
+        }
+        Bodies[index].fRadius = sqrt(r);
+        InvalidateBodyCache(index);
     }
 
     // Position a non-overlapping block.
@@ -2700,7 +2953,7 @@ display(void)
     bool
         positionBlock(int index)
     {
-        int i,j;
+        int i,j,k;
         float d,f;
 
         // Try to initialize non-overlapping block.
@@ -2715,15 +2968,17 @@ display(void)
             Bodies[index].vPosition.y = (f - (d / 2.0)) + Bodies[index].fRadius;
             f = (float)(rand()%((int)(d * 100.0) + 1)) / 100.0;
             Bodies[index].vPosition.z = (f - (d / 2.0)) + Bodies[index].fRadius;
+            InvalidateBodyCache(index);
 
             // Stay away from other blocks.
-            for (j = FIRST_FIXED_BLOCK; j < NumBodies; j++)
+            for (k = 0; k < NumActiveBodies; k++)
             {
-                if (index == j || Bodies[j].valid == false) continue;
+                j = ActiveBodies[k];
+                if (index == j || j < FIRST_FIXED_BLOCK) continue;
                 if ((Bodies[index].fRadius + Bodies[j].fRadius) >
                     Bodies[index].vPosition.Distance(Bodies[j].vPosition)) break;
             }
-            if (j == NumBodies) return(true);
+            if (k == NumActiveBodies) return(true);
         }
         return(false);
     }
@@ -2896,762 +3151,6 @@ display(void)
         glEndList();
     }
 
-    #ifdef HELLBOX
-    void
-        buildFixedBlockDisplays()
-    {
-        int i,j,k,n;
-        GLfloat x,y,z,tx,ty,d;
-
-        if (NUM_FIXED_BLOCKS == 0) return;
-
-        // Tile 1x1 quads on each side of block for better reflection.
-        n = (int)(FIXED_BLOCK_SIZE / 1.0);
-        d = 1.0 / (float)n;
-
-        i = 0;
-        FixedBlockDisplay[i] = glGenLists(1);
-        glNewList(FixedBlockDisplay[i], GL_COMPILE);
-        glPushAttrib(GL_ALL_ATTRIB_BITS);
-        glPushMatrix();
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, BlockMaterial.ambient);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, BlockMaterial.diffuse);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, BlockMaterial.specular);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, BlockMaterial.emission);
-        glMaterialf (GL_FRONT_AND_BACK, GL_SHININESS, BlockMaterial.phExp);
-
-        glBegin(GL_QUADS);
-        x = Bodies[FIRST_FIXED_BLOCK].vVertexList[0].x;
-        y = Bodies[FIRST_FIXED_BLOCK].vVertexList[0].y;
-        z = Bodies[FIRST_FIXED_BLOCK].vVertexList[0].z;
-        tx = ty = 1.0;
-        for (j = 0; j < n; j++)
-        {
-            for (k = 0; k < n; k++)
-            {
-                glNormal3f(1.0, 0.0, 0.0);
-                glTexCoord2f(tx, ty);
-                glVertex3f(x, y, z);
-                glNormal3f(1.0, 0.0, 0.0);
-                glTexCoord2f(tx - d, ty);
-                glVertex3f(x, y, z + 1.0);
-                glNormal3f(1.0, 0.0, 0.0);
-                glTexCoord2f(tx - d, ty - d);
-                glVertex3f(x, y - 1.0, z + 1.0);
-                glNormal3f(1.0, 0.0, 0.0);
-                glTexCoord2f(tx, ty - d);
-                glVertex3f(x, y - 1.0, z);
-                z += 1.0;
-                tx -= d;
-            }
-            z = Bodies[FIRST_FIXED_BLOCK].vVertexList[0].z;
-            tx = 1.0;
-            y -= 1.0;
-            ty -= d;
-        }
-        glEnd();
-
-        glPopAttrib();
-        glPopMatrix();
-        glEndList();
-
-        i = 1;
-        FixedBlockDisplay[i] = glGenLists(1);
-        glNewList(FixedBlockDisplay[i], GL_COMPILE);
-        glPushAttrib(GL_ALL_ATTRIB_BITS);
-        glPushMatrix();
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, BlockMaterial.ambient);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, BlockMaterial.diffuse);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, BlockMaterial.specular);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, BlockMaterial.emission);
-        glMaterialf (GL_FRONT_AND_BACK, GL_SHININESS, BlockMaterial.phExp);
-
-        glBegin(GL_QUADS);
-        x = Bodies[FIRST_FIXED_BLOCK].vVertexList[2].x;
-        y = Bodies[FIRST_FIXED_BLOCK].vVertexList[2].y;
-        z = Bodies[FIRST_FIXED_BLOCK].vVertexList[2].z;
-        tx = ty = 1.0;
-        for (j = 0; j < n; j++)
-        {
-            for (k = 0; k < n; k++)
-            {
-                glNormal3f(0.0, -1.0, 0.0);
-                glTexCoord2f(tx, ty);
-                glVertex3f(x, y, z);
-                glNormal3f(0.0, -1.0, 0.0);
-                glTexCoord2f(tx - d, ty);
-                glVertex3f(x - 1.0, y, z);
-                glNormal3f(0.0, -1.0, 0.0);
-                glTexCoord2f(tx - d, ty - d);
-                glVertex3f(x - 1.0, y, z - 1.0);
-                glNormal3f(0.0, -1.0, 0.0);
-                glTexCoord2f(tx, ty - d);
-                glVertex3f(x, y, z - 1.0);
-                x -= 1.0;
-                tx -= d;
-            }
-            x = Bodies[FIRST_FIXED_BLOCK].vVertexList[2].x;
-            tx = 1.0;
-            z -= 1.0;
-            ty -= d;
-        }
-        glEnd();
-
-        glPopAttrib();
-        glPopMatrix();
-        glEndList();
-
-        i = 2;
-        FixedBlockDisplay[i] = glGenLists(1);
-        glNewList(FixedBlockDisplay[i], GL_COMPILE);
-        glPushAttrib(GL_ALL_ATTRIB_BITS);
-        glPushMatrix();
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, BlockMaterial.ambient);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, BlockMaterial.diffuse);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, BlockMaterial.specular);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, BlockMaterial.emission);
-        glMaterialf (GL_FRONT_AND_BACK, GL_SHININESS, BlockMaterial.phExp);
-
-        glBegin(GL_QUADS);
-        x = Bodies[FIRST_FIXED_BLOCK].vVertexList[5].x;
-        y = Bodies[FIRST_FIXED_BLOCK].vVertexList[5].y;
-        z = Bodies[FIRST_FIXED_BLOCK].vVertexList[5].z;
-        tx = ty = 1.0;
-        for (j = 0; j < n; j++)
-        {
-            for (k = 0; k < n; k++)
-            {
-                glNormal3f(-1.0, 0.0, 0.0);
-                glTexCoord2f(tx, ty);
-                glVertex3f(x, y, z);
-                glNormal3f(-1.0, 0.0, 0.0);
-                glTexCoord2f(tx - d, ty);
-                glVertex3f(x, y, z - 1.0);
-                glNormal3f(-1.0, 0.0, 0.0);
-                glTexCoord2f(tx - d, ty - d);
-                glVertex3f(x, y - 1.0, z - 1.0);
-                glNormal3f(-1.0, 0.0, 0.0);
-                glTexCoord2f(tx, ty - d);
-                glVertex3f(x, y - 1.0, z);
-                z -= 1.0;
-                tx -= d;
-            }
-            z = Bodies[FIRST_FIXED_BLOCK].vVertexList[5].z;
-            tx = 1.0;
-            y -= 1.0;
-            ty -= d;
-        }
-        glEnd();
-
-        glPopAttrib();
-        glPopMatrix();
-        glEndList();
-
-        i = 3;
-        FixedBlockDisplay[i] = glGenLists(1);
-        glNewList(FixedBlockDisplay[i], GL_COMPILE);
-        glPushAttrib(GL_ALL_ATTRIB_BITS);
-        glPushMatrix();
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, BlockMaterial.ambient);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, BlockMaterial.diffuse);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, BlockMaterial.specular);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, BlockMaterial.emission);
-        glMaterialf (GL_FRONT_AND_BACK, GL_SHININESS, BlockMaterial.phExp);
-
-        glBegin(GL_QUADS);
-        x = Bodies[FIRST_FIXED_BLOCK].vVertexList[0].x;
-        y = Bodies[FIRST_FIXED_BLOCK].vVertexList[0].y;
-        z = Bodies[FIRST_FIXED_BLOCK].vVertexList[0].z;
-        tx = ty = 1.0;
-        for (j = 0; j < n; j++)
-        {
-            for (k = 0; k < n; k++)
-            {
-                glNormal3f(0.0, 1.0, 0.0);
-                glTexCoord2f(tx, ty);
-                glVertex3f(x, y, z);
-                glNormal3f(0.0, 1.0, 0.0);
-                glTexCoord2f(tx - d, ty);
-                glVertex3f(x - 1.0, y, z);
-                glNormal3f(0.0, 1.0, 0.0);
-                glTexCoord2f(tx - d, ty - d);
-                glVertex3f(x - 1.0, y, z + 1.0);
-                glNormal3f(0.0, 1.0, 0.0);
-                glTexCoord2f(tx, ty - d);
-                glVertex3f(x, y, z + 1.0);
-                x -= 1.0;
-                tx -= d;
-            }
-            x = Bodies[FIRST_FIXED_BLOCK].vVertexList[0].x;
-            tx = 1.0;
-            z += 1.0;
-            ty -= d;
-        }
-        glEnd();
-
-        glPopAttrib();
-        glPopMatrix();
-        glEndList();
-
-        i = 4;
-        FixedBlockDisplay[i] = glGenLists(1);
-        glNewList(FixedBlockDisplay[i], GL_COMPILE);
-        glPushAttrib(GL_ALL_ATTRIB_BITS);
-        glPushMatrix();
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, BlockMaterial.ambient);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, BlockMaterial.diffuse);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, BlockMaterial.specular);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, BlockMaterial.emission);
-        glMaterialf (GL_FRONT_AND_BACK, GL_SHININESS, BlockMaterial.phExp);
-
-        glBegin(GL_QUADS);
-        x = Bodies[FIRST_FIXED_BLOCK].vVertexList[1].x;
-        y = Bodies[FIRST_FIXED_BLOCK].vVertexList[1].y;
-        z = Bodies[FIRST_FIXED_BLOCK].vVertexList[1].z;
-        tx = ty = 1.0;
-        for (j = 0; j < n; j++)
-        {
-            for (k = 0; k < n; k++)
-            {
-                glNormal3f(0.0, 0.0, 1.0);
-                glTexCoord2f(tx, ty);
-                glVertex3f(x, y, z);
-                glNormal3f(0.0, 0.0, 1.0);
-                glTexCoord2f(tx - d, ty);
-                glVertex3f(x - 1.0, y, z);
-                glNormal3f(0.0, 0.0, 1.0);
-                glTexCoord2f(tx - d, ty - d);
-                glVertex3f(x - 1.0, y - 1.0, z);
-                glNormal3f(0.0, 0.0, 1.0);
-                glTexCoord2f(tx, ty - d);
-                glVertex3f(x, y - 1.0, z);
-                x -= 1.0;
-                tx -= d;
-            }
-            x = Bodies[FIRST_FIXED_BLOCK].vVertexList[1].x;
-            tx = 1.0;
-            y -= 1.0;
-            ty -= d;
-        }
-        glEnd();
-
-        glPopAttrib();
-        glPopMatrix();
-        glEndList();
-
-        i = 5;
-        FixedBlockDisplay[i] = glGenLists(1);
-        glNewList(FixedBlockDisplay[i], GL_COMPILE);
-        glPushAttrib(GL_ALL_ATTRIB_BITS);
-        glPushMatrix();
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, BlockMaterial.ambient);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, BlockMaterial.diffuse);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, BlockMaterial.specular);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, BlockMaterial.emission);
-        glMaterialf (GL_FRONT_AND_BACK, GL_SHININESS, BlockMaterial.phExp);
-
-        glBegin(GL_QUADS);
-        x = Bodies[FIRST_FIXED_BLOCK].vVertexList[4].x;
-        y = Bodies[FIRST_FIXED_BLOCK].vVertexList[4].y;
-        z = Bodies[FIRST_FIXED_BLOCK].vVertexList[4].z;
-        tx = ty = 1.0;
-        for (j = 0; j < n; j++)
-        {
-            for (k = 0; k < n; k++)
-            {
-                glNormal3f(0.0, 0.0, -1.0);
-                glTexCoord2f(tx, ty);
-                glVertex3f(x, y, z);
-                glNormal3f(0.0, 0.0, -1.0);
-                glTexCoord2f(tx - d, ty);
-                glVertex3f(x + 1.0, y, z);
-                glNormal3f(0.0, 0.0, -1.0);
-                glTexCoord2f(tx - d, ty - d);
-                glVertex3f(x + 1.0, y - 1.0, z);
-                glNormal3f(0.0, 0.0, -1.0);
-                glTexCoord2f(tx, ty - d);
-                glVertex3f(x, y - 1.0, z);
-                x += 1.0;
-                tx -= d;
-            }
-            x = Bodies[FIRST_FIXED_BLOCK].vVertexList[4].x;
-            tx = 1.0;
-            y -= 1.0;
-            ty -= d;
-        }
-        glEnd();
-
-        glPopAttrib();
-        glPopMatrix();
-        glEndList();
-
-        // Build outline.
-        i = 6;
-        FixedBlockDisplay[i] = glGenLists(1);
-        glNewList(FixedBlockDisplay[i], GL_COMPILE);
-        glPushAttrib(GL_ALL_ATTRIB_BITS);
-        glPushMatrix();
-
-        glColor3f(1.0, 1.0, 1.0);
-        glBegin(GL_LINE_LOOP);
-        x = Bodies[FIRST_FIXED_BLOCK].vVertexList[0].x;
-        y = Bodies[FIRST_FIXED_BLOCK].vVertexList[0].y;
-        z = Bodies[FIRST_FIXED_BLOCK].vVertexList[0].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_FIXED_BLOCK].vVertexList[1].x;
-        y = Bodies[FIRST_FIXED_BLOCK].vVertexList[1].y;
-        z = Bodies[FIRST_FIXED_BLOCK].vVertexList[1].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_FIXED_BLOCK].vVertexList[2].x;
-        y = Bodies[FIRST_FIXED_BLOCK].vVertexList[2].y;
-        z = Bodies[FIRST_FIXED_BLOCK].vVertexList[2].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_FIXED_BLOCK].vVertexList[3].x;
-        y = Bodies[FIRST_FIXED_BLOCK].vVertexList[3].y;
-        z = Bodies[FIRST_FIXED_BLOCK].vVertexList[3].z;
-        glVertex3f(x, y, z);
-        glEnd();
-
-        glBegin(GL_LINE_LOOP);
-        x = Bodies[FIRST_FIXED_BLOCK].vVertexList[3].x;
-        y = Bodies[FIRST_FIXED_BLOCK].vVertexList[3].y;
-        z = Bodies[FIRST_FIXED_BLOCK].vVertexList[3].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_FIXED_BLOCK].vVertexList[2].x;
-        y = Bodies[FIRST_FIXED_BLOCK].vVertexList[2].y;
-        z = Bodies[FIRST_FIXED_BLOCK].vVertexList[2].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_FIXED_BLOCK].vVertexList[6].x;
-        y = Bodies[FIRST_FIXED_BLOCK].vVertexList[6].y;
-        z = Bodies[FIRST_FIXED_BLOCK].vVertexList[6].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_FIXED_BLOCK].vVertexList[7].x;
-        y = Bodies[FIRST_FIXED_BLOCK].vVertexList[7].y;
-        z = Bodies[FIRST_FIXED_BLOCK].vVertexList[7].z;
-        glVertex3f(x, y, z);
-        glEnd();
-
-        glBegin(GL_LINE_LOOP);
-        x = Bodies[FIRST_FIXED_BLOCK].vVertexList[7].x;
-        y = Bodies[FIRST_FIXED_BLOCK].vVertexList[7].y;
-        z = Bodies[FIRST_FIXED_BLOCK].vVertexList[7].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_FIXED_BLOCK].vVertexList[6].x;
-        y = Bodies[FIRST_FIXED_BLOCK].vVertexList[6].y;
-        z = Bodies[FIRST_FIXED_BLOCK].vVertexList[6].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_FIXED_BLOCK].vVertexList[5].x;
-        y = Bodies[FIRST_FIXED_BLOCK].vVertexList[5].y;
-        z = Bodies[FIRST_FIXED_BLOCK].vVertexList[5].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_FIXED_BLOCK].vVertexList[4].x;
-        y = Bodies[FIRST_FIXED_BLOCK].vVertexList[4].y;
-        z = Bodies[FIRST_FIXED_BLOCK].vVertexList[4].z;
-        glVertex3f(x, y, z);
-        glEnd();
-
-        glBegin(GL_LINE_LOOP);
-        x = Bodies[FIRST_FIXED_BLOCK].vVertexList[0].x;
-        y = Bodies[FIRST_FIXED_BLOCK].vVertexList[0].y;
-        z = Bodies[FIRST_FIXED_BLOCK].vVertexList[0].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_FIXED_BLOCK].vVertexList[4].x;
-        y = Bodies[FIRST_FIXED_BLOCK].vVertexList[4].y;
-        z = Bodies[FIRST_FIXED_BLOCK].vVertexList[4].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_FIXED_BLOCK].vVertexList[5].x;
-        y = Bodies[FIRST_FIXED_BLOCK].vVertexList[5].y;
-        z = Bodies[FIRST_FIXED_BLOCK].vVertexList[5].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_FIXED_BLOCK].vVertexList[1].x;
-        y = Bodies[FIRST_FIXED_BLOCK].vVertexList[1].y;
-        z = Bodies[FIRST_FIXED_BLOCK].vVertexList[1].z;
-        glVertex3f(x, y, z);
-        glEnd();
-
-        glPopAttrib();
-        glPopMatrix();
-        glEndList();
-    }
-
-    void
-        buildBlockDisplays()
-    {
-        int i,j,k,n;
-        GLfloat x,y,z,tx,ty,d;
-
-        if (NUM_BLOCKS == 0) return;
-
-        // Tile 1x1 quads on each side of block for better reflection.
-        n = (int)(BLOCK_SIZE / 1.0);
-        d = 1.0 / (float)n;
-
-        i = 0;
-        BlockDisplay[i] = glGenLists(1);
-        glNewList(BlockDisplay[i], GL_COMPILE);
-        glPushAttrib(GL_ALL_ATTRIB_BITS);
-        glPushMatrix();
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, BlockMaterial.ambient);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, BlockMaterial.diffuse);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, BlockMaterial.specular);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, BlockMaterial.emission);
-        glMaterialf (GL_FRONT_AND_BACK, GL_SHININESS, BlockMaterial.phExp);
-
-        glBegin(GL_QUADS);
-        x = Bodies[FIRST_BLOCK].vVertexList[0].x;
-        y = Bodies[FIRST_BLOCK].vVertexList[0].y;
-        z = Bodies[FIRST_BLOCK].vVertexList[0].z;
-        tx = ty = 1.0;
-        for (j = 0; j < n; j++)
-        {
-            for (k = 0; k < n; k++)
-            {
-                glNormal3f(1.0, 0.0, 0.0);
-                glTexCoord2f(tx, ty);
-                glVertex3f(x, y, z);
-                glNormal3f(1.0, 0.0, 0.0);
-                glTexCoord2f(tx - d, ty);
-                glVertex3f(x, y, z + 1.0);
-                glNormal3f(1.0, 0.0, 0.0);
-                glTexCoord2f(tx - d, ty - d);
-                glVertex3f(x, y - 1.0, z + 1.0);
-                glNormal3f(1.0, 0.0, 0.0);
-                glTexCoord2f(tx, ty - d);
-                glVertex3f(x, y - 1.0, z);
-                z += 1.0;
-                tx -= d;
-            }
-            z = Bodies[FIRST_BLOCK].vVertexList[0].z;
-            tx = 1.0;
-            y -= 1.0;
-            ty -= d;
-        }
-        glEnd();
-
-        glPopAttrib();
-        glPopMatrix();
-        glEndList();
-
-        i = 1;
-        BlockDisplay[i] = glGenLists(1);
-        glNewList(BlockDisplay[i], GL_COMPILE);
-        glPushAttrib(GL_ALL_ATTRIB_BITS);
-        glPushMatrix();
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, BlockMaterial.ambient);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, BlockMaterial.diffuse);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, BlockMaterial.specular);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, BlockMaterial.emission);
-        glMaterialf (GL_FRONT_AND_BACK, GL_SHININESS, BlockMaterial.phExp);
-
-        glBegin(GL_QUADS);
-        x = Bodies[FIRST_BLOCK].vVertexList[2].x;
-        y = Bodies[FIRST_BLOCK].vVertexList[2].y;
-        z = Bodies[FIRST_BLOCK].vVertexList[2].z;
-        tx = ty = 1.0;
-        for (j = 0; j < n; j++)
-        {
-            for (k = 0; k < n; k++)
-            {
-                glNormal3f(0.0, -1.0, 0.0);
-                glTexCoord2f(tx, ty);
-                glVertex3f(x, y, z);
-                glNormal3f(0.0, -1.0, 0.0);
-                glTexCoord2f(tx - d, ty);
-                glVertex3f(x - 1.0, y, z);
-                glNormal3f(0.0, -1.0, 0.0);
-                glTexCoord2f(tx - d, ty - d);
-                glVertex3f(x - 1.0, y, z - 1.0);
-                glNormal3f(0.0, -1.0, 0.0);
-                glTexCoord2f(tx, ty - d);
-                glVertex3f(x, y, z - 1.0);
-                x -= 1.0;
-                tx -= d;
-            }
-            x = Bodies[FIRST_BLOCK].vVertexList[2].x;
-            tx = 1.0;
-            z -= 1.0;
-            ty -= d;
-        }
-        glEnd();
-
-        glPopAttrib();
-        glPopMatrix();
-        glEndList();
-
-        i = 2;
-        BlockDisplay[i] = glGenLists(1);
-        glNewList(BlockDisplay[i], GL_COMPILE);
-        glPushAttrib(GL_ALL_ATTRIB_BITS);
-        glPushMatrix();
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, BlockMaterial.ambient);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, BlockMaterial.diffuse);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, BlockMaterial.specular);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, BlockMaterial.emission);
-        glMaterialf (GL_FRONT_AND_BACK, GL_SHININESS, BlockMaterial.phExp);
-
-        glBegin(GL_QUADS);
-        x = Bodies[FIRST_BLOCK].vVertexList[5].x;
-        y = Bodies[FIRST_BLOCK].vVertexList[5].y;
-        z = Bodies[FIRST_BLOCK].vVertexList[5].z;
-        tx = ty = 1.0;
-        for (j = 0; j < n; j++)
-        {
-            for (k = 0; k < n; k++)
-            {
-                glNormal3f(-1.0, 0.0, 0.0);
-                glTexCoord2f(tx, ty);
-                glVertex3f(x, y, z);
-                glNormal3f(-1.0, 0.0, 0.0);
-                glTexCoord2f(tx - d, ty);
-                glVertex3f(x, y, z - 1.0);
-                glNormal3f(-1.0, 0.0, 0.0);
-                glTexCoord2f(tx - d, ty - d);
-                glVertex3f(x, y - 1.0, z - 1.0);
-                glNormal3f(-1.0, 0.0, 0.0);
-                glTexCoord2f(tx, ty - d);
-                glVertex3f(x, y - 1.0, z);
-                z -= 1.0;
-                tx -= d;
-            }
-            z = Bodies[FIRST_BLOCK].vVertexList[5].z;
-            tx = 1.0;
-            y -= 1.0;
-            ty -= d;
-        }
-        glEnd();
-
-        glPopAttrib();
-        glPopMatrix();
-        glEndList();
-
-        i = 3;
-        BlockDisplay[i] = glGenLists(1);
-        glNewList(BlockDisplay[i], GL_COMPILE);
-        glPushAttrib(GL_ALL_ATTRIB_BITS);
-        glPushMatrix();
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, BlockMaterial.ambient);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, BlockMaterial.diffuse);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, BlockMaterial.specular);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, BlockMaterial.emission);
-        glMaterialf (GL_FRONT_AND_BACK, GL_SHININESS, BlockMaterial.phExp);
-
-        glBegin(GL_QUADS);
-        x = Bodies[FIRST_BLOCK].vVertexList[0].x;
-        y = Bodies[FIRST_BLOCK].vVertexList[0].y;
-        z = Bodies[FIRST_BLOCK].vVertexList[0].z;
-        tx = ty = 1.0;
-        for (j = 0; j < n; j++)
-        {
-            for (k = 0; k < n; k++)
-            {
-                glNormal3f(0.0, 1.0, 0.0);
-                glTexCoord2f(tx, ty);
-                glVertex3f(x, y, z);
-                glNormal3f(0.0, 1.0, 0.0);
-                glTexCoord2f(tx - d, ty);
-                glVertex3f(x - 1.0, y, z);
-                glNormal3f(0.0, 1.0, 0.0);
-                glTexCoord2f(tx - d, ty - d);
-                glVertex3f(x - 1.0, y, z + 1.0);
-                glNormal3f(0.0, 1.0, 0.0);
-                glTexCoord2f(tx, ty - d);
-                glVertex3f(x, y, z + 1.0);
-                x -= 1.0;
-                tx -= d;
-            }
-            x = Bodies[FIRST_BLOCK].vVertexList[0].x;
-            tx = 1.0;
-            z += 1.0;
-            ty -= d;
-        }
-        glEnd();
-
-        glPopAttrib();
-        glPopMatrix();
-        glEndList();
-
-        i = 4;
-        BlockDisplay[i] = glGenLists(1);
-        glNewList(BlockDisplay[i], GL_COMPILE);
-        glPushAttrib(GL_ALL_ATTRIB_BITS);
-        glPushMatrix();
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, BlockMaterial.ambient);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, BlockMaterial.diffuse);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, BlockMaterial.specular);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, BlockMaterial.emission);
-        glMaterialf (GL_FRONT_AND_BACK, GL_SHININESS, BlockMaterial.phExp);
-
-        glBegin(GL_QUADS);
-        x = Bodies[FIRST_BLOCK].vVertexList[1].x;
-        y = Bodies[FIRST_BLOCK].vVertexList[1].y;
-        z = Bodies[FIRST_BLOCK].vVertexList[1].z;
-        tx = ty = 1.0;
-        for (j = 0; j < n; j++)
-        {
-            for (k = 0; k < n; k++)
-            {
-                glNormal3f(0.0, 0.0, 1.0);
-                glTexCoord2f(tx, ty);
-                glVertex3f(x, y, z);
-                glNormal3f(0.0, 0.0, 1.0);
-                glTexCoord2f(tx - d, ty);
-                glVertex3f(x - 1.0, y, z);
-                glNormal3f(0.0, 0.0, 1.0);
-                glTexCoord2f(tx - d, ty - d);
-                glVertex3f(x - 1.0, y - 1.0, z);
-                glNormal3f(0.0, 0.0, 1.0);
-                glTexCoord2f(tx, ty - d);
-                glVertex3f(x, y - 1.0, z);
-                x -= 1.0;
-                tx -= d;
-            }
-            x = Bodies[FIRST_BLOCK].vVertexList[1].x;
-            tx = 1.0;
-            y -= 1.0;
-            ty -= d;
-        }
-        glEnd();
-
-        glPopAttrib();
-        glPopMatrix();
-        glEndList();
-
-        i = 5;
-        BlockDisplay[i] = glGenLists(1);
-        glNewList(BlockDisplay[i], GL_COMPILE);
-        glPushAttrib(GL_ALL_ATTRIB_BITS);
-        glPushMatrix();
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, BlockMaterial.ambient);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, BlockMaterial.diffuse);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, BlockMaterial.specular);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, BlockMaterial.emission);
-        glMaterialf (GL_FRONT_AND_BACK, GL_SHININESS, BlockMaterial.phExp);
-
-        glBegin(GL_QUADS);
-        x = Bodies[FIRST_BLOCK].vVertexList[4].x;
-        y = Bodies[FIRST_BLOCK].vVertexList[4].y;
-        z = Bodies[FIRST_BLOCK].vVertexList[4].z;
-        tx = ty = 1.0;
-        for (j = 0; j < n; j++)
-        {
-            for (k = 0; k < n; k++)
-            {
-                glNormal3f(0.0, 0.0, -1.0);
-                glTexCoord2f(tx, ty);
-                glVertex3f(x, y, z);
-                glNormal3f(0.0, 0.0, -1.0);
-                glTexCoord2f(tx - d, ty);
-                glVertex3f(x + 1.0, y, z);
-                glNormal3f(0.0, 0.0, -1.0);
-                glTexCoord2f(tx - d, ty - d);
-                glVertex3f(x + 1.0, y - 1.0, z);
-                glNormal3f(0.0, 0.0, -1.0);
-                glTexCoord2f(tx, ty - d);
-                glVertex3f(x, y - 1.0, z);
-                x += 1.0;
-                tx -= d;
-            }
-            x = Bodies[FIRST_BLOCK].vVertexList[4].x;
-            tx = 1.0;
-            y -= 1.0;
-            ty -= d;
-        }
-        glEnd();
-
-        glPopAttrib();
-        glPopMatrix();
-        glEndList();
-
-        // Build outline.
-        i = 6;
-        BlockDisplay[i] = glGenLists(1);
-        glNewList(BlockDisplay[i], GL_COMPILE);
-        glPushAttrib(GL_ALL_ATTRIB_BITS);
-        glPushMatrix();
-
-        glColor3f(1.0, 1.0, 1.0);
-        glBegin(GL_LINE_LOOP);
-        x = Bodies[FIRST_BLOCK].vVertexList[0].x;
-        y = Bodies[FIRST_BLOCK].vVertexList[0].y;
-        z = Bodies[FIRST_BLOCK].vVertexList[0].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_BLOCK].vVertexList[1].x;
-        y = Bodies[FIRST_BLOCK].vVertexList[1].y;
-        z = Bodies[FIRST_BLOCK].vVertexList[1].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_BLOCK].vVertexList[2].x;
-        y = Bodies[FIRST_BLOCK].vVertexList[2].y;
-        z = Bodies[FIRST_BLOCK].vVertexList[2].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_BLOCK].vVertexList[3].x;
-        y = Bodies[FIRST_BLOCK].vVertexList[3].y;
-        z = Bodies[FIRST_BLOCK].vVertexList[3].z;
-        glVertex3f(x, y, z);
-        glEnd();
-
-        glBegin(GL_LINE_LOOP);
-        x = Bodies[FIRST_BLOCK].vVertexList[3].x;
-        y = Bodies[FIRST_BLOCK].vVertexList[3].y;
-        z = Bodies[FIRST_BLOCK].vVertexList[3].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_BLOCK].vVertexList[2].x;
-        y = Bodies[FIRST_BLOCK].vVertexList[2].y;
-        z = Bodies[FIRST_BLOCK].vVertexList[2].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_BLOCK].vVertexList[6].x;
-        y = Bodies[FIRST_BLOCK].vVertexList[6].y;
-        z = Bodies[FIRST_BLOCK].vVertexList[6].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_BLOCK].vVertexList[7].x;
-        y = Bodies[FIRST_BLOCK].vVertexList[7].y;
-        z = Bodies[FIRST_BLOCK].vVertexList[7].z;
-        glVertex3f(x, y, z);
-        glEnd();
-
-        glBegin(GL_LINE_LOOP);
-        x = Bodies[FIRST_BLOCK].vVertexList[7].x;
-        y = Bodies[FIRST_BLOCK].vVertexList[7].y;
-        z = Bodies[FIRST_BLOCK].vVertexList[7].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_BLOCK].vVertexList[6].x;
-        y = Bodies[FIRST_BLOCK].vVertexList[6].y;
-        z = Bodies[FIRST_BLOCK].vVertexList[6].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_BLOCK].vVertexList[5].x;
-        y = Bodies[FIRST_BLOCK].vVertexList[5].y;
-        z = Bodies[FIRST_BLOCK].vVertexList[5].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_BLOCK].vVertexList[4].x;
-        y = Bodies[FIRST_BLOCK].vVertexList[4].y;
-        z = Bodies[FIRST_BLOCK].vVertexList[4].z;
-        glVertex3f(x, y, z);
-        glEnd();
-
-        glBegin(GL_LINE_LOOP);
-        x = Bodies[FIRST_BLOCK].vVertexList[0].x;
-        y = Bodies[FIRST_BLOCK].vVertexList[0].y;
-        z = Bodies[FIRST_BLOCK].vVertexList[0].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_BLOCK].vVertexList[4].x;
-        y = Bodies[FIRST_BLOCK].vVertexList[4].y;
-        z = Bodies[FIRST_BLOCK].vVertexList[4].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_BLOCK].vVertexList[5].x;
-        y = Bodies[FIRST_BLOCK].vVertexList[5].y;
-        z = Bodies[FIRST_BLOCK].vVertexList[5].z;
-        glVertex3f(x, y, z);
-        x = Bodies[FIRST_BLOCK].vVertexList[1].x;
-        y = Bodies[FIRST_BLOCK].vVertexList[1].y;
-        z = Bodies[FIRST_BLOCK].vVertexList[1].z;
-        glVertex3f(x, y, z);
-        glEnd();
-
-        glPopAttrib();
-        glPopMatrix();
-        glEndList();
-    }
-    #endif
-
     // Build block display.
     void
         buildBlockDisplay(int index)
@@ -3910,10 +3409,10 @@ display(void)
     void modeInfo()
     {
         glColor3f(1.0, 1.0, 1.0);
-        glDisable(GL_BLEND);
-        glDisable(GL_TEXTURE_2D);
-        glDisable(GL_LIGHTING);
-        glLineWidth(2.0);
+        cRenderState::disable(GL_BLEND);
+        cRenderState::disable(GL_TEXTURE_2D);
+        cRenderState::disable(GL_LIGHTING);
+        cRenderState::lineWidth(2.0);
 
         setInfoProjection();
 
@@ -3996,6 +3495,11 @@ display(void)
         {
             sprintf(buf, "FPS = %d", static_cast<int>(frameRate.FPS));
             renderBitmapString(WINDOW_WIDTH - 50, 10, FONT, buf);
+            sprintf(buf, "Asleep = %d/%d", NumSleepingBodies, NumActiveBodies);
+            renderBitmapString(WINDOW_WIDTH - 90, 25, FONT, buf);
+            sprintf(buf, "States saved = %d/%d", cRenderState::getSkipped(),
+                cRenderState::getIssued() + cRenderState::getSkipped());
+            renderBitmapString(WINDOW_WIDTH - 126, 40, FONT, buf);
         }
         #endif
 
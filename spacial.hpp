@@ -14,23 +14,9 @@
 #define __SPACIAL_HPP__
 
 #include "quaternion.hpp"
-#include "matrix.h"
+#include "transform.hpp"
 #include "math_etc.h"
 
-#ifndef _NO_NAMESPACE
-using namespace std;
-using namespace math;
-#define STD std
-#else
-#define STD
-#endif
-
-#ifndef _NO_TEMPLATE
-typedef matrix<GLfloat> Matrix;
-#else
-typedef matrix Matrix;
-#endif
-
 // Pi and radians
 #define M_PI 3.14159265358979323846
 #define DIV_PI_180 .01745329251
@@ -120,71 +106,38 @@ class cSpacial
         // Get model transformation matrix.
         void getModelTransform(GLfloat *matrix)
         {
-            glMatrixMode(GL_MODELVIEW);
-            glPushMatrix();
-            glTranslatef(x, y, z);
+            cTransform t;
+
+            t.translate(x, y, z);
             qcalc->build_rotmatrix(rotmatrix, qcalc->quat);
-            glMultMatrixf(&rotmatrix[0][0]);
-            glScalef(scale, scale, scale);
-            glGetFloatv( GL_MODELVIEW_MATRIX, matrix );
-            glPopMatrix();
+            t.multiply(&rotmatrix[0][0]);
+            t.scale(scale, scale, scale);
+            t.get(matrix);
         }
 
         // Get world coordinates from local.
         void localToWorld(GLfloat *local, GLfloat *world)
         {
-            int i,j;
-            GLfloat m[16];
-            Matrix x(4,4),p(4,1),t(4,1);
-
-            getModelTransform(m);
-            for (i=0; i < 4; i++)
-                for (j=0; j < 4; j++)
-                    x(i,j) = m[(j*4)+i];
-            p(0,0) = local[0];
-            p(1,0) = local[1];
-            p(2,0) = local[2];
-            p(3,0) = 1.0;
-            t = x * p;
-            world[0] = t(0,0);
-            world[1] = t(1,0);
-            world[2] = t(2,0);
+            cTransform t;
+
+            getModelTransform(t.m);
+            t.transformPoint(local, world);
         }
 
         // Transform local point.
         void transformPoint(GLfloat *point)
         {
-            glMatrixMode(GL_MODELVIEW);
-            glPushMatrix();
-            glLoadIdentity();
             localToWorld(point, point);
-            glPopMatrix();
         }
 
         // Inverse transform local point.
         void inverseTransformPoint(GLfloat *point)
         {
-            int i,j;
-            GLfloat m[16];
-            Matrix x(4,4),y(4,4),p(4,1),t(4,1);
-
-            glMatrixMode(GL_MODELVIEW);
-            glPushMatrix();
-            glLoadIdentity();
-            getModelTransform(m);
-            for (i=0; i < 4; i++)
-                for (j=0; j < 4; j++)
-                    x(i,j) = m[(j*4)+i];
-            y = !x;
-            p(0,0) = point[0];
-            p(1,0) = point[1];
-            p(2,0) = point[2];
-            p(3,0) = 1.0;
-            t = y * p;
-            point[0] = t(0,0);
-            point[1] = t(1,0);
-            point[2] = t(2,0);
-            glPopMatrix();
+            cTransform t,inverse;
+
+            getModelTransform(t.m);
+            t.rigidInverse(&inverse);
+            inverse.transformPoint(point, point);
         }
 
         // Normalize vector.
@@ -14,13 +14,19 @@
 
 #include "game_object.hpp"
 #include "tentacle.hpp"
-
-// Number of undulation states.
-#define NUM_SQUID_UNDULATIONS NUM_TENTACLE_UNDULATIONS
+#include "renderState.hpp"
 
 // Number of tentacle extension positions.
 #define NUM_TENTACLE_EXTENSIONS NUM_TENTACLE_PROGRAMMABLE_DISPLAYS
 
+// Levels of detail: mesh levels, then a billboard impostor.
+#define NUM_SQUID_DETAILS 4
+#define SQUID_IMPOSTOR_DETAIL 3
+
+// Impostor texture size.
+#define SQUID_IMPOSTOR_WIDTH 64
+#define SQUID_IMPOSTOR_HEIGHT 128
+
 // Exploding part.
 struct SQUID_EXPLODING_PART
 {
@@ -56,15 +62,22 @@ class Squid : public cGameObject
             tentacles[0] = new Tentacle(this);
             tentacles[1] = new Tentacle(this);
             tentacles[2] = new Tentacle(this);
+            tentacles[1]->ShareUndulation(tentacles[0]);
+            tentacles[2]->ShareUndulation(tentacles[0]);
 
-            // Create display lists for body.
+            // Create meshes for body.
             createModelDrawables();
 
+            // Undulating outer body: built when first drawn.
+            outerUndulatingBody = NULL;
+            outerUndulatingPhase = 0.0;
+
             // Set tentacle display states.
-            for (i = 0; i < 3; i++) tentacleDisplayIndex[i] = 0;
+            for (i = 0; i < 3; i++) tentacleDisplayIndex[i] = -1;
             extensionCount = -1;
             moveCount = 0;
-            undulateIndex = undulateCount = 0;
+            undulatePhase = 0.0;
+            detail = 0;
 
             // Set state.
             Idle();
@@ -83,7 +96,13 @@ class Squid : public cGameObject
         }
 
         // Draw.
-        void Draw();
+        void Draw() { DrawOpaque(); DrawTranslucent(); }
+
+        // Draw guts and tentacles.
+        void DrawOpaque();
+
+        // Draw translucent outer body.
+        void DrawTranslucent();
 
         // Kill.
         void Kill() { state = DEAD; m_isAlive = false; }
@@ -91,6 +110,23 @@ class Squid : public cGameObject
         // Undulate?
         void Undulate(bool b) { undulate = b; }
 
+        // Level of detail: 0 is the full model.
+        void SetDetail(int d) { detail = d; }
+        int GetDetail() { return(detail); }
+
+        // Set world viewpoint, which impostors face.
+        static void SetViewpoint(GLfloat *p)
+        {
+            viewpoint[0] = p[0];
+            viewpoint[1] = p[1];
+            viewpoint[2] = p[2];
+        }
+
+        // Render this squid into the impostor texture.
+        // This draws to the back buffer, which must then be cleared.
+        void CreateImpostor();
+        static bool ImpostorCreated() { return(impostorInit); }
+
         // Idle state.
         void Idle()
         {
@@ -157,24 +193,46 @@ class Squid : public cGameObject
         // Tentacles.
         class Tentacle *tentacles[3];
 
-        // Create model display list.
-        static GLint outerBodyDisplay, gutsDisplay;
-        static GLint outerUndulatingBody[NUM_SQUID_UNDULATIONS];
+        // Create model meshes.
+        static cMesh *outerBodyMesh, *gutsMesh;
         static bool displayInit;
         void createModelDrawables();
 
+        // Level of detail.
+        // Meshes are drawn at the mesh level of the detail, while the
+        // impostor is the squid rendered to a texture, turned about the
+        // squid's axis toward the viewpoint. The impostor region is in
+        // squid coordinates: left, bottom, right, top.
+        int detail;
+        static const GLfloat detailCellSize[SQUID_IMPOSTOR_DETAIL - 1];
+        static bool impostorInit;
+        static GLuint impostorTextureName;
+        static GLfloat impostorRegion[4];
+        static GLfloat impostorQuad[4];
+        static GLfloat impostorTexture[4];
+        static GLfloat viewpoint[3];
+        int drawDetail();
+        void drawImpostor();
+
         // Textures.
         static GLuint outerTextureName;
         static GLuint gutsTextureName;
 
-        // Tentacle display states.
+        // Tentacle display states: extension, or -1 to undulate.
         int tentacleDisplayIndex[3];
 
         // Idle controls.
+        // Undulation is a sine wave along the body and tentacles whose
+        // phase advances with time. The outer body wave's sine and cosine
+        // at each model vertex are kept, so that the wave at any phase
+        // needs no further sines.
         bool undulate;
-        int undulateIndex;
-        static const int undulateFreq;
-        int undulateCount;
+        GLfloat undulatePhase;                    // degrees
+        static const GLfloat undulateSpeed;       // degrees per frame
+        cMesh *outerUndulatingBody;
+        GLfloat outerUndulatingPhase;
+        static GLfloat *outerUndulationSin,*outerUndulationCos;
+        static GLfloat (*outerUndulationVertices)[3];
         static const GLfloat idleSpeed;
         static const int changeDirectionFreq;
         int moveCount;
@@ -194,6 +252,12 @@ class Squid : public cGameObject
                                                   // Outer body, guts, and three tentacles.
         struct SQUID_EXPLODING_PART explodingParts[5];
         void explosionTransform(int);
+
+        // Transform to squid coordinates.
+        void transform();
+
+        // Move undulating outer body to the undulation phase.
+        void undulateOuterBody();
 };
 
 // States.
@@ -203,18 +267,29 @@ const int Squid::DESTROY = 2;
 const int Squid::EXPLODE = 3;
 const int Squid::DEAD = 4;
 
-// Displays.
-GLint Squid::outerBodyDisplay;
-GLint Squid::gutsDisplay;
-GLint Squid::outerUndulatingBody[NUM_SQUID_UNDULATIONS];
+// Meshes.
+cMesh *Squid::outerBodyMesh = NULL;
+cMesh *Squid::gutsMesh = NULL;
+GLfloat *Squid::outerUndulationSin = NULL;
+GLfloat *Squid::outerUndulationCos = NULL;
+GLfloat (*Squid::outerUndulationVertices)[3] = NULL;
 bool Squid::displayInit = false;
 
+// Level of detail.
+const GLfloat Squid::detailCellSize[SQUID_IMPOSTOR_DETAIL - 1] = { 0.1, 0.2 };
+bool Squid::impostorInit = false;
+GLuint Squid::impostorTextureName = 0;
+GLfloat Squid::impostorRegion[4] = { -0.75, -2.0, 0.75, 1.0 };
+GLfloat Squid::impostorQuad[4];
+GLfloat Squid::impostorTexture[4];
+GLfloat Squid::viewpoint[3];
+
 // Textures.
 GLuint Squid::outerTextureName;
 GLuint Squid::gutsTextureName;
 
 // Idle parameters.
-const int Squid::undulateFreq = 10;
+const GLfloat Squid::undulateSpeed = 3.6;
 const GLfloat Squid::idleSpeed = -0.05;
 const int Squid::changeDirectionFreq = 10;
 
@@ -231,11 +306,11 @@ const float Squid::maxExplosionAngularVelocity = 3.0;
 #include "squid_outer_body.h"
 #include "squid_guts.h"
 
-// Create model display list.
+// Create model meshes.
 void Squid::createModelDrawables()
 {
-    int i,j,u;
-    GLfloat x,y,z,my,dy,a,s,amp,freq;
+    int i,j,n;
+    GLfloat my,dy,a,amp,freq;
     GLubyte texture[2][2][3];
     struct TentacleSegmentTransform segmentTransform[NUM_TENTACLE_SEGMENTS];
 
@@ -260,86 +335,30 @@ void Squid::createModelDrawables()
     glTexImage2D(GL_TEXTURE_2D, 0, 3, 2, 2, 0, GL_RGB, GL_UNSIGNED_BYTE, &(texture[0][0][0]));
 
     // Outer body.
-    GLint lid=glGenLists(1);
-    int mcount=0;
-    int mindex=0;
-    glNewList(lid, GL_COMPILE);
-
-    glBegin (GL_TRIANGLES);
-    for(i=0;i<sizeof(squid_outer_face_indicies)/sizeof(squid_outer_face_indicies[0]);i++)
+    outerBodyMesh = new cMesh();
+    outerBodyMesh->build(squid_outer_face_indicies,
+        sizeof(squid_outer_face_indicies)/sizeof(squid_outer_face_indicies[0]),
+        squid_outer_vertices, squid_outer_normals, squid_outer_textures,
+        squid_outer_material_ref, squid_outer_SelectMaterial);
+    for (i = 0; i < SQUID_IMPOSTOR_DETAIL - 1; i++)
     {
-        if(!mcount)
-        {
-            squid_outer_SelectMaterial(squid_outer_material_ref[mindex][0]);
-            mcount=squid_outer_material_ref[mindex][1];
-            mindex++;
-        }
-        mcount--;
-        for(j=0;j<3;j++)
-        {
-            int vi=squid_outer_face_indicies[i][j];
-                                                  //Normal index
-            int ni=squid_outer_face_indicies[i][j+3];
-                                                  //Texture index
-            int ti=squid_outer_face_indicies[i][j+6];
-            glNormal3f (squid_outer_normals[ni][0],squid_outer_normals[ni][1],squid_outer_normals[ni][2]);
-            glTexCoord2f(squid_outer_textures[ti][0],squid_outer_textures[ti][1]);
-            glVertex3f (squid_outer_vertices[vi][0],squid_outer_vertices[vi][1],squid_outer_vertices[vi][2]);
-        }
+        outerBodyMesh->addLevel(detailCellSize[i]);
     }
-    glEnd ();
-
-    glEndList();
-    outerBodyDisplay = lid;
 
-    // Create undulating outer bodies.
+    // Create outer body undulation wave: x and z are scaled according to y.
+    amp = 10.0;                                   // amplitude of wave: larger = smaller wave.
+    freq = 360.0;                                 // frequency: greater = more "wiggles"
     my = SquidOuterDimensions[1].min;
     dy = SquidOuterDimensions[1].delta;
-    for (u = 0; u < NUM_SQUID_UNDULATIONS; u++)
+    n = sizeof(squid_outer_vertices)/sizeof(squid_outer_vertices[0]);
+    outerUndulationSin = new GLfloat[n];
+    outerUndulationCos = new GLfloat[n];
+    outerUndulationVertices = new GLfloat[n][3];
+    for (i = 0; i < n; i++)
     {
-        lid=glGenLists(1);
-        mcount=0;
-        mindex=0;
-        glNewList(lid, GL_COMPILE);
-
-        glBegin (GL_TRIANGLES);
-        for(i=0;i<sizeof(squid_outer_face_indicies)/sizeof(squid_outer_face_indicies[0]);i++)
-        {
-            if(!mcount)
-            {
-                squid_outer_SelectMaterial(squid_outer_material_ref[mindex][0]);
-                mcount=squid_outer_material_ref[mindex][1];
-                mindex++;
-            }
-            mcount--;
-            for(j=0;j<3;j++)
-            {
-                int vi=squid_outer_face_indicies[i][j];
-                                                  //Normal index
-                int ni=squid_outer_face_indicies[i][j+3];
-                                                  //Texture index
-                int ti=squid_outer_face_indicies[i][j+6];
-                glNormal3f (squid_outer_normals[ni][0],squid_outer_normals[ni][1],squid_outer_normals[ni][2]);
-                glTexCoord2f(squid_outer_textures[ti][0],squid_outer_textures[ti][1]);
-
-                // Scale x and z according to y using a shifted sine wave.
-                amp = 10.0;                       // amplitude of wave: larger = smaller wave.
-                freq = 360.0;                     // frequency: greater = more "wiggles"
-                x = squid_outer_vertices[vi][0];
-                y = squid_outer_vertices[vi][1];
-                z = squid_outer_vertices[vi][2];
-                a = (y + my) * (freq / dy);
-                a += (GLfloat)u * (freq / (GLfloat)NUM_SQUID_UNDULATIONS);
-                s = (sin(a * (M_PI / 180.0)) + amp) / amp;
-                x *= s;
-                z *= s;
-                glVertex3f (x, y, z);
-            }
-        }
-        glEnd ();
-
-        glEndList();
-        outerUndulatingBody[u] = lid;
+        a = (squid_outer_vertices[i][1] + my) * (freq / dy);
+        outerUndulationSin[i] = sin(a * (M_PI / 180.0)) / amp;
+        outerUndulationCos[i] = cos(a * (M_PI / 180.0)) / amp;
     }
 
     // Create guts texture.
@@ -359,37 +378,15 @@ void Squid::createModelDrawables()
     glTexImage2D(GL_TEXTURE_2D, 0, 3, 2, 2, 0, GL_RGB, GL_UNSIGNED_BYTE, &(texture[0][0][0]));
 
     // Guts.
-    lid=glGenLists(1);
-    mcount=0;
-    mindex=0;
-    glNewList(lid, GL_COMPILE);
-
-    glBegin (GL_TRIANGLES);
-    for(i=0;i<sizeof(squid_guts_face_indicies)/sizeof(squid_guts_face_indicies[0]);i++)
+    gutsMesh = new cMesh();
+    gutsMesh->build(squid_guts_face_indicies,
+        sizeof(squid_guts_face_indicies)/sizeof(squid_guts_face_indicies[0]),
+        squid_guts_vertices, squid_guts_normals, squid_guts_textures,
+        squid_guts_material_ref, squid_guts_SelectMaterial);
+    for (i = 0; i < SQUID_IMPOSTOR_DETAIL - 1; i++)
     {
-        if(!mcount)
-        {
-            squid_guts_SelectMaterial(squid_guts_material_ref[mindex][0]);
-            mcount=squid_guts_material_ref[mindex][1];
-            mindex++;
-        }
-        mcount--;
-        for(j=0;j<3;j++)
-        {
-            int vi=squid_guts_face_indicies[i][j];
-                                                  //Normal index
-            int ni=squid_guts_face_indicies[i][j+3];
-                                                  //Texture index
-            int ti=squid_guts_face_indicies[i][j+6];
-            glNormal3f (squid_guts_normals[ni][0],squid_guts_normals[ni][1],squid_guts_normals[ni][2]);
-            glTexCoord2f(squid_guts_textures[ti][0],squid_guts_textures[ti][1]);
-            glVertex3f (squid_guts_vertices[vi][0],squid_guts_vertices[vi][1],squid_guts_vertices[vi][2]);
-        }
+        gutsMesh->addLevel(detailCellSize[i]);
     }
-    glEnd ();
-
-    glEndList();
-    gutsDisplay = lid;
 
     // Create tentacle extensions.
     for (j = 0; j < NUM_TENTACLE_EXTENSIONS; j++)
@@ -409,60 +406,55 @@ void Squid::createModelDrawables()
         segmentTransform[10].yaw = 3.0 * j;
         segmentTransform[15].yaw = -3.0 * j;
         tentacles[0]->SetSegmentTransforms(segmentTransform);
-        tentacles[0]->BuildSegmentTransforms(NUM_SQUID_UNDULATIONS + j);
+        tentacles[0]->BuildSegmentTransforms(j);
     }
 }
 
 
-// Draw squid.
-void Squid::Draw()
+// Transform to squid coordinates.
+void Squid::transform()
+{
+    glTranslatef(m_spacial->x, m_spacial->y, m_spacial->z);
+    glMultMatrixf(&m_spacial->rotmatrix[0][0]);
+    glScalef(m_spacial->scale, m_spacial->scale, m_spacial->scale);
+}
+
+
+// Draw guts and tentacles.
+void Squid::DrawOpaque()
 {
+    int d;
     GLfloat f;
 
+    // The impostor is drawn with the translucent body.
+    d = drawDetail();
+    if (d == SQUID_IMPOSTOR_DETAIL) return;
+
     glMatrixMode(GL_MODELVIEW);
     glPushMatrix();
-
-    // Transform.
-    glTranslatef(m_spacial->x, m_spacial->y, m_spacial->z);
-    glMultMatrixf(&m_spacial->rotmatrix[0][0]);
-    glScalef(m_spacial->scale, m_spacial->scale, m_spacial->scale);
+    transform();
 
     // Set smooth texture mapping and lighting.
-    glShadeModel(GL_SMOOTH);
-    glDisable(GL_BLEND);
-    glEnable(GL_TEXTURE_2D);
-    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-    glEnable(GL_LIGHTING);
+    cRenderState::shadeModel(GL_SMOOTH);
+    cRenderState::disable(GL_BLEND);
+    cRenderState::enable(GL_TEXTURE_2D);
+    cRenderState::texEnvMode(GL_MODULATE);
+    cRenderState::enable(GL_LIGHTING);
 
-    // Draw guts and outer body.
+    // Draw guts.
     glPushMatrix();
     glTranslatef(0.0, 0.225, 0.0);
     f = 0.75;
     glScalef(f, f, f);
     if (state == EXPLODE) explosionTransform(0);
-    glBindTexture(GL_TEXTURE_2D, gutsTextureName);
-    glCallList(gutsDisplay);
+    cRenderState::bindTexture(gutsTextureName);
+    gutsMesh->drawLevel(d);
     glPopMatrix();
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glPushMatrix();
-    glTranslatef(0.0, 0.275, 0.0);
-    glScalef(1.0, 0.8, 1.0);
-    if (state == EXPLODE) explosionTransform(1);
-    glBindTexture(GL_TEXTURE_2D, outerTextureName);
-    if (!undulate)
-    {
-        glCallList(outerBodyDisplay);
-    }
-    else
-    {
-        // Draw undulating body.
-        glCallList(outerUndulatingBody[undulateIndex]);
-    }
-    glPopMatrix();
-    glDisable(GL_BLEND);
 
     // Draw tentacles.
+    tentacles[0]->SetDetail(d);
+    tentacles[1]->SetDetail(d);
+    tentacles[2]->SetDetail(d);
     f = 1.5;
     glScalef(f, f, f);
     f = M_PI / 180.0;
@@ -478,7 +470,10 @@ void Squid::Draw()
     else
     {
         if (state == EXPLODE) explosionTransform(2);
-        tentacles[0]->Draw(tentacleDisplayIndex[0]);
+        if (tentacleDisplayIndex[0] == -1)
+            tentacles[0]->DrawUndulating(undulate ? undulatePhase : 0.0);
+        else
+            tentacles[0]->Draw(tentacleDisplayIndex[0]);
     }
     glPopMatrix();
 
@@ -493,7 +488,10 @@ void Squid::Draw()
     else
     {
         if (state == EXPLODE) explosionTransform(3);
-        tentacles[1]->Draw(tentacleDisplayIndex[1]);
+        if (tentacleDisplayIndex[1] == -1)
+            tentacles[1]->DrawUndulating(undulate ? undulatePhase : 0.0);
+        else
+            tentacles[1]->Draw(tentacleDisplayIndex[1]);
     }
     glPopMatrix();
 
@@ -508,7 +506,88 @@ void Squid::Draw()
     else
     {
         if (state == EXPLODE) explosionTransform(4);
-        tentacles[2]->Draw(tentacleDisplayIndex[2]);
+        if (tentacleDisplayIndex[2] == -1)
+            tentacles[2]->DrawUndulating(undulate ? undulatePhase : 0.0);
+        else
+            tentacles[2]->Draw(tentacleDisplayIndex[2]);
+    }
+    glPopMatrix();
+
+    glPopMatrix();
+}
+
+
+// Move undulating outer body to the undulation phase.
+void Squid::undulateOuterBody()
+{
+    int i,n;
+    GLfloat c,s,d;
+
+    if (outerUndulatingBody != NULL && undulatePhase == outerUndulatingPhase) return;
+    outerUndulatingPhase = undulatePhase;
+    c = cos(undulatePhase * (M_PI / 180.0));
+    s = sin(undulatePhase * (M_PI / 180.0));
+    n = sizeof(squid_outer_vertices)/sizeof(squid_outer_vertices[0]);
+    for (i = 0; i < n; i++)
+    {
+        d = 1.0 + (outerUndulationSin[i] * c) + (outerUndulationCos[i] * s);
+        outerUndulationVertices[i][0] = squid_outer_vertices[i][0] * d;
+        outerUndulationVertices[i][1] = squid_outer_vertices[i][1];
+        outerUndulationVertices[i][2] = squid_outer_vertices[i][2] * d;
+    }
+    if (outerUndulatingBody == NULL)
+    {
+        outerUndulatingBody = new cMesh();
+        outerUndulatingBody->build(outerBodyMesh, outerUndulationVertices, true);
+    }
+    else
+    {
+        outerUndulatingBody->setVertices(outerUndulationVertices);
+    }
+}
+
+
+// Draw translucent outer body.
+void Squid::DrawTranslucent()
+{
+    int d;
+
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    transform();
+
+    // Draw impostor?
+    d = drawDetail();
+    if (d == SQUID_IMPOSTOR_DETAIL)
+    {
+        drawImpostor();
+        glPopMatrix();
+        return;
+    }
+
+    // Set smooth blended texture mapping and lighting.
+    cRenderState::shadeModel(GL_SMOOTH);
+    cRenderState::enable(GL_BLEND);
+    cRenderState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    cRenderState::enable(GL_TEXTURE_2D);
+    cRenderState::texEnvMode(GL_MODULATE);
+    cRenderState::enable(GL_LIGHTING);
+
+    // Draw outer body.
+    glPushMatrix();
+    glTranslatef(0.0, 0.275, 0.0);
+    glScalef(1.0, 0.8, 1.0);
+    if (state == EXPLODE) explosionTransform(1);
+    cRenderState::bindTexture(outerTextureName);
+    if (!undulate)
+    {
+        outerBodyMesh->drawLevel(d);
+    }
+    else
+    {
+        // Draw undulating body.
+        undulateOuterBody();
+        outerUndulatingBody->drawLevel(d);
     }
     glPopMatrix();
 
@@ -516,10 +595,156 @@ void Squid::Draw()
 }
 
 
+// Detail to draw: the impostor only shows the whole squid at rest.
+int Squid::drawDetail()
+{
+    if (detail >= SQUID_IMPOSTOR_DETAIL)
+    {
+        if (impostorTextureName == 0 || state == DESTROY || state == EXPLODE)
+        {
+            return(SQUID_IMPOSTOR_DETAIL - 1);
+        }
+        return(SQUID_IMPOSTOR_DETAIL);
+    }
+    return(detail);
+}
+
+
+// Render this squid into the impostor texture.
+void Squid::CreateImpostor()
+{
+    int i,j,k,x0,y0,x1,y1,saveDetail;
+    GLfloat w,h;
+    GLubyte *pixels;
+    cTransform placement,inverse;
+
+    if (impostorInit) return;
+    impostorInit = true;
+
+    // Draw in squid coordinates from the front, the region filling the
+    // texture-sized corner of the viewport.
+    cRenderState::pushAttrib(GL_VIEWPORT_BIT | GL_COLOR_BUFFER_BIT);
+    glViewport(0, 0, SQUID_IMPOSTOR_WIDTH, SQUID_IMPOSTOR_HEIGHT);
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    w = m_spacial->scale;
+    glOrtho(impostorRegion[0] * w, impostorRegion[2] * w,
+        impostorRegion[1] * w, impostorRegion[3] * w, -4.0 * w, 4.0 * w);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    placement.translate(m_spacial->x, m_spacial->y, m_spacial->z);
+    placement.multiply(&m_spacial->rotmatrix[0][0]);
+    placement.rigidInverse(&inverse);
+    glLoadMatrixf(inverse.m);
+    saveDetail = detail;
+    detail = 0;
+    DrawOpaque();
+    DrawTranslucent();
+    detail = saveDetail;
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+    cRenderState::popAttrib();
+
+    // Read back, making the background transparent, and find the
+    // bounds of the squid.
+    pixels = new GLubyte[SQUID_IMPOSTOR_WIDTH * SQUID_IMPOSTOR_HEIGHT * 4];
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, SQUID_IMPOSTOR_WIDTH, SQUID_IMPOSTOR_HEIGHT, GL_RGBA,
+        GL_UNSIGNED_BYTE, pixels);
+    x0 = SQUID_IMPOSTOR_WIDTH;
+    y0 = SQUID_IMPOSTOR_HEIGHT;
+    x1 = y1 = -1;
+    for (i = 0; i < SQUID_IMPOSTOR_HEIGHT; i++)
+    {
+        for (j = 0; j < SQUID_IMPOSTOR_WIDTH; j++)
+        {
+            k = ((i * SQUID_IMPOSTOR_WIDTH) + j) * 4;
+            if (pixels[k] == 0 && pixels[k + 1] == 0 && pixels[k + 2] == 0)
+            {
+                pixels[k + 3] = 0;
+                continue;
+            }
+            pixels[k + 3] = 255;
+            if (j < x0) x0 = j;
+            if (j > x1) x1 = j;
+            if (i < y0) y0 = i;
+            if (i > y1) y1 = i;
+        }
+    }
+    if (x1 == -1)
+    {
+        delete [] pixels;
+        return;
+    }
+    x1++;
+    y1++;
+    w = (impostorRegion[2] - impostorRegion[0]) / SQUID_IMPOSTOR_WIDTH;
+    h = (impostorRegion[3] - impostorRegion[1]) / SQUID_IMPOSTOR_HEIGHT;
+    impostorQuad[0] = impostorRegion[0] + (x0 * w);
+    impostorQuad[1] = impostorRegion[1] + (y0 * h);
+    impostorQuad[2] = impostorRegion[0] + (x1 * w);
+    impostorQuad[3] = impostorRegion[1] + (y1 * h);
+    impostorTexture[0] = (GLfloat)x0 / SQUID_IMPOSTOR_WIDTH;
+    impostorTexture[1] = (GLfloat)y0 / SQUID_IMPOSTOR_HEIGHT;
+    impostorTexture[2] = (GLfloat)x1 / SQUID_IMPOSTOR_WIDTH;
+    impostorTexture[3] = (GLfloat)y1 / SQUID_IMPOSTOR_HEIGHT;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glGenTextures(1, &impostorTextureName);
+    glBindTexture(GL_TEXTURE_2D, impostorTextureName);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SQUID_IMPOSTOR_WIDTH, SQUID_IMPOSTOR_HEIGHT, 0,
+        GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    cRenderState::invalidate();
+    delete [] pixels;
+}
+
+
+// Draw impostor, turned about the squid's axis toward the viewpoint.
+void Squid::drawImpostor()
+{
+    cTransform placement,inverse;
+    GLfloat v[3];
+
+    placement.translate(m_spacial->x, m_spacial->y, m_spacial->z);
+    placement.multiply(&m_spacial->rotmatrix[0][0]);
+    placement.rigidInverse(&inverse);
+    inverse.transformPoint(viewpoint, v);
+    glRotatef(atan2(v[0], v[2]) * (180.0 / M_PI), 0.0, 1.0, 0.0);
+
+    // Blended texture without lighting; clear texels are not drawn.
+    cRenderState::enable(GL_BLEND);
+    cRenderState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    cRenderState::enable(GL_TEXTURE_2D);
+    cRenderState::texEnvMode(GL_REPLACE);
+    cRenderState::disable(GL_LIGHTING);
+    cRenderState::bindTexture(impostorTextureName);
+    glEnable(GL_ALPHA_TEST);
+    glAlphaFunc(GL_GREATER, 0.5);
+    glBegin(GL_QUADS);
+    glTexCoord2f(impostorTexture[0], impostorTexture[1]);
+    glVertex3f(impostorQuad[0], impostorQuad[1], 0.0);
+    glTexCoord2f(impostorTexture[2], impostorTexture[1]);
+    glVertex3f(impostorQuad[2], impostorQuad[1], 0.0);
+    glTexCoord2f(impostorTexture[2], impostorTexture[3]);
+    glVertex3f(impostorQuad[2], impostorQuad[3], 0.0);
+    glTexCoord2f(impostorTexture[0], impostorTexture[3]);
+    glVertex3f(impostorQuad[0], impostorQuad[3], 0.0);
+    glEnd();
+    glDisable(GL_ALPHA_TEST);
+}
+
+
 // Idle update.
 void Squid::IdleUpdate()
 {
-    int i,j;
+    int i;
 
     // Ramble around.
     SetSpeed(idleSpeed);
@@ -546,26 +771,19 @@ void Squid::IdleUpdate()
         extensionCount--;
         for (i = 0; i < 3; i++)
         {
-            tentacleDisplayIndex[i] = extensionCount + NUM_SQUID_UNDULATIONS;
+            tentacleDisplayIndex[i] = extensionCount;
         }
         return;
     }
     extensionCount = -1;
+    for (i = 0; i < 3; i++) tentacleDisplayIndex[i] = -1;
 
-    // Advance undulations.
+    // Advance undulation.
     if (undulate)
     {
-        undulateCount++;
-        if (undulateCount < undulateFreq) return;
-        undulateCount = 0;
-        undulateIndex = (undulateIndex + 1) % NUM_SQUID_UNDULATIONS;
-        j = undulateIndex;
+        undulatePhase += undulateSpeed * GetSpeedFactor();
+        undulatePhase = fmod(undulatePhase, (GLfloat)360.0);
     }
-    else
-    {
-        j = 0;
-    }
-    for (i = 0; i < 3; i++) tentacleDisplayIndex[i] = j;
 }
 
 
@@ -617,7 +835,7 @@ void Squid::AttackUpdate()
         extensionCount++;
         for (i = 0; i < 3; i++)
         {
-            tentacleDisplayIndex[i] = extensionCount + NUM_SQUID_UNDULATIONS;
+            tentacleDisplayIndex[i] = extensionCount;
         }
         return;
     }
@@ -640,6 +858,7 @@ void Squid::AttackUpdate()
 void Squid::Destroy(int targetIndex)
 {
     GLfloat f;
+    cTransform transform,placement;
 
     state = DESTROY;
     SetSpeed(0.0);
@@ -647,39 +866,31 @@ void Squid::Destroy(int targetIndex)
     undulate = false;
 
     // Set squid transform state.
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
-    glTranslatef(m_spacial->x, m_spacial->y, m_spacial->z);
-    glMultMatrixf(&m_spacial->rotmatrix[0][0]);
-    glScalef(m_spacial->scale, m_spacial->scale, m_spacial->scale);
+    transform.translate(m_spacial->x, m_spacial->y, m_spacial->z);
+    transform.multiply(&m_spacial->rotmatrix[0][0]);
+    transform.scale(m_spacial->scale, m_spacial->scale, m_spacial->scale);
 
     // Build tentacle configurations to grasp target.
     f = 1.5;
-    glScalef(f, f, f);
+    transform.scale(f, f, f);
     f = M_PI / 180.0;
-    glPushMatrix();
-    glTranslatef(cos(90.0 * f) * .05, -.5, sin(90.0 * f) * .05);
-    glRotatef(90.0, 0.0, 1.0, 0.0);
-    glRotatef(-90.0, 1.0, 0.0, 0.0);
-    tentacles[0]->BuildGrasp(targetIndex);
-    glPopMatrix();
-
-    glPushMatrix();
-    glTranslatef(cos(-30.0 * f) * .05, -.5, sin(-30.0 * f) * .05);
-    glRotatef(-150.0, 0.0, 1.0, 0.0);
-    glRotatef(-90.0, 1.0, 0.0, 0.0);
-    tentacles[1]->BuildGrasp(targetIndex);
-    glPopMatrix();
-
-    glPushMatrix();
-    glTranslatef(cos(-150.0 * f) * .05, -.5, sin(-150.0 * f) * .05);
-    glRotatef(-30.0, 0.0, 1.0, 0.0);
-    glRotatef(-90.0, 1.0, 0.0, 0.0);
-    tentacles[2]->BuildGrasp(targetIndex);
-    glPopMatrix();
-
-    glPopMatrix();
+    placement = transform;
+    placement.translate(cos(90.0 * f) * .05, -.5, sin(90.0 * f) * .05);
+    placement.rotate(90.0, 0.0, 1.0, 0.0);
+    placement.rotate(-90.0, 1.0, 0.0, 0.0);
+    tentacles[0]->BuildGrasp(targetIndex, &placement);
+
+    placement = transform;
+    placement.translate(cos(-30.0 * f) * .05, -.5, sin(-30.0 * f) * .05);
+    placement.rotate(-150.0, 0.0, 1.0, 0.0);
+    placement.rotate(-90.0, 1.0, 0.0, 0.0);
+    tentacles[1]->BuildGrasp(targetIndex, &placement);
+
+    placement = transform;
+    placement.translate(cos(-150.0 * f) * .05, -.5, sin(-150.0 * f) * .05);
+    placement.rotate(-30.0, 0.0, 1.0, 0.0);
+    placement.rotate(-90.0, 1.0, 0.0, 0.0);
+    tentacles[2]->BuildGrasp(targetIndex, &placement);
 }
 
 
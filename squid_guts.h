@@ -16464,13 +16464,10 @@ void squid_guts_SelectMaterial(int i)
     //
     // Define the reflective properties of the 3D Object faces.
     //
-    glEnd();
     GLfloat alpha=squid_guts_materials[i].alpha;
     squid_guts_MyMaterial (GL_AMBIENT, squid_guts_materials[i].ambient,alpha);
     squid_guts_MyMaterial (GL_DIFFUSE, squid_guts_materials[i].diffuse,alpha);
     squid_guts_MyMaterial (GL_SPECULAR, squid_guts_materials[i].specular,alpha);
     squid_guts_MyMaterial (GL_EMISSION, squid_guts_materials[i].emission,alpha);
     glMaterialf (GL_FRONT_AND_BACK,GL_SHININESS,squid_guts_materials[i].phExp);
-    glBegin(GL_TRIANGLES);
-
 };
@@ -7442,13 +7442,10 @@ void squid_outer_SelectMaterial(int i)
     //
     // Define the reflective properties of the 3D Object faces.
     //
-    glEnd();
     GLfloat alpha=squid_outer_materials[i].alpha;
     squid_outer_MyMaterial (GL_AMBIENT, squid_outer_materials[i].ambient,alpha);
     squid_outer_MyMaterial (GL_DIFFUSE, squid_outer_materials[i].diffuse,alpha);
     squid_outer_MyMaterial (GL_SPECULAR, squid_outer_materials[i].specular,alpha);
     squid_outer_MyMaterial (GL_EMISSION, squid_outer_materials[i].emission,alpha);
     glMaterialf (GL_FRONT_AND_BACK,GL_SHININESS,squid_outer_materials[i].phExp);
-    glBegin(GL_TRIANGLES);
-
 };
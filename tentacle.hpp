@@ -12,20 +12,25 @@
 #ifndef __TENTACLE_HPP__
 #define __TENTACLE_HPP__
 
+#ifndef NO_SSE
+#include <xmmintrin.h>
+#endif
 #include "game_object.hpp"
 #include "physics.h"
+#include "mesh.hpp"
+#include "renderState.hpp"
 
-// Tentacle segments. See BuildSegmentTransforms() for hard-coded dependency.
+// Tentacle segments.
 #define NUM_TENTACLE_SEGMENTS 20
 
-// Number of undulation states.
-#define NUM_TENTACLE_UNDULATIONS 10
-
 // Tentacle programmable displays.
 #define NUM_TENTACLE_PROGRAMMABLE_DISPLAYS 10
 
 // Tentacle static displays.
-#define NUM_TENTACLE_STATIC_DISPLAYS (NUM_TENTACLE_UNDULATIONS + NUM_TENTACLE_PROGRAMMABLE_DISPLAYS)
+#define NUM_TENTACLE_STATIC_DISPLAYS NUM_TENTACLE_PROGRAMMABLE_DISPLAYS
+
+// Tentacle mesh levels of detail.
+#define NUM_TENTACLE_DETAILS 3
 
 struct TentacleSegmentTransform
 {
@@ -36,7 +41,7 @@ struct TentacleSegmentTransform
 
 struct TentacleConfiguration
 {
-    GLint display;
+    cMesh *mesh;
     RigidBody segmentBoundingBox[NUM_TENTACLE_SEGMENTS];
 };
 
@@ -52,7 +57,7 @@ class Tentacle : public cGameObject
         Tentacle(class Squid *squid)
         {
             int i,j,n;
-            GLfloat m[16];
+            cTransform identity;
             GLubyte texture[2][2][3];
 
             m_type = TENTACLE;
@@ -71,16 +76,15 @@ class Tentacle : public cGameObject
                 segmentTransform[i].z = 0.0;
                 segmentTransform[i].scale = 1.0;
             }
-            glMatrixMode(GL_MODELVIEW);
-            glPushMatrix();
-            glLoadIdentity();
-            glGetFloatv( GL_MODELVIEW_MATRIX, m );
             for (n = 0; n < NUM_TENTACLE_SEGMENTS; n++)
             {
-                for (i = 0; i < 16; i++) segmentTransformMatrix[n][i] = m[i];
+                identity.get(segmentTransformMatrix[n]);
             }
-            glPopMatrix();
-            dynamicDisplay = -1;
+            dynamicMesh = NULL;
+            undulatingMesh = NULL;
+            undulatingPhase = 0.0;
+            undulationSource = this;
+            detail = 0;
             segmentDynamicTransformValid = false;
 
             // Create default segment bounding boxes.
@@ -94,12 +98,30 @@ class Tentacle : public cGameObject
             {
                 for (i = 0; i < NUM_TENTACLE_STATIC_DISPLAYS; i++)
                 {
-                    staticConfig[i].display = -1;
+                    staticConfig[i].mesh = NULL;
                 }
                 staticInit = true;
 
-                // Create undulation displays.
-                createUndulationDisplays();
+                // Bind model vertices to segments.
+                createSkin();
+
+                // Create model mesh, shared by the configuration meshes.
+                modelMesh = new cMesh();
+                modelMesh->build(tentacle_face_indicies,
+                    sizeof(tentacle_face_indicies)/sizeof(tentacle_face_indicies[0]),
+                    tentacle_vertices, tentacle_normals, tentacle_textures,
+                    tentacle_material_ref, tentacle_SelectMaterial);
+                for (i = 0; i < NUM_TENTACLE_DETAILS - 1; i++)
+                {
+                    modelMesh->addLevel(detailCellSize[i]);
+                }
+
+                // Create undulation wave, bounded by the default boxes.
+                createUndulation();
+                for (i = 0; i < NUM_TENTACLE_SEGMENTS; i++)
+                {
+                    undulationBoundingBox[i] = segmentBoundingBox[i];
+                }
 
                 // Create texture.
                 for (i = 0; i < 2; i++)
@@ -119,6 +141,13 @@ class Tentacle : public cGameObject
             }
         }
 
+        // Destructor.
+        ~Tentacle()
+        {
+            if (dynamicMesh != NULL) delete dynamicMesh;
+            if (undulatingMesh != NULL) delete undulatingMesh;
+        }
+
         // Go: update and draw.
         void Go() { Update(); Draw(); }
 
@@ -129,6 +158,16 @@ class Tentacle : public cGameObject
         void Draw();                              // Dynamic.
         void Draw(int);                           // Static.
 
+        // Draw undulating at a wave phase in degrees.
+        void DrawUndulating(GLfloat phase);
+
+        // Undulate with the mesh of another tentacle of the same squid,
+        // so that the wave is computed once per phase for them all.
+        void ShareUndulation(Tentacle *source) { undulationSource = source; }
+
+        // Level of detail: 0 is the full model.
+        void SetDetail(int d) { detail = d; }
+
         void Kill() { m_isAlive = false; }
 
         // Set kinematic segment transforms.
@@ -147,7 +186,8 @@ class Tentacle : public cGameObject
         void BuildSegmentTransforms(int);
 
         // Build tentacle configuration to grasp target's bounding boxes.
-        void BuildGrasp(int targetIndex);
+        // The placement transform takes tentacle coordinates to world.
+        void BuildGrasp(int targetIndex, cTransform *placement);
 
         // Show bounding boxes.
         void showBoundingBoxes(bool b) { showBounds = b; }
@@ -157,12 +197,29 @@ class Tentacle : public cGameObject
         // My squid.
         class Squid *mySquid;
 
-        // Create undulation displays.
-        void createUndulationDisplays();
+        // Undulation: a sine wave along the tentacle, moving with its phase.
+        // The wave's sine and cosine at each model vertex are kept, so that
+        // the wave at any phase needs no further sines.
+        static GLfloat *undulationSin,*undulationCos;
+        static RigidBody undulationBoundingBox[NUM_TENTACLE_SEGMENTS];
+        static void createUndulation();
+        cMesh *undulatingMesh;
+        GLfloat undulatingPhase;
+        Tentacle *undulationSource;
+        cMesh *undulate(GLfloat phase);
+
+        // Skin: model vertices ordered by segment, with their positions
+        // split by coordinate, so that vertices are transformed four at
+        // a time by the matrix of their segment.
+        static int *skinOrder;                    // model vertex
+        static int skinStart[NUM_TENTACLE_SEGMENTS + 1];
+        static GLfloat *skinX,*skinY,*skinZ;
+        static void createSkin();
+        void skinVertices(GLfloat (*vertices)[3]);
 
         // Segment transforms.
         bool segmentDynamicTransformValid;
-        GLint dynamicDisplay;
+        cMesh *dynamicMesh;
         GLfloat segmentSize;
         struct TentacleSegmentTransform segmentTransform[NUM_TENTACLE_SEGMENTS];
         GLfloat segmentTransformMatrix[NUM_TENTACLE_SEGMENTS][16];
@@ -172,6 +229,10 @@ class Tentacle : public cGameObject
         bool showBounds;
 
         // Prepared tentacle configurations.
+        // All meshes share the model mesh's levels of detail.
+        static cMesh *modelMesh;
+        static const GLfloat detailCellSize[NUM_TENTACLE_DETAILS - 1];
+        int detail;
         static struct TentacleConfiguration staticConfig[NUM_TENTACLE_STATIC_DISPLAYS];
         static bool staticInit;
 
@@ -180,73 +241,139 @@ class Tentacle : public cGameObject
 };
 
 // Prepared tentacle configurations.
+cMesh *Tentacle::modelMesh = NULL;
 struct TentacleConfiguration Tentacle::staticConfig[NUM_TENTACLE_STATIC_DISPLAYS];
 bool Tentacle::staticInit = false;
 
+// Mesh level of detail vertex cluster sizes.
+const GLfloat Tentacle::detailCellSize[NUM_TENTACLE_DETAILS - 1] = { 0.02, 0.05 };
+
 // Texture.
 GLuint Tentacle::textureName;
 
-// Create undulation displays.
-void Tentacle::createUndulationDisplays()
+// Undulation.
+GLfloat *Tentacle::undulationSin = NULL;
+GLfloat *Tentacle::undulationCos = NULL;
+RigidBody Tentacle::undulationBoundingBox[NUM_TENTACLE_SEGMENTS];
+
+// Skin.
+int *Tentacle::skinOrder = NULL;
+int Tentacle::skinStart[NUM_TENTACLE_SEGMENTS + 1];
+GLfloat *Tentacle::skinX = NULL;
+GLfloat *Tentacle::skinY = NULL;
+GLfloat *Tentacle::skinZ = NULL;
+
+// Bind model vertices to segments.
+void Tentacle::createSkin()
 {
-    int i,j,u;
-    GLfloat x,y,z,mz,dz,a,s,amp,freq;
-    GLint lid;
-    int mcount,mindex;
+    int i,k,n;
+    int *segment;
+    GLfloat z,size;
+
+    k = sizeof(tentacle_vertices)/sizeof(tentacle_vertices[0]);
+    size = TentacleDimensions[2].delta / NUM_TENTACLE_SEGMENTS;
+    segment = new int[k];
+    for (i = 0; i < k; i++)
+    {
+        z = tentacle_vertices[i][2];
+        for (n = 0; n < NUM_TENTACLE_SEGMENTS; n++)
+        {
+            if (z >= (TentacleDimensions[2].min + ((GLfloat)n * size)) &&
+                z < (TentacleDimensions[2].min + ((GLfloat)(n + 1) * size))) break;
+        }
+        if (n == NUM_TENTACLE_SEGMENTS) n--;
+        segment[i] = NUM_TENTACLE_SEGMENTS - n - 1;
+    }
 
-    mz = TentacleDimensions[2].min;
-    dz = TentacleDimensions[2].delta;
-    for (u = 0; u < NUM_TENTACLE_UNDULATIONS; u++)
+    // Order vertices by segment.
+    skinOrder = new int[k];
+    skinX = new GLfloat[k];
+    skinY = new GLfloat[k];
+    skinZ = new GLfloat[k];
+    for (n = k = 0; n < NUM_TENTACLE_SEGMENTS; n++)
     {
-        // Create segment bounding boxes.
-        for (i = 0; i < NUM_TENTACLE_SEGMENTS; i++)
+        skinStart[n] = k;
+        for (i = 0; i < (int)(sizeof(tentacle_vertices)/sizeof(tentacle_vertices[0])); i++)
         {
-            staticConfig[u].segmentBoundingBox[i] = segmentBoundingBox[i];
+            if (segment[i] != n) continue;
+            skinOrder[k] = i;
+            skinX[k] = tentacle_vertices[i][0];
+            skinY[k] = tentacle_vertices[i][1];
+            skinZ[k] = tentacle_vertices[i][2];
+            k++;
         }
+    }
+    skinStart[NUM_TENTACLE_SEGMENTS] = k;
+    delete [] segment;
+}
+
 
-        lid=glGenLists(1);
-        mcount=0;
-        mindex=0;
-        glNewList(lid, GL_COMPILE);
+// Transform model vertices by their segment matrices.
+void Tentacle::skinVertices(GLfloat (*vertices)[3])
+{
+    int i,j,n,end;
+    GLfloat *m;
 
-        glBegin (GL_TRIANGLES);
-        for(i=0;i<sizeof(tentacle_face_indicies)/sizeof(tentacle_face_indicies[0]);i++)
+    for (n = 0; n < NUM_TENTACLE_SEGMENTS; n++)
+    {
+        m = segmentTransformMatrix[n];
+        i = skinStart[n];
+        end = skinStart[n + 1];
+        #ifndef NO_SSE
+        __m128 m0 = _mm_set1_ps(m[0]), m1 = _mm_set1_ps(m[1]), m2 = _mm_set1_ps(m[2]);
+        __m128 m4 = _mm_set1_ps(m[4]), m5 = _mm_set1_ps(m[5]), m6 = _mm_set1_ps(m[6]);
+        __m128 m8 = _mm_set1_ps(m[8]), m9 = _mm_set1_ps(m[9]), m10 = _mm_set1_ps(m[10]);
+        __m128 m12 = _mm_set1_ps(m[12]), m13 = _mm_set1_ps(m[13]), m14 = _mm_set1_ps(m[14]);
+        __m128 x,y,z;
+        float wx[4],wy[4],wz[4];
+        for (; i + 4 <= end; i += 4)
         {
-            if(!mcount)
-            {
-                tentacle_SelectMaterial(tentacle_material_ref[mindex][0]);
-                mcount=tentacle_material_ref[mindex][1];
-                mindex++;
-            }
-            mcount--;
-            for(j=0;j<3;j++)
+            x = _mm_loadu_ps(&skinX[i]);
+            y = _mm_loadu_ps(&skinY[i]);
+            z = _mm_loadu_ps(&skinZ[i]);
+            _mm_storeu_ps(wx, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, x), _mm_mul_ps(m4, y)),
+                _mm_add_ps(_mm_mul_ps(m8, z), m12)));
+            _mm_storeu_ps(wy, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m1, x), _mm_mul_ps(m5, y)),
+                _mm_add_ps(_mm_mul_ps(m9, z), m13)));
+            _mm_storeu_ps(wz, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m2, x), _mm_mul_ps(m6, y)),
+                _mm_add_ps(_mm_mul_ps(m10, z), m14)));
+            for (j = 0; j < 4; j++)
             {
-                int vi=tentacle_face_indicies[i][j];
-                                                  //Normal index
-                int ni=tentacle_face_indicies[i][j+3];
-                                                  //Texture index
-                int ti=tentacle_face_indicies[i][j+6];
-                glNormal3f (tentacle_normals[ni][0],tentacle_normals[ni][1],tentacle_normals[ni][2]);
-                glTexCoord2f(tentacle_textures[ti][0],tentacle_textures[ti][1]);
-
-                // Shift x and y according to z using a shifted sine wave.
-                amp = 60.0;                       // amplitude of wave: larger = smaller wave.
-                freq = 360.0;                     // frequency: greater = more "wiggles"
-                x = tentacle_vertices[vi][0];
-                y = tentacle_vertices[vi][1];
-                z = tentacle_vertices[vi][2];
-                a = (z + mz) * (freq / dz);
-                a += (GLfloat)u * (freq / (GLfloat)NUM_TENTACLE_UNDULATIONS);
-                s = (sin(a * (M_PI / 180.0)) + amp) / amp;
-                x += (s - 1.0);
-                y += (s - 1.0);
-                glVertex3f (x, y, z);
+                vertices[skinOrder[i + j]][0] = wx[j];
+                vertices[skinOrder[i + j]][1] = wy[j];
+                vertices[skinOrder[i + j]][2] = wz[j];
             }
         }
-        glEnd ();
+        #endif
+        for (; i < end; i++)
+        {
+            j = skinOrder[i];
+            vertices[j][0] = (m[0] * skinX[i]) + (m[4] * skinY[i]) + (m[8] * skinZ[i]) + m[12];
+            vertices[j][1] = (m[1] * skinX[i]) + (m[5] * skinY[i]) + (m[9] * skinZ[i]) + m[13];
+            vertices[j][2] = (m[2] * skinX[i]) + (m[6] * skinY[i]) + (m[10] * skinZ[i]) + m[14];
+        }
+    }
+}
 
-        glEndList();
-        staticConfig[u].display = lid;
+
+// Create undulation wave.
+void Tentacle::createUndulation()
+{
+    int i,n;
+    GLfloat mz,dz,a,amp,freq;
+
+    amp = 60.0;                                   // amplitude of wave: larger = smaller wave.
+    freq = 360.0;                                 // frequency: greater = more "wiggles"
+    mz = TentacleDimensions[2].min;
+    dz = TentacleDimensions[2].delta;
+    n = sizeof(tentacle_vertices)/sizeof(tentacle_vertices[0]);
+    undulationSin = new GLfloat[n];
+    undulationCos = new GLfloat[n];
+    for (i = 0; i < n; i++)
+    {
+        a = (tentacle_vertices[i][2] + mz) * (freq / dz);
+        undulationSin[i] = sin(a * (M_PI / 180.0)) / amp;
+        undulationCos[i] = cos(a * (M_PI / 180.0)) / amp;
     }
 }
 
@@ -269,19 +396,24 @@ void Tentacle::Draw(int n)
     glScalef(m_spacial->scale, m_spacial->scale, m_spacial->scale);
 
     // Set smooth texture mapping and lighting.
-    glShadeModel(GL_SMOOTH);
-    glDisable(GL_BLEND);
-    glEnable(GL_TEXTURE_2D);
-    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-    glEnable(GL_LIGHTING);
+    cRenderState::shadeModel(GL_SMOOTH);
+    cRenderState::disable(GL_BLEND);
+    cRenderState::enable(GL_TEXTURE_2D);
+    cRenderState::texEnvMode(GL_MODULATE);
+    cRenderState::enable(GL_LIGHTING);
 
     // Draw tentacle.
-    glBindTexture(GL_TEXTURE_2D, textureName);
-    glCallList(staticConfig[n].display);
+    cRenderState::bindTexture(textureName);
+    staticConfig[n].mesh->drawLevel(detail);
 
     // Draw segment bounding boxes?
     if (showBounds)
     {
+        // DrawBody sets this state directly: keep the cache in step.
+        cRenderState::disable(GL_BLEND);
+        cRenderState::disable(GL_TEXTURE_2D);
+        cRenderState::disable(GL_LIGHTING);
+        cRenderState::lineWidth(1.0);
         for (int i = 0; i < NUM_TENTACLE_SEGMENTS; i++)
         {
             DrawBody(&(staticConfig[n].segmentBoundingBox[i]));
@@ -292,6 +424,84 @@ void Tentacle::Draw(int n)
 }
 
 
+// Get the undulating mesh, moving its vertices to the phase.
+cMesh *Tentacle::undulate(GLfloat phase)
+{
+    int i,n;
+    GLfloat c,s,d;
+
+    // Shift x and y according to z.
+    if (undulatingMesh == NULL || phase != undulatingPhase)
+    {
+        c = cos(phase * (M_PI / 180.0));
+        s = sin(phase * (M_PI / 180.0));
+        n = sizeof(tentacle_vertices)/sizeof(tentacle_vertices[0]);
+        for (i = 0; i < n; i++)
+        {
+            d = (undulationSin[i] * c) + (undulationCos[i] * s);
+            xtentacle_vertices[i][0] = tentacle_vertices[i][0] + d;
+            xtentacle_vertices[i][1] = tentacle_vertices[i][1] + d;
+            xtentacle_vertices[i][2] = tentacle_vertices[i][2];
+        }
+        if (undulatingMesh == NULL)
+        {
+            undulatingMesh = new cMesh();
+            undulatingMesh->build(modelMesh, xtentacle_vertices, true);
+        }
+        else
+        {
+            undulatingMesh->setVertices(xtentacle_vertices);
+        }
+        undulatingPhase = phase;
+    }
+    return(undulatingMesh);
+}
+
+
+// Draw undulating tentacle.
+void Tentacle::DrawUndulating(GLfloat phase)
+{
+    int i;
+    cMesh *mesh;
+
+    mesh = undulationSource->undulate(phase);
+
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+
+    glTranslatef(m_spacial->x, m_spacial->y, m_spacial->z);
+    glMultMatrixf(&m_spacial->rotmatrix[0][0]);
+    glScalef(m_spacial->scale, m_spacial->scale, m_spacial->scale);
+
+    // Set smooth texture mapping and lighting.
+    cRenderState::shadeModel(GL_SMOOTH);
+    cRenderState::disable(GL_BLEND);
+    cRenderState::enable(GL_TEXTURE_2D);
+    cRenderState::texEnvMode(GL_MODULATE);
+    cRenderState::enable(GL_LIGHTING);
+
+    // Draw tentacle.
+    cRenderState::bindTexture(textureName);
+    mesh->drawLevel(detail);
+
+    // Draw segment bounding boxes?
+    if (showBounds)
+    {
+        // DrawBody sets this state directly: keep the cache in step.
+        cRenderState::disable(GL_BLEND);
+        cRenderState::disable(GL_TEXTURE_2D);
+        cRenderState::disable(GL_LIGHTING);
+        cRenderState::lineWidth(1.0);
+        for (i = 0; i < NUM_TENTACLE_SEGMENTS; i++)
+        {
+            DrawBody(&(undulationBoundingBox[i]));
+        }
+    }
+
+    glPopMatrix();
+}
+
+
 // Draw dynamically alterable tentacle.
 void Tentacle::Draw()
 {
@@ -309,19 +519,24 @@ void Tentacle::Draw()
     }
 
     // Set smooth texture mapping and lighting.
-    glShadeModel(GL_SMOOTH);
-    glDisable(GL_BLEND);
-    glEnable(GL_TEXTURE_2D);
-    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-    glEnable(GL_LIGHTING);
+    cRenderState::shadeModel(GL_SMOOTH);
+    cRenderState::disable(GL_BLEND);
+    cRenderState::enable(GL_TEXTURE_2D);
+    cRenderState::texEnvMode(GL_MODULATE);
+    cRenderState::enable(GL_LIGHTING);
 
     // Draw tentacle.
-    glBindTexture(GL_TEXTURE_2D, textureName);
-    glCallList(dynamicDisplay);
+    cRenderState::bindTexture(textureName);
+    dynamicMesh->drawLevel(detail);
 
     // Draw segment bounding boxes?
     if (showBounds)
     {
+        // DrawBody sets this state directly: keep the cache in step.
+        cRenderState::disable(GL_BLEND);
+        cRenderState::disable(GL_TEXTURE_2D);
+        cRenderState::disable(GL_LIGHTING);
+        cRenderState::lineWidth(1.0);
         for (int i = 0; i < NUM_TENTACLE_SEGMENTS; i++)
         {
             DrawBody(&(segmentBoundingBox[i]));
@@ -335,16 +550,6 @@ void Tentacle::Draw()
 // Build segment transforms.
 void Tentacle::BuildSegmentTransforms(int index)
 {
-    int i,j,k,n,mcount,mindex,vi,ni,ti;
-    GLfloat z;
-    Matrix p(4,1),t(4,1);
-
-    // Yuck: trouble constructing Matrix in an array.
-    Matrix x0(4,4),x1(4,4),x2(4,4),x3(4,4),x4(4,4);
-    Matrix x5(4,4),x6(4,4),x7(4,4),x8(4,4),x9(4,4);
-    Matrix x10(4,4),x11(4,4),x12(4,4),x13(4,4),x14(4,4);
-    Matrix x15(4,4),x16(4,4),x17(4,4),x18(4,4),x19(4,4);
-
     if (index < -1 || index >= NUM_TENTACLE_STATIC_DISPLAYS) return;
 
     // Build transform matrices.
@@ -360,120 +565,34 @@ void Tentacle::BuildSegmentTransforms(int index)
         createSegmentBounds(staticConfig[index].segmentBoundingBox);
     }
 
-    // Build matrices.
-    for (i=0; i < 4; i++) for (j=0; j < 4; j++) x0(i,j) = segmentTransformMatrix[0][(j*4)+i];
-    for (i=0; i < 4; i++) for (j=0; j < 4; j++) x1(i,j) = segmentTransformMatrix[1][(j*4)+i];
-    for (i=0; i < 4; i++) for (j=0; j < 4; j++) x2(i,j) = segmentTransformMatrix[2][(j*4)+i];
-    for (i=0; i < 4; i++) for (j=0; j < 4; j++) x3(i,j) = segmentTransformMatrix[3][(j*4)+i];
-    for (i=0; i < 4; i++) for (j=0; j < 4; j++) x4(i,j) = segmentTransformMatrix[4][(j*4)+i];
-    for (i=0; i < 4; i++) for (j=0; j < 4; j++) x5(i,j) = segmentTransformMatrix[5][(j*4)+i];
-    for (i=0; i < 4; i++) for (j=0; j < 4; j++) x6(i,j) = segmentTransformMatrix[6][(j*4)+i];
-    for (i=0; i < 4; i++) for (j=0; j < 4; j++) x7(i,j) = segmentTransformMatrix[7][(j*4)+i];
-    for (i=0; i < 4; i++) for (j=0; j < 4; j++) x8(i,j) = segmentTransformMatrix[8][(j*4)+i];
-    for (i=0; i < 4; i++) for (j=0; j < 4; j++) x9(i,j) = segmentTransformMatrix[9][(j*4)+i];
-    for (i=0; i < 4; i++) for (j=0; j < 4; j++) x10(i,j) = segmentTransformMatrix[10][(j*4)+i];
-    for (i=0; i < 4; i++) for (j=0; j < 4; j++) x11(i,j) = segmentTransformMatrix[11][(j*4)+i];
-    for (i=0; i < 4; i++) for (j=0; j < 4; j++) x12(i,j) = segmentTransformMatrix[12][(j*4)+i];
-    for (i=0; i < 4; i++) for (j=0; j < 4; j++) x13(i,j) = segmentTransformMatrix[13][(j*4)+i];
-    for (i=0; i < 4; i++) for (j=0; j < 4; j++) x14(i,j) = segmentTransformMatrix[14][(j*4)+i];
-    for (i=0; i < 4; i++) for (j=0; j < 4; j++) x15(i,j) = segmentTransformMatrix[15][(j*4)+i];
-    for (i=0; i < 4; i++) for (j=0; j < 4; j++) x16(i,j) = segmentTransformMatrix[16][(j*4)+i];
-    for (i=0; i < 4; i++) for (j=0; j < 4; j++) x17(i,j) = segmentTransformMatrix[17][(j*4)+i];
-    for (i=0; i < 4; i++) for (j=0; j < 4; j++) x18(i,j) = segmentTransformMatrix[18][(j*4)+i];
-    for (i=0; i < 4; i++) for (j=0; j < 4; j++) x19(i,j) = segmentTransformMatrix[19][(j*4)+i];
-
     // Transform segment vertices.
-    for(i=0,k=sizeof(tentacle_face_indicies)/sizeof(tentacle_face_indicies[0]);i<k;i++)
-    {
-        for(j=0;j<3;j++)
-        {
-            vi=tentacle_face_indicies[i][j];
-            z = tentacle_vertices[vi][2];
-            for (n = 0; n < NUM_TENTACLE_SEGMENTS; n++)
-            {
-                if (z >= (TentacleDimensions[2].min + ((GLfloat)n * segmentSize)) &&
-                    z < (TentacleDimensions[2].min + ((GLfloat)(n + 1) * segmentSize))) break;
-            }
-            if (n == NUM_TENTACLE_SEGMENTS) n--;
-            n = NUM_TENTACLE_SEGMENTS - n - 1;
-            p(0,0) = tentacle_vertices[vi][0];
-            p(1,0) = tentacle_vertices[vi][1];
-            p(2,0) = tentacle_vertices[vi][2];
-            p(3,0) = 1.0;
-            switch(n)
-            {
-                case 0: t = x0 * p; break;
-                case 1: t = x1 * p; break;
-                case 2: t = x2 * p; break;
-                case 3: t = x3 * p; break;
-                case 4: t = x4 * p; break;
-                case 5: t = x5 * p; break;
-                case 6: t = x6 * p; break;
-                case 7: t = x7 * p; break;
-                case 8: t = x8 * p; break;
-                case 9: t = x9 * p; break;
-                case 10: t = x10 * p; break;
-                case 11: t = x11 * p; break;
-                case 12: t = x12 * p; break;
-                case 13: t = x13 * p; break;
-                case 14: t = x14 * p; break;
-                case 15: t = x15 * p; break;
-                case 16: t = x16 * p; break;
-                case 17: t = x17 * p; break;
-                case 18: t = x18 * p; break;
-                case 19: t = x19 * p; break;
-            }
-            xtentacle_vertices[vi][0] = t(0,0);
-            xtentacle_vertices[vi][1] = t(1,0);
-            xtentacle_vertices[vi][2] = t(2,0);
-        }
-    }
-
-    // Remove old display list.
-    if (index == -1)
-    {
-        if (dynamicDisplay != -1) glDeleteLists(dynamicDisplay, 1);
-    }
-    else
-    {
-        if (staticConfig[index].display != -1) glDeleteLists(staticConfig[index].display, 1);
-    }
+    skinVertices(xtentacle_vertices);
 
-    // Build display list.
+    // Load mesh positions.
     if (index == -1)
     {
-        dynamicDisplay=glGenLists(1);
-        glNewList(dynamicDisplay, GL_COMPILE);
+        if (dynamicMesh == NULL)
+        {
+            dynamicMesh = new cMesh();
+            dynamicMesh->build(modelMesh, xtentacle_vertices, true);
+        }
+        else
+        {
+            dynamicMesh->setVertices(xtentacle_vertices);
+        }
     }
     else
     {
-        staticConfig[index].display=glGenLists(1);
-        glNewList(staticConfig[index].display, GL_COMPILE);
-    }
-    mcount=0;
-    mindex=0;
-    glBegin (GL_TRIANGLES);
-    for(i=0,k=sizeof(tentacle_face_indicies)/sizeof(tentacle_face_indicies[0]);i<k;i++)
-    {
-        if(!mcount)
+        if (staticConfig[index].mesh == NULL)
         {
-            tentacle_SelectMaterial(tentacle_material_ref[mindex][0]);
-            mcount=tentacle_material_ref[mindex][1];
-            mindex++;
+            staticConfig[index].mesh = new cMesh();
+            staticConfig[index].mesh->build(modelMesh, xtentacle_vertices);
         }
-        mcount--;
-        for(j=0;j<3;j++)
+        else
         {
-            vi=tentacle_face_indicies[i][j];
-            ni=tentacle_face_indicies[i][j+3];    //Normal index
-            ti=tentacle_face_indicies[i][j+6];    //Texture index
-            glNormal3f (tentacle_normals[ni][0],tentacle_normals[ni][1],tentacle_normals[ni][2]);
-            glTexCoord2f(tentacle_textures[ti][0],tentacle_textures[ti][1]);
-            glVertex3f(xtentacle_vertices[vi][0],xtentacle_vertices[vi][1],xtentacle_vertices[vi][2]);
+            staticConfig[index].mesh->setVertices(xtentacle_vertices);
         }
     }
-    glEnd ();
-    glEndList();
 
     // Dynamic transform now valid.
     if (index == -1) segmentDynamicTransformValid = true;
@@ -484,64 +603,74 @@ void Tentacle::BuildSegmentTransforms(int index)
 void Tentacle::buildSegmentTransformMatrices()
 {
     int n;
+    cTransform t;
 
-    glMatrixMode(GL_MODELVIEW);
+    // Each segment is transformed relative to the one before it.
     for (n = 0; n < NUM_TENTACLE_SEGMENTS; n++)
     {
-        glPushMatrix();
-        if (n == 0) glLoadIdentity();
-        glTranslatef(segmentTransform[n].x, segmentTransform[n].y, segmentTransform[n].z);
-        glTranslatef(0.0, 0.0, (segmentSize * (GLfloat)(NUM_TENTACLE_SEGMENTS - (2 * n)))/2.0);
-        glRotatef(segmentTransform[n].pitch, 1.0, 0.0, 0.0);
-        glRotatef(segmentTransform[n].yaw, 0.0, 1.0, 0.0);
-        glRotatef(segmentTransform[n].roll, 0.0, 0.0, 1.0);
-        glTranslatef(0.0, 0.0, -(segmentSize * (GLfloat)(NUM_TENTACLE_SEGMENTS - (2 * n)))/2.0);
-        glScalef(segmentTransform[n].scale, segmentTransform[n].scale, segmentTransform[n].scale);
-        glGetFloatv( GL_MODELVIEW_MATRIX, segmentTransformMatrix[n] );
+        t.translate(segmentTransform[n].x, segmentTransform[n].y, segmentTransform[n].z);
+        t.translate(0.0, 0.0, (segmentSize * (GLfloat)(NUM_TENTACLE_SEGMENTS - (2 * n)))/2.0);
+        t.rotate(segmentTransform[n].pitch, 1.0, 0.0, 0.0);
+        t.rotate(segmentTransform[n].yaw, 0.0, 1.0, 0.0);
+        t.rotate(segmentTransform[n].roll, 0.0, 0.0, 1.0);
+        t.translate(0.0, 0.0, -(segmentSize * (GLfloat)(NUM_TENTACLE_SEGMENTS - (2 * n)))/2.0);
+        t.scale(segmentTransform[n].scale, segmentTransform[n].scale, segmentTransform[n].scale);
+        t.get(segmentTransformMatrix[n]);
     }
-    for (n = 0; n < NUM_TENTACLE_SEGMENTS; n++) glPopMatrix();
 }
 
 
 // Create tentacle segments as a string of bounding boxes.
 void Tentacle::createSegmentBounds(RigidBody *boxes)
 {
-    int i,j,k;
-    Matrix x(4,4),p(4,1),t(4,1),v(4,1);
+    int i,j;
+    cTransform x;
+    GLfloat z,v[3];
 
     // Radius of each box is half segment size.
-    p(0,0) = 0.0;
-    p(1,0) = 0.0;
-    p(2,0) = TentacleDimensions[2].max - (segmentSize * 0.5);
-    p(3,0) = 1.0;
+    z = TentacleDimensions[2].max - (segmentSize * 0.5);
 
     // Create transformed boxes.
-    for (i = 0; i < NUM_TENTACLE_SEGMENTS; i++, p(2,0) -= segmentSize)
+    for (i = 0; i < NUM_TENTACLE_SEGMENTS; i++, z -= segmentSize)
     {
-        for (k=0; k < 4; k++)
-            for (j=0; j < 4; j++)
-                x(k,j) = segmentTransformMatrix[i][(j*4)+k];
+        x.load(segmentTransformMatrix[i]);
         InitializeObject(&boxes[i], segmentSize, BLOCK_TYPE, -1);
         for(j=0; j<8; j++)
         {
-            v(0,0) = boxes[i].vVertexList[j].x;
-            v(1,0) = boxes[i].vVertexList[j].y;
-            v(2,0) = boxes[i].vVertexList[j].z + p(2,0);
-            v(3,0) = 1.0;
-            t = x * v;
-            boxes[i].vVertexList[j].x = t(0,0);
-            boxes[i].vVertexList[j].y = t(1,0);
-            boxes[i].vVertexList[j].z = t(2,0);
+            v[0] = boxes[i].vVertexList[j].x;
+            v[1] = boxes[i].vVertexList[j].y;
+            v[2] = boxes[i].vVertexList[j].z + z;
+            x.transformPoint(v, v);
+            boxes[i].vVertexList[j].x = v[0];
+            boxes[i].vVertexList[j].y = v[1];
+            boxes[i].vVertexList[j].z = v[2];
         }
     }
 }
 
 
 // Build tentacle configuration to grasp target's bounding boxes.
-void Tentacle::BuildGrasp(int targetIndex)
+// The tentacle is laid along a path that runs straight from its root to
+// a sphere bounding the boxes, then coils around the sphere in the plane
+// of the root, the sphere center and the tentacle's rest direction,
+// rising a segment width each turn. Proceeding from the root, each
+// segment is turned to point at the path point a segment length beyond
+// its start, so the configuration is found in one pass over the segments.
+void Tentacle::BuildGrasp(int targetIndex, cTransform *placement)
 {
-    int i,n,segment;
-    GLfloat angle,range,tolerance,v[3];
+    int i,n,count;
+    GLfloat m[16],c[3],p[3],q[3],u[3],v[3],w[3],d[3],l[3];
+    GLfloat k,dist,radius,line,alpha,theta,pitch,yaw;
+    cTransform transform,inverse,rotation;
+
+    // Tentacle to world transform, and back.
+    transform = *placement;
+    GetModelTransform(m);
+    transform.multiply(m);
+    transform.rigidInverse(&inverse);
+    k = sqrt((transform.m[0] * transform.m[0]) + (transform.m[1] * transform.m[1]) +
+        (transform.m[2] * transform.m[2]));
+    if (k > 0.0) k = 1.0 / k;
 
     // Clear segment transforms.
     for (i = 0; i < NUM_TENTACLE_SEGMENTS; i++)
@@ -554,59 +683,129 @@ void Tentacle::BuildGrasp(int targetIndex)
         segmentTransform[i].z = 0.0;
         segmentTransform[i].scale = 1.0;
     }
-    segmentTransform[7].yaw = 20;
-    segmentTransform[10].yaw = -20;
-    segmentTransform[15].yaw = -20;
-
-    /*
-     * For each segment, bend tentacle down, proceeding from
-     * +range to -range degrees until one of the segments collides
-     * with a bounding box. This sets the grasping angle of the
-     * current segment up to the colliding segment. Continue the
-     * process with the next segment to effect a wrap-around
-     * configuration.
-     */
-    range = 45.0;
-    tolerance = 0.2;
-    for (segment = 0; segment < NUM_TENTACLE_SEGMENTS;)
+    segmentDynamicTransformValid = false;
+
+    // Bound the target's boxes with a sphere in tentacle coordinates,
+    // kept half a segment clear of the segments' centers.
+    c[0] = c[1] = c[2] = 0.0;
+    for (i = targetIndex, count = 0;
+        i < NumBodies && Bodies[i].group == Bodies[targetIndex].group; i++, count++)
     {
-        if (segment > 0) return;                  // For efficiency.
-        for (angle = range; angle >= -range; angle -= 5)
+        p[0] = Bodies[i].vPosition.x;
+        p[1] = Bodies[i].vPosition.y;
+        p[2] = Bodies[i].vPosition.z;
+        inverse.transformPoint(p, p);
+        c[0] += p[0];
+        c[1] += p[1];
+        c[2] += p[2];
+    }
+    if (count == 0) return;
+    c[0] /= (GLfloat)count;
+    c[1] /= (GLfloat)count;
+    c[2] /= (GLfloat)count;
+    radius = 0.0;
+    for (i = targetIndex; i < targetIndex + count; i++)
+    {
+        p[0] = Bodies[i].vPosition.x;
+        p[1] = Bodies[i].vPosition.y;
+        p[2] = Bodies[i].vPosition.z;
+        inverse.transformPoint(p, p);
+        d[0] = p[0] - c[0];
+        d[1] = p[1] - c[1];
+        d[2] = p[2] - c[2];
+        dist = sqrt((d[0] * d[0]) + (d[1] * d[1]) + (d[2] * d[2])) + (Bodies[i].fRadius * k);
+        if (dist > radius) radius = dist;
+    }
+    radius += segmentSize * 0.5;
+
+    // Path plane: u from the center to the root, v toward the rest
+    // direction (down the tentacle), w across.
+    p[0] = p[1] = 0.0;
+    p[2] = TentacleDimensions[2].max;
+    u[0] = p[0] - c[0];
+    u[1] = p[1] - c[1];
+    u[2] = p[2] - c[2];
+    dist = sqrt((u[0] * u[0]) + (u[1] * u[1]) + (u[2] * u[2]));
+    if (dist == 0.0) return;
+    u[0] /= dist;
+    u[1] /= dist;
+    u[2] /= dist;
+    v[0] = u[2] * u[0];
+    v[1] = u[2] * u[1];
+    v[2] = (u[2] * u[2]) - 1.0;
+    if (((v[0] * v[0]) + (v[1] * v[1]) + (v[2] * v[2])) < 0.0001)
+    {
+        v[0] = 1.0 - (u[0] * u[0]);
+        v[1] = -u[0] * u[1];
+        v[2] = -u[0] * u[2];
+    }
+    cSpacial::normalize(v);
+    w[0] = (u[1] * v[2]) - (u[2] * v[1]);
+    w[1] = (u[2] * v[0]) - (u[0] * v[2]);
+    w[2] = (u[0] * v[1]) - (u[1] * v[0]);
+
+    // The line from the root touches the sphere at angle alpha from u.
+    if (radius > dist) radius = dist;
+    line = sqrt((dist * dist) - (radius * radius));
+    alpha = acos(radius / dist);
+
+    // Point each segment along the path.
+    d[0] = d[1] = 0.0;
+    d[2] = -1.0;
+    for (n = 0; n < NUM_TENTACLE_SEGMENTS; n++)
+    {
+        // Path point a segment length beyond the segment's arc length.
+        dist = segmentSize * (GLfloat)(n + 1);
+        if (dist <= line)
         {
-            // Create the bounding boxes for the segments.
-            segmentTransform[segment].yaw = angle;
-            buildSegmentTransformMatrices();
-            createSegmentBounds(segmentBoundingBox);
-
-            // Check for collisions with the target's bounding boxes.
-            for (n = segment; n < NUM_TENTACLE_SEGMENTS; n++)
+            // Back from the touching point toward the root.
+            dist = line - dist;
+            for (i = 0; i < 3; i++)
             {
-                InitializeObject(&Bodies[MAX_BODIES], segmentSize, BLOCK_TYPE, -1);
-                for (i = 0; i < 8; i++)
-                {
-                    // Set box vertices to segment world coordinates.
-                    v[0] = segmentBoundingBox[n].vVertexList[i].x;
-                    v[1] = segmentBoundingBox[n].vVertexList[i].y;
-                    v[2] = segmentBoundingBox[n].vVertexList[i].z;
-                    LocalToWorld(v, v);
-                    Bodies[MAX_BODIES].vVertexList[i].x = v[0];
-                    Bodies[MAX_BODIES].vVertexList[i].y = v[1];
-                    Bodies[MAX_BODIES].vVertexList[i].z = v[2];
-                }
-
-                // Segment collides with target?
-                for (i = targetIndex; Bodies[i].group == Bodies[targetIndex].group && i < NumBodies; i++)
-                {
-                    if (CheckForSpecificCollision(MAX_BODIES, i, tolerance) == COLLISION)
-                    {
-                        segment = n + 1;
-                        n = NUM_TENTACLE_SEGMENTS;
-                        break;
-                    }
-                }
+                q[i] = c[i] + (radius * ((cos(alpha) * u[i]) + (sin(alpha) * v[i]))) +
+                    (dist * ((sin(alpha) * u[i]) - (cos(alpha) * v[i])));
+            }
+        }
+        else
+        {
+            theta = (dist - line) / radius;
+            for (i = 0; i < 3; i++)
+            {
+                q[i] = c[i] + (radius * ((cos(alpha + theta) * u[i]) + (sin(alpha + theta) * v[i]))) +
+                    (w[i] * segmentSize * theta / (GLfloat)(2.0 * M_PI));
             }
         }
-        if (angle < -range) break;
+        q[0] -= p[0];
+        q[1] -= p[1];
+        q[2] -= p[2];
+        if (((q[0] * q[0]) + (q[1] * q[1]) + (q[2] * q[2])) > 0.0)
+        {
+            d[0] = q[0];
+            d[1] = q[1];
+            d[2] = q[2];
+            cSpacial::normalize(d);
+        }
+
+        // Turn the segment's rest direction, -z after the segments
+        // before it, to the path direction.
+        for (i = 0; i < 3; i++)
+        {
+            l[i] = (rotation.m[i * 4] * d[0]) + (rotation.m[(i * 4) + 1] * d[1]) +
+                (rotation.m[(i * 4) + 2] * d[2]);
+        }
+        if (l[0] > 1.0) l[0] = 1.0;
+        if (l[0] < -1.0) l[0] = -1.0;
+        yaw = asin(-l[0]) * (180.0 / M_PI);
+        pitch = atan2(l[1], -l[2]) * (180.0 / M_PI);
+        segmentTransform[n].pitch = pitch;
+        segmentTransform[n].yaw = yaw;
+        rotation.rotate(pitch, 1.0, 0.0, 0.0);
+        rotation.rotate(yaw, 0.0, 1.0, 0.0);
+
+        // Next segment starts at the end of this one.
+        p[0] += d[0] * segmentSize;
+        p[1] += d[1] * segmentSize;
+        p[2] += d[2] * segmentSize;
     }
 }
 #endif
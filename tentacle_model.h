@@ -15449,13 +15449,10 @@ void tentacle_SelectMaterial(int i)
     //
     // Define the reflective properties of the 3D Object faces.
     //
-    glEnd();
     GLfloat alpha=tentacle_materials[i].alpha;
     tentacle_MyMaterial (GL_AMBIENT, tentacle_materials[i].ambient,alpha);
     tentacle_MyMaterial (GL_DIFFUSE, tentacle_materials[i].diffuse,alpha);
     tentacle_MyMaterial (GL_SPECULAR, tentacle_materials[i].specular,alpha);
     tentacle_MyMaterial (GL_EMISSION, tentacle_materials[i].emission,alpha);
     glMaterialf (GL_FRONT_AND_BACK,GL_SHININESS,tentacle_materials[i].phExp);
-    glBegin(GL_TRIANGLES);
-
 };
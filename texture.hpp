@@ -27,7 +27,7 @@ typedef struct
     GLuint   texID;
 } TextureImage;
 
-bool LoadTGA(TextureImage *texture, char* filename)
+bool LoadTGA(TextureImage *texture, const char* filename)
 {
     GLubyte TGAheader[12] = {0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0};
     GLubyte TGAcompare[12];
@@ -145,5 +145,78 @@ bool CreateBmpTexture(char *filename, GLuint *textureName)
 
     return true;
 }
+
+
+// Load equally sized bitmaps into the tiles of one texture, filling
+// rows of columns tiles from the bottom left.
+bool CreateBmpAtlasTexture(char **filenames, int count, int columns, int rows, GLuint *textureName)
+{
+    AUX_RGBImageRec *pBitmap = NULL;
+    GLubyte *atlas = NULL;
+    int i,j,width,height,x,y;
+
+    if(!filenames || count > columns * rows)
+    {
+        return false;
+    }
+
+    width = height = 0;
+    for(i = 0; i < count; i++)
+    {
+        pBitmap = auxDIBImageLoad(filenames[i]);
+
+        if(!pBitmap || (atlas && (pBitmap->sizeX != width || pBitmap->sizeY != height)))
+        {
+            if(pBitmap)
+            {
+                if(pBitmap->data)
+                {
+                    free(pBitmap->data);
+                }
+
+                free(pBitmap);
+            }
+            if(atlas)
+            {
+                free(atlas);
+            }
+            return false;
+        }
+
+        if(!atlas)
+        {
+            width = pBitmap->sizeX;
+            height = pBitmap->sizeY;
+            atlas = (GLubyte *)calloc(width * columns * height * rows * 3, 1);
+        }
+
+        x = (i % columns) * width;
+        y = (i / columns) * height;
+        for(j = 0; j < height; j++)
+        {
+            memcpy(&atlas[(((y + j) * width * columns) + x) * 3], &pBitmap->data[j * width * 3], width * 3);
+        }
+
+        if(pBitmap->data)
+        {
+            free(pBitmap->data);
+        }
+
+        free(pBitmap);
+    }
+
+    glGenTextures(1, textureName);
+
+    glBindTexture(GL_TEXTURE_2D, *textureName);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, 3, width * columns, height * rows, 0, GL_RGB, GL_UNSIGNED_BYTE, atlas);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    free(atlas);
+
+    return true;
+}
 #endif
 #endif                                            // #ifndef __TEXTURE_HPP__
@@ -0,0 +1,228 @@
+//***************************************************************************//
+//* File Name: transform.hpp                                                *//
+//* Author:    Tom Portegys, portegys@ilstu.edu                             *//
+//* Date Made: 10/17/26                                                     *//
+//* File Desc: Class declaration and implementation details                 *//
+//*            representing a 4x4 transform built on the CPU the way the    *//
+//*            OpenGL matrix calls would build it.                          *//
+//* Rev. Date:                                                              *//
+//* Rev. Desc:                                                              *//
+//*                                                                         *//
+//***************************************************************************//
+
+#ifndef __TRANSFORM_HPP__
+#define __TRANSFORM_HPP__
+
+#include <math.h>
+#include <GL/gl.h>
+
+// The matrix is column-major, as OpenGL stores it, so it can be
+// handed to glLoadMatrixf and glMultMatrixf as is. Each operation
+// post-multiplies like its OpenGL counterpart, so a sequence of calls
+// produces the same matrix as the same sequence on the matrix stack.
+// Copy a transform to save and restore it as glPushMatrix/glPopMatrix.
+class cTransform
+{
+    public:
+
+        GLfloat m[16];
+
+        // Constructor: identity.
+        cTransform() { identity(); }
+
+        // Load identity (glLoadIdentity).
+        void identity()
+        {
+            for (int i = 0; i < 16; i++) m[i] = 0.0;
+            m[0] = m[5] = m[10] = m[15] = 1.0;
+        }
+
+        // Load matrix (glLoadMatrixf).
+        void load(const GLfloat *matrix)
+        {
+            for (int i = 0; i < 16; i++) m[i] = matrix[i];
+        }
+
+        // Get matrix (glGetFloatv).
+        void get(GLfloat *matrix)
+        {
+            for (int i = 0; i < 16; i++) matrix[i] = m[i];
+        }
+
+        // Multiply by matrix (glMultMatrixf).
+        void multiply(const GLfloat *matrix);
+
+        // Translate (glTranslatef).
+        void translate(GLfloat x, GLfloat y, GLfloat z)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                m[12 + i] += (m[i] * x) + (m[4 + i] * y) + (m[8 + i] * z);
+            }
+        }
+
+        // Rotate by angle in degrees about axis (glRotatef).
+        void rotate(GLfloat angle, GLfloat x, GLfloat y, GLfloat z);
+
+        // Scale (glScalef).
+        void scale(GLfloat x, GLfloat y, GLfloat z)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                m[i] *= x;
+                m[4 + i] *= y;
+                m[8 + i] *= z;
+            }
+        }
+
+        // Perspective projection (gluPerspective).
+        void perspective(GLfloat fovy, GLfloat aspect, GLfloat zNear, GLfloat zFar);
+
+        // Viewing transform (gluLookAt).
+        void lookAt(GLfloat *eye, GLfloat *center, GLfloat *up);
+
+        // Inverse of a rotation, uniform scale and translation.
+        void rigidInverse(cTransform *inverse);
+
+        // Transform point.
+        void transformPoint(GLfloat *local, GLfloat *world)
+        {
+            GLfloat x = local[0];
+            GLfloat y = local[1];
+            GLfloat z = local[2];
+
+            world[0] = (m[0] * x) + (m[4] * y) + (m[8] * z) + m[12];
+            world[1] = (m[1] * x) + (m[5] * y) + (m[9] * z) + m[13];
+            world[2] = (m[2] * x) + (m[6] * y) + (m[10] * z) + m[14];
+        }
+};
+
+// Multiply by matrix.
+void cTransform::multiply(const GLfloat *matrix)
+{
+    int i,j;
+    GLfloat r[16];
+
+    for (i = 0; i < 4; i++)
+    {
+        for (j = 0; j < 4; j++)
+        {
+            r[(j * 4) + i] = (m[i] * matrix[j * 4]) + (m[4 + i] * matrix[(j * 4) + 1]) +
+                (m[8 + i] * matrix[(j * 4) + 2]) + (m[12 + i] * matrix[(j * 4) + 3]);
+        }
+    }
+    load(r);
+}
+
+
+// Rotate by angle in degrees about axis.
+void cTransform::rotate(GLfloat angle, GLfloat x, GLfloat y, GLfloat z)
+{
+    GLfloat r[16],c,s,t,d;
+
+    d = sqrt((x * x) + (y * y) + (z * z));
+    if (d == 0.0) return;
+    x /= d; y /= d; z /= d;
+    angle *= (GLfloat)(3.14159265358979323846 / 180.0);
+    c = cos(angle);
+    s = sin(angle);
+    t = 1.0 - c;
+    r[0] = (x * x * t) + c;
+    r[1] = (y * x * t) + (z * s);
+    r[2] = (x * z * t) - (y * s);
+    r[3] = 0.0;
+    r[4] = (x * y * t) - (z * s);
+    r[5] = (y * y * t) + c;
+    r[6] = (y * z * t) + (x * s);
+    r[7] = 0.0;
+    r[8] = (x * z * t) + (y * s);
+    r[9] = (y * z * t) - (x * s);
+    r[10] = (z * z * t) + c;
+    r[11] = 0.0;
+    r[12] = r[13] = r[14] = 0.0;
+    r[15] = 1.0;
+    multiply(r);
+}
+
+
+// Inverse of a rotation, uniform scale and translation.
+// The upper 3x3 is a scaled rotation, so its inverse is its transpose
+// divided by the squared scale; no general inversion is needed.
+void cTransform::rigidInverse(cTransform *inverse)
+{
+    int i,j;
+    GLfloat s;
+
+    s = (m[0] * m[0]) + (m[1] * m[1]) + (m[2] * m[2]);
+    if (s == 0.0)
+    {
+        inverse->identity();
+        return;
+    }
+    for (i = 0; i < 3; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            inverse->m[(j * 4) + i] = m[(i * 4) + j] / s;
+        }
+        inverse->m[(i * 4) + 3] = 0.0;
+    }
+    for (i = 0; i < 3; i++)
+    {
+        inverse->m[12 + i] = -((inverse->m[i] * m[12]) + (inverse->m[4 + i] * m[13]) +
+            (inverse->m[8 + i] * m[14]));
+    }
+    inverse->m[15] = 1.0;
+}
+
+
+// Perspective projection.
+void cTransform::perspective(GLfloat fovy, GLfloat aspect, GLfloat zNear, GLfloat zFar)
+{
+    GLfloat r[16],f;
+    int i;
+
+    f = 1.0 / tan(fovy * (GLfloat)(3.14159265358979323846 / 360.0));
+    for (i = 0; i < 16; i++) r[i] = 0.0;
+    r[0] = f / aspect;
+    r[5] = f;
+    r[10] = (zFar + zNear) / (zNear - zFar);
+    r[11] = -1.0;
+    r[14] = (2.0 * zFar * zNear) / (zNear - zFar);
+    multiply(r);
+}
+
+
+// Viewing transform.
+void cTransform::lookAt(GLfloat *eye, GLfloat *center, GLfloat *up)
+{
+    GLfloat r[16],f[3],s[3],u[3],d;
+    int i;
+
+    f[0] = center[0] - eye[0];
+    f[1] = center[1] - eye[1];
+    f[2] = center[2] - eye[2];
+    d = sqrt((f[0] * f[0]) + (f[1] * f[1]) + (f[2] * f[2]));
+    if (d == 0.0) return;
+    f[0] /= d; f[1] /= d; f[2] /= d;
+
+    // Side = forward x up, then recompute up = side x forward.
+    s[0] = (f[1] * up[2]) - (f[2] * up[1]);
+    s[1] = (f[2] * up[0]) - (f[0] * up[2]);
+    s[2] = (f[0] * up[1]) - (f[1] * up[0]);
+    d = sqrt((s[0] * s[0]) + (s[1] * s[1]) + (s[2] * s[2]));
+    if (d == 0.0) return;
+    s[0] /= d; s[1] /= d; s[2] /= d;
+    u[0] = (s[1] * f[2]) - (s[2] * f[1]);
+    u[1] = (s[2] * f[0]) - (s[0] * f[2]);
+    u[2] = (s[0] * f[1]) - (s[1] * f[0]);
+
+    for (i = 0; i < 16; i++) r[i] = 0.0;
+    r[0] = s[0]; r[4] = s[1]; r[8] = s[2];
+    r[1] = u[0]; r[5] = u[1]; r[9] = u[2];
+    r[2] = -f[0]; r[6] = -f[1]; r[10] = -f[2];
+    r[15] = 1.0;
+    multiply(r);
+    translate(-eye[0], -eye[1], -eye[2]);
+}
+#endif                                            // #ifndef __TRANSFORM_HPP__
@@ -13,7 +13,10 @@
 #define __XWING_HPP__
 
 #include "game_object.hpp"
-#include "plasmaBolt.hpp"
+#include "plasmaBoltSet.hpp"
+#include "mesh.hpp"
+#include "particleSystem.hpp"
+#include "renderState.hpp"
 
 // Random number > -1.0 && < 1.0
 #define RAND_UNIT ((GLfloat)(rand() - rand()) / RAND_MAX)
@@ -25,6 +28,7 @@
 #define NUM_EXPLODING_DRAWABLES 9                 // Number of exploding drawable components.
 #define NUM_EXHAUSTS 100                          // Number of thruster exhaust streams.
 #define ID_LENGTH 12                              // ID length.
+#define NUM_XWING_DETAILS 3                       // Mesh levels of detail.
 
 // Exploding part.
 struct XWING_EXPLODING_PART
@@ -56,6 +60,7 @@ class Xwing : public cGameObject
             ColorSeed = -1;
             memset(ID, 0, ID_LENGTH+1);
             ShowAxes = false;
+            detail = 0;
             createModelDrawables();
         }
         Xwing(char *id)
@@ -66,6 +71,7 @@ class Xwing : public cGameObject
             memset(ID, 0, ID_LENGTH+1);
             setID(id);
             ShowAxes = false;
+            detail = 0;
             createModelDrawables();
         }
         Xwing(int colorSeed)
@@ -75,6 +81,7 @@ class Xwing : public cGameObject
             ColorSeed = colorSeed;
             memset(ID, 0, ID_LENGTH+1);
             ShowAxes = false;
+            detail = 0;
             createModelDrawables();
         }
         Xwing(char *id, int colorSeed)
@@ -85,6 +92,7 @@ class Xwing : public cGameObject
             memset(ID, 0, ID_LENGTH+1);
             setID(id);
             ShowAxes = false;
+            detail = 0;
             createModelDrawables();
         }
 
@@ -99,25 +107,39 @@ class Xwing : public cGameObject
         }
 
         // Draw.
-        void Draw();
+        void Draw() { DrawOpaque(); DrawTranslucent(); }
+
+        // Draw body and axes.
+        void DrawOpaque();
+
+        // Draw blended ID.
+        void DrawTranslucent();
+
+        // Emit thruster exhaust streams.
+        void EmitExhaust(cParticleSystem *particles);
 
         // Show axes?
         void showAxes(bool n) { ShowAxes = n; }
 
-        // Fire plasma bolt.
-        PlasmaBolt *fire()
+        // Level of detail: 0 is the full model.
+        void SetDetail(int d) { detail = d; }
+        int GetDetail() { return(detail); }
+
+        // Fire plasma bolt into set.
+        bool fire(PlasmaBoltSet *plasmaBolts)
         {
-            PlasmaBolt *plasmaBolt;
+            int i;
 
-            if (state != ALIVE) return(NULL);
+            if (state != ALIVE) return(false);
 
-            // Create plasma bolt and move it away from X-wing.
-            plasmaBolt = new PlasmaBolt(m_spacial->x, m_spacial->y, m_spacial->z,
+            // Add plasma bolt and move it away from X-wing.
+            i = plasmaBolts->add(m_spacial->x, m_spacial->y, m_spacial->z,
                 0.5, 1.0, m_spacial->qcalc->quat);
-            plasmaBolt->move();
-            plasmaBolt->setSpeed(m_spacial->speed);
-            plasmaBolt->setSpeedFactor(m_spacial->speedFactor);
-            return(plasmaBolt);
+            if (i == -1) return(false);
+            plasmaBolts->move(i);
+            plasmaBolts->setSpeed(i, m_spacial->speed);
+            plasmaBolts->setSpeedFactor(i, m_spacial->speedFactor);
+            return(true);
         }
 
         // Paint ID on model.
@@ -155,18 +177,20 @@ class Xwing : public cGameObject
 
     private:
 
-        // Create model display lists and color xwing_textures.
-        static GLint display[NUM_DRAWABLES];
-        static GLint explodeDisplay[NUM_EXPLODING_DRAWABLES];
-        static GLint buttDisplay;
+        // Create model mesh and color xwing_textures.
+        // Components are drawn as face ranges of the mesh, at the
+        // mesh level of detail.
+        static cMesh *mesh;
+        static const GLfloat detailCellSize[NUM_XWING_DETAILS - 1];
+        int detail;
+        static int display[NUM_DRAWABLES][2];
+        static int explodeDisplay[NUM_EXPLODING_DRAWABLES][2];
+        static int buttDisplay[2];
         static bool displayInit;
         GLuint textureName[NUM_DRAWABLES];
         GLuint explodeTextureName[NUM_EXPLODING_DRAWABLES];
         void createModelDrawables();
-        void createDisplay(int, int, int);
-
-        // Draw thruster exhaust.
-        void drawExhaust();
+        void createDisplay(int *, int, int);
 
         // ID.
         char ID[ID_LENGTH+1];
@@ -187,6 +211,9 @@ class Xwing : public cGameObject
         static const float maxExplosionAngularVelocity;
         struct XWING_EXPLODING_PART explodingParts[NUM_EXPLODING_DRAWABLES];
         void explosionTransform(int);
+
+        // Transform to X-wing coordinates.
+        void transform();
 };
 
 // States.
@@ -199,28 +226,32 @@ const float Xwing::explosionDelay = 80.0;
 const float Xwing::maxExplosionVelocity = 0.05;
 const float Xwing::maxExplosionAngularVelocity = 3.0;
 
-// Display lists.
-GLint Xwing::display[NUM_DRAWABLES];
-GLint Xwing::explodeDisplay[NUM_EXPLODING_DRAWABLES];
-GLint Xwing::buttDisplay;
+// Mesh and component face ranges.
+cMesh *Xwing::mesh = NULL;
+int Xwing::display[NUM_DRAWABLES][2];
+int Xwing::explodeDisplay[NUM_EXPLODING_DRAWABLES][2];
+int Xwing::buttDisplay[2];
 bool Xwing::displayInit = false;
 
+// Mesh level of detail vertex cluster sizes.
+const GLfloat Xwing::detailCellSize[NUM_XWING_DETAILS - 1] = { 0.05, 0.1 };
+
 // Optimized model.
 #include "xmodelopt.h"
 
-// Create model display lists and color texture maps.
+// Create model mesh and color texture maps.
 void Xwing::createModelDrawables()
 {
     int i,j;
     GLubyte texture[2][2][3];
 
-    // Acquire static display lists.
+    // Build static mesh and its levels of detail.
     if (!displayInit)
     {
-        i = glGenLists(NUM_DRAWABLES);
-        for (j = 0; j < NUM_DRAWABLES; j++, i++) display[j] = i;
-        i = glGenLists(NUM_EXPLODING_DRAWABLES);
-        for (j = 0; j < NUM_EXPLODING_DRAWABLES; j++, i++) explodeDisplay[j] = i;
+        mesh = new cMesh();
+        mesh->build(xwing_face_indicies, sizeof(xwing_face_indicies)/sizeof(xwing_face_indicies[0]),
+            xwing_vertices, xwing_normals, xwing_textures, xwing_material_ref, xwing_SelectMaterial);
+        for (i = 0; i < NUM_XWING_DETAILS - 1; i++) mesh->addLevel(detailCellSize[i]);
     }
 
     // Using random colors?
@@ -303,7 +334,6 @@ void Xwing::createModelDrawables()
     // Use engine cylinder to repair fuselage butt lost during 3dsmax conversion.
     if (!displayInit)
     {
-        buttDisplay = glGenLists(1);
         createDisplay(buttDisplay, CYLINDER01_OFFSET, TUBE07_OFFSET - 1);
     }
 
@@ -379,7 +409,7 @@ void Xwing::createModelDrawables()
         if (!displayInit)
         {
             createDisplay(display[3], LOGO_START, LOGO_END);
-            explodeDisplay[8] = display[3];
+            createDisplay(explodeDisplay[8], LOGO_START, LOGO_END);
         }
     }
 
@@ -388,56 +418,41 @@ void Xwing::createModelDrawables()
 }
 
 
-// Create a display.
-void Xwing::createDisplay(int displayIndex, int startIndex, int endIndex)
+// Create a display: a range of mesh faces.
+void Xwing::createDisplay(int *display, int startIndex, int endIndex)
 {
-    int i,j,vi,ni,ti;
+    display[0] = startIndex;
+    display[1] = endIndex;
+}
 
-    glNewList(displayIndex, GL_COMPILE);
-    glPushAttrib(GL_ALL_ATTRIB_BITS);
-    glPushMatrix();
-    xwing_SelectMaterial(xwing_material_ref[0][0]);
-    glBegin(GL_TRIANGLES);
-    for(i=startIndex;i<=endIndex;i++)
-    {
-        for(j=0;j<3;j++)
-        {
-            vi=xwing_face_indicies[i][j];
-            ni=xwing_face_indicies[i][j+3];       //Normal index
-            ti=xwing_face_indicies[i][j+6];       //Texture index
-            glNormal3f(xwing_normals[ni][0],xwing_normals[ni][1],xwing_normals[ni][2]);
-            glTexCoord2f(xwing_textures[ti][0],xwing_textures[ti][1]);
-            glVertex3f(xwing_vertices[vi][0],xwing_vertices[vi][1],xwing_vertices[vi][2]);
-        }
-    }
-    glEnd();
-    glPopAttrib();
-    glPopMatrix();
-    glEndList();
+
+// Transform to X-wing coordinates.
+void Xwing::transform()
+{
+    glTranslatef(m_spacial->x, m_spacial->y, m_spacial->z);
+    glMultMatrixf(&m_spacial->rotmatrix[0][0]);
+    glScalef(m_spacial->scale, m_spacial->scale, m_spacial->scale);
 }
 
 
-// Draw X-wing.
-void Xwing::Draw()
+// Draw body and axes.
+void Xwing::DrawOpaque()
 {
     int i,j;
 
     glMatrixMode(GL_MODELVIEW);
     glPushMatrix();
-
-    // Transform.
-    glTranslatef(m_spacial->x, m_spacial->y, m_spacial->z);
-    glMultMatrixf(&m_spacial->rotmatrix[0][0]);
-    glScalef(m_spacial->scale, m_spacial->scale, m_spacial->scale);
+    transform();
 
     // Set smooth texture mapping and lighting.
-    glShadeModel(GL_SMOOTH);
-    glDisable(GL_BLEND);
-    glEnable(GL_TEXTURE_2D);
-    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-    glEnable(GL_LIGHTING);
+    cRenderState::shadeModel(GL_SMOOTH);
+    cRenderState::disable(GL_BLEND);
+    cRenderState::enable(GL_TEXTURE_2D);
+    cRenderState::texEnvMode(GL_MODULATE);
+    cRenderState::enable(GL_LIGHTING);
 
     // Draw components.
+    cRenderState::pushAttrib(GL_LIGHTING_BIT);
     if (state == EXPLODE)
         j = NUM_EXPLODING_DRAWABLES;
     else
@@ -448,19 +463,20 @@ void Xwing::Draw()
         if (state == EXPLODE)
         {
             // Add explosion transform to component.
-            glBindTexture(GL_TEXTURE_2D, explodeTextureName[i]);
+            cRenderState::bindTexture(explodeTextureName[i]);
             glPushMatrix();
             explosionTransform(i);
-            glCallList(explodeDisplay[i]);
+            mesh->drawLevel(detail, explodeDisplay[i][0], explodeDisplay[i][1]);
             glPopMatrix();
         }
         else
         {
-            glBindTexture(GL_TEXTURE_2D, textureName[i]);
-            glCallList(display[i]);
+            cRenderState::bindTexture(textureName[i]);
+            mesh->drawLevel(detail, display[i][0], display[i][1]);
         }
 
-        // Draw cylinder to repair fuselage butt.
+        // Draw cylinder to repair fuselage butt, unless too small to see.
+        if (detail == NUM_XWING_DETAILS - 1) continue;
         if ((state == EXPLODE && i == 3) || (state != EXPLODE && i == 1))
         {
             glPushMatrix();
@@ -470,64 +486,81 @@ void Xwing::Draw()
             {
                 glPushMatrix();
                 explosionTransform(1);
-                glCallList(buttDisplay);
+                mesh->drawLevel(detail, buttDisplay[0], buttDisplay[1]);
                 glPopMatrix();
             }
             else
             {
-                glCallList(buttDisplay);
+                mesh->drawLevel(detail, buttDisplay[0], buttDisplay[1]);
             }
             glPopMatrix();
         }
     }
+    cRenderState::popAttrib();
 
-    // Draw thruster exhaust, axes, and ID.
-    if (state != EXPLODE)
-    {
-        drawExhaust();
-        drawAxes();
-        drawID();
-    }
+    // Draw axes.
+    if (state != EXPLODE) drawAxes();
 
     glPopMatrix();
 }
 
 
-// Draw thruster exhaust streams.
-void Xwing::drawExhaust()
+// Draw blended ID.
+void Xwing::DrawTranslucent()
 {
-    int i;
-    GLfloat s,rx,ry,rz;
+    if (state == EXPLODE) return;
+
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    transform();
+
+    // Draw ID.
+    drawID();
+
+    glPopMatrix();
+}
+
+
+// Emit thruster exhaust streams: a frame's streaks from each engine.
+void Xwing::EmitExhaust(cParticleSystem *particles)
+{
+    int i,j;
+    GLfloat s,rx,ry,rz,e,start[3],end[3],p[3];
+    GLubyte color[4];
+    cTransform placement;
+
+    if (state == EXPLODE) return;
 
     // Stream color  depends on speed.
     if (m_spacial->speed == 0.0) return;
     if ((s = m_spacial->speed * 10.0) > 0.5) s = 0.5;
-    glColor4f(2.0 * s, 2.0 * s, 0.75, 0.6);
-
-    // Drawing options: blended streams.
-    glEnable(GL_BLEND);
-    glDisable(GL_TEXTURE_2D);
-    glDisable(GL_LIGHTING);
-    glLineWidth(1.0);
-
-    glBegin(GL_LINES);
-    for (i = 0; i < NUM_EXHAUSTS; i++)
-    {
-        rx = RAND_UNIT;
-        ry = (PRAND_UNIT / 2.0) + 0.5;
-        rz = RAND_UNIT;
-        glVertex3f(.075 + 0.03 * rx, 0.4, (0.03 * rz) - 0.01);
-        glVertex3f(.075 + 0.01 * rx, 0.4 + (s * ry), (0.01 * rz) - 0.01);
-    }
-    for (i = 0; i < NUM_EXHAUSTS; i++)
+    color[0] = color[1] = (GLubyte)(2.0 * s * 255.0);
+    color[2] = (GLubyte)(0.75 * 255.0);
+    color[3] = (GLubyte)(0.6 * 255.0);
+
+    // Streams are in X-wing coordinates.
+    placement.translate(m_spacial->x, m_spacial->y, m_spacial->z);
+    placement.multiply(&m_spacial->rotmatrix[0][0]);
+    placement.scale(m_spacial->scale, m_spacial->scale, m_spacial->scale);
+    for (j = 0; j < 2; j++)
     {
-        rx = RAND_UNIT;
-        ry = (PRAND_UNIT / 2.0) + 0.5;
-        rz = RAND_UNIT;
-        glVertex3f(-.075 + 0.03 * rx, 0.4, (0.03 * rz) - 0.01);
-        glVertex3f(-.075 + 0.01 * rx, 0.4 + (s * ry), (0.01 * rz) - 0.01);
+        e = (j == 0) ? .075 : -.075;
+        for (i = 0; i < NUM_EXHAUSTS; i++)
+        {
+            rx = particles->randomUnit();
+            ry = (particles->randomPositive() / 2.0) + 0.5;
+            rz = particles->randomUnit();
+            p[0] = e + 0.03 * rx;
+            p[1] = 0.4;
+            p[2] = (0.03 * rz) - 0.01;
+            placement.transformPoint(p, start);
+            p[0] = e + 0.01 * rx;
+            p[1] = 0.4 + (s * ry);
+            p[2] = (0.01 * rz) - 0.01;
+            placement.transformPoint(p, end);
+            particles->addStreak(start, end, color);
+        }
     }
-    glEnd();
 }
 
 
@@ -548,12 +581,12 @@ void Xwing::drawID()
 
     // Drawing options.
     glColor3f(IDred, IDgreen, IDblue);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glEnable(GL_BLEND);
-    glEnable(GL_LINE_SMOOTH);
-    glDisable(GL_TEXTURE_2D);
-    glDisable(GL_LIGHTING);
-    glLineWidth(1.0);
+    cRenderState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    cRenderState::enable(GL_BLEND);
+    cRenderState::enable(GL_LINE_SMOOTH);
+    cRenderState::disable(GL_TEXTURE_2D);
+    cRenderState::disable(GL_LIGHTING);
+    cRenderState::lineWidth(1.0);
 
     // Draw ID.
     while (*s)
@@ -577,10 +610,10 @@ void Xwing::drawAxes()
     f = .05;
 
     // Set drawing options.
-    glDisable(GL_BLEND);
-    glDisable(GL_TEXTURE_2D);
-    glDisable(GL_LIGHTING);
-    glLineWidth(1.0);
+    cRenderState::disable(GL_BLEND);
+    cRenderState::disable(GL_TEXTURE_2D);
+    cRenderState::disable(GL_LIGHTING);
+    cRenderState::lineWidth(1.0);
 
     // Draw axes.
     glColor3f(1.0, 0.0, 0.0);